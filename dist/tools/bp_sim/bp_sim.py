@@ -0,0 +1,372 @@
+#! /usr/bin/env python3
+
+#
+# Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+#
+
+"""
+bp_sim
+
+Multi-node simulation of the bundle protocol on native.
+
+Description
+-----------
+
+Starts one instance of tests/gnrc_bp_sim per node, each with a socket_zep
+interface connected to a ZEP dispatcher run by this script. The dispatcher
+relays every frame of a node to the nodes it currently has a contact with, so
+links come up and go down as given by a schedule. The schedule also injects
+the traffic. When the schedule ends the `#*#*` statistics of every node, the
+delivery ratio, the latency and the overhead of the run are summarized.
+
+Schedule
+--------
+
+One event per line, `#` starts a comment. Times are seconds since the start
+of the simulation.
+
+    <time> nodes <n>                 number of nodes, must come first
+    <time> up <a> <b> [<loss>]       contact between a and b, frames are lost
+                                     with probability loss (default 0)
+    <time> down <a> <b>              contact between a and b ends
+    <time> send <src> <dst> <len> [<count> [<interval>]]
+                                     src sends count payloads of len bytes to
+                                     dst, one every interval seconds
+    <time> end                       end of the simulation
+
+Node numbers start at 1 and are used as ipn node numbers.
+
+Usage
+-----
+
+    make -C tests/gnrc_bp_sim all
+    dist/tools/bp_sim/bp_sim.py dist/tools/bp_sim/schedules/line.txt
+"""
+
+import argparse
+import csv
+import os
+import random
+import socket
+import statistics
+import subprocess
+import sys
+import threading
+import time
+
+RIOTBASE = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..', '..'))
+DEFAULT_ELF = os.path.join(RIOTBASE, 'tests', 'gnrc_bp_sim', 'bin', 'native',
+                           'tests_gnrc_bp_sim.elf')
+
+STATS_MARKER = '#*#*'
+# fields of the print_network_statistics() line after the marker
+STATS_FIELDS = ['time', 'stored', 'sent', 'received', 'forwarded',
+                'retransmitted', 'delivered', 'acks_sent', 'acks_received',
+                'discovery_sent', 'discovery_received']
+
+
+class Schedule(object):
+    """Events of a schedule file, ordered by time"""
+
+    def __init__(self, path):
+        self.nodes = 0
+        self.end = None
+        self.events = []
+        with open(path) as f:
+            for lineno, line in enumerate(f, 1):
+                line = line.split('#', 1)[0].split()
+                if not line:
+                    continue
+                try:
+                    self._parse(float(line[0]), line[1], line[2:])
+                except (IndexError, ValueError) as exc:
+                    raise ValueError('{}:{}: invalid event ({})'
+                                     .format(path, lineno, exc))
+        if self.nodes < 2:
+            raise ValueError('{}: at least two nodes are needed'.format(path))
+        if self.end is None:
+            self.end = max([e[0] for e in self.events] + [0]) + 30
+        self.events.sort(key=lambda e: e[0])
+
+    def _parse(self, at, event, args):
+        if event == 'nodes':
+            self.nodes = int(args[0])
+        elif event == 'end':
+            self.end = at
+        elif event in ('up', 'down'):
+            a, b = int(args[0]), int(args[1])
+            self._check_node(a)
+            self._check_node(b)
+            loss = float(args[2]) if event == 'up' and len(args) > 2 else 0.0
+            self.events.append((at, event, (a, b, loss)))
+        elif event == 'send':
+            src, dst, length = int(args[0]), int(args[1]), int(args[2])
+            self._check_node(src)
+            self._check_node(dst)
+            count = int(args[3]) if len(args) > 3 else 1
+            interval = float(args[4]) if len(args) > 4 else 1.0
+            for i in range(count):
+                self.events.append((at + i * interval, event, (src, dst, length)))
+        else:
+            raise ValueError('unknown event "{}"'.format(event))
+
+    def _check_node(self, node):
+        if not 1 <= node <= self.nodes:
+            raise ValueError('node {} out of 1..{}'.format(node, self.nodes))
+
+
+class Dispatcher(threading.Thread):
+    """ZEP relay forwarding frames along the contacts that are currently up"""
+
+    def __init__(self, addr, port, port_base, nodes, seed):
+        super().__init__(daemon=True)
+        self.sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        self.sock.bind((addr, port))
+        self.sock.settimeout(0.2)
+        self.addr = addr
+        self.port_base = port_base
+        self.nodes = nodes
+        self.random = random.Random(seed)
+        self.lock = threading.Lock()
+        self.links = {}
+        self.frames_sent = [0] * (nodes + 1)
+        self.bytes_sent = [0] * (nodes + 1)
+        self.frames_delivered = 0
+        self.frames_lost = 0
+        self.running = True
+
+    def node_port(self, node):
+        return self.port_base + node - 1
+
+    def set_link(self, a, b, up, loss=0.0):
+        with self.lock:
+            for key in ((a, b), (b, a)):
+                if up:
+                    self.links[key] = loss
+                else:
+                    self.links.pop(key, None)
+
+    def run(self):
+        while self.running:
+            try:
+                data, src = self.sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            node = src[1] - self.port_base + 1
+            if not 1 <= node <= self.nodes:
+                continue
+            self.frames_sent[node] += 1
+            self.bytes_sent[node] += len(data)
+            with self.lock:
+                targets = [(b, loss) for (a, b), loss in self.links.items()
+                           if a == node]
+            for dst, loss in targets:
+                if loss > 0 and self.random.random() < loss:
+                    self.frames_lost += 1
+                    continue
+                self.frames_delivered += 1
+                self.sock.sendto(data, (self.addr, self.node_port(dst)))
+
+    def stop(self):
+        self.running = False
+        self.join()
+        self.sock.close()
+
+
+class Node(object):
+    """One native instance, its output is parsed on a reader thread"""
+
+    def __init__(self, sim, num, elf, zep, logdir):
+        self.sim = sim
+        self.num = num
+        self.stats = []
+        self.log = open(os.path.join(logdir, 'node-{}.log'.format(num)), 'w') \
+            if logdir else None
+        self.proc = subprocess.Popen([elf, '-z', zep], stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT,
+                                     universal_newlines=True, errors='replace',
+                                     bufsize=1)
+        self.reader = threading.Thread(target=self._read, daemon=True)
+        self.reader.start()
+        self.command('node {}'.format(num))
+
+    def command(self, line):
+        self.proc.stdin.write(line + '\n')
+        self.proc.stdin.flush()
+
+    def _read(self):
+        for line in self.proc.stdout:
+            now = self.sim.now()
+            if self.log:
+                self.log.write('{:.3f} {}'.format(now, line))
+            if STATS_MARKER in line:
+                fields = line[line.index(STATS_MARKER):].split(',')[1:]
+                values = [int(v) for v in fields if v.strip()]
+                if len(values) == len(STATS_FIELDS):
+                    self.stats.append(values)
+            elif 'bpsim: rx ' in line:
+                src, seq, _ = line.split('bpsim: rx ', 1)[1].split()[:3]
+                self.sim.delivered(int(src), self.num, int(seq), now)
+
+    def stop(self):
+        if self.proc.poll() is None:
+            self.proc.terminate()
+            try:
+                self.proc.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+        self.reader.join(timeout=5)
+        if self.log:
+            self.log.close()
+
+
+class Simulation(object):
+
+    def __init__(self, args, schedule):
+        self.args = args
+        self.schedule = schedule
+        self.start = time.monotonic()
+        self.lock = threading.Lock()
+        # (src, seq) -> [dst, length, sent at, delivered at]
+        self.bundles = {}
+        self.seq = [0] * (schedule.nodes + 1)
+        self.dispatcher = Dispatcher(args.addr, args.port, args.port_base,
+                                     schedule.nodes, args.seed)
+        self.nodes = {}
+
+    def now(self):
+        return time.monotonic() - self.start
+
+    def delivered(self, src, dst, seq, at):
+        with self.lock:
+            bundle = self.bundles.get((src, seq))
+            if bundle is not None and bundle[0] == dst and bundle[3] is None:
+                bundle[3] = at
+
+    def run(self):
+        self.dispatcher.start()
+        try:
+            for num in range(1, self.schedule.nodes + 1):
+                zep = '[{}]:{},[{}]:{}'.format(
+                    self.args.addr, self.dispatcher.node_port(num),
+                    self.args.addr, self.args.port)
+                self.nodes[num] = Node(self, num, self.args.elf, zep,
+                                       self.args.logdir)
+            self.start = time.monotonic()
+            for at, event, args in self.schedule.events:
+                if at > self.schedule.end:
+                    break
+                delay = at - self.now()
+                if delay > 0:
+                    time.sleep(delay)
+                self._apply(event, args)
+            delay = self.schedule.end - self.now()
+            if delay > 0:
+                time.sleep(delay)
+        finally:
+            for node in self.nodes.values():
+                node.stop()
+            self.dispatcher.stop()
+
+    def _apply(self, event, args):
+        if event == 'up':
+            self.dispatcher.set_link(args[0], args[1], True, args[2])
+        elif event == 'down':
+            self.dispatcher.set_link(args[0], args[1], False)
+        elif event == 'send':
+            src, dst, length = args
+            self.seq[src] += 1
+            with self.lock:
+                self.bundles[(src, self.seq[src])] = [dst, length, self.now(), None]
+            self.nodes[src].command('send {} {} {}'.format(dst, self.seq[src],
+                                                           length))
+
+    def summary(self):
+        lines = []
+        lines.append('node,' + ','.join(STATS_FIELDS))
+        totals = [0] * len(STATS_FIELDS)
+        for num, node in sorted(self.nodes.items()):
+            last = node.stats[-1] if node.stats else [0] * len(STATS_FIELDS)
+            lines.append('{},{}'.format(num, ','.join(str(v) for v in last)))
+            totals = [t + v for t, v in zip(totals, last)]
+        lines.append('total,-,' + ','.join(str(v) for v in totals[1:]))
+
+        sent = len(self.bundles)
+        latencies = sorted(b[3] - b[2] for b in self.bundles.values()
+                           if b[3] is not None)
+        delivered = len(latencies)
+        stats = dict(zip(STATS_FIELDS, totals))
+        transmissions = stats['sent'] + stats['forwarded'] + stats['retransmitted']
+        lines.append('')
+        lines.append('payloads sent:       {}'.format(sent))
+        lines.append('payloads delivered:  {}'.format(delivered))
+        lines.append('delivery ratio:      {:.3f}'.format(
+            delivered / sent if sent else 0))
+        if latencies:
+            lines.append('latency [s]:         min {:.3f} median {:.3f} '
+                         'mean {:.3f} max {:.3f}'.format(
+                             latencies[0], statistics.median(latencies),
+                             statistics.mean(latencies), latencies[-1]))
+        frames = sum(self.dispatcher.frames_sent)
+        lines.append('bundle transmissions per delivery: {}'.format(
+            '{:.2f}'.format(transmissions / delivered) if delivered else '-'))
+        lines.append('frames on air:       {} ({} bytes, {} lost)'.format(
+            frames, sum(self.dispatcher.bytes_sent),
+            self.dispatcher.frames_lost))
+        lines.append('frames per delivery: {}'.format(
+            '{:.2f}'.format(frames / delivered) if delivered else '-'))
+        return '\n'.join(lines)
+
+    def write_csv(self, path):
+        with open(path, 'w') as f:
+            writer = csv.writer(f)
+            writer.writerow(['node'] + STATS_FIELDS)
+            for num, node in sorted(self.nodes.items()):
+                for row in node.stats:
+                    writer.writerow([num] + row)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run a multi-node bundle protocol simulation on native')
+    parser.add_argument('schedule', help='contact and traffic schedule')
+    parser.add_argument('--elf', default=DEFAULT_ELF,
+                        help='node application (default: %(default)s)')
+    parser.add_argument('--addr', default='::1',
+                        help='address of the dispatcher and the nodes')
+    parser.add_argument('--port', type=int, default=17754,
+                        help='port of the dispatcher')
+    parser.add_argument('--port-base', type=int, default=17760,
+                        help='port of node 1, node n uses port-base + n - 1')
+    parser.add_argument('--seed', type=int, default=1,
+                        help='seed of the frame loss')
+    parser.add_argument('--logdir', help='write the output of every node here')
+    parser.add_argument('--csv', help='write all statistics lines to this file')
+    args = parser.parse_args()
+
+    try:
+        schedule = Schedule(args.schedule)
+    except (OSError, ValueError) as exc:
+        sys.exit(str(exc))
+    if not os.path.exists(args.elf):
+        sys.exit('{} not found, build tests/gnrc_bp_sim first'.format(args.elf))
+    if args.logdir:
+        os.makedirs(args.logdir, exist_ok=True)
+
+    sim = Simulation(args, schedule)
+    try:
+        sim.run()
+    except KeyboardInterrupt:
+        pass
+    print(sim.summary())
+    if args.csv:
+        sim.write_csv(args.csv)
+
+
+if __name__ == '__main__':
+    main()
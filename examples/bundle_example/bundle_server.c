@@ -19,6 +19,8 @@
 #include "timex.h"
 #include "utlist.h"
 #include "msg.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
 #include "xtimer.h"
 
 int bundle_cmd(int argc, char **argv)
@@ -29,17 +31,31 @@ int bundle_cmd(int argc, char **argv)
     }
 
     if (strcmp(argv[1], "send") == 0) {
-      if (argc < 5) {
-          printf("usage: %s send <addr> <port> <data> <data_len>\n",
+      if (argc < 6) {
+          printf("usage: %s send <addr> <port> <data> <data_len> [bulk|normal|expedited]\n",
                  argv[0]);
           return 1;
       }
-      send_bundle((uint8_t *)argv[4], atoi(argv[5]),argv[2], "1", NOCRC, DUMMY_PAYLOAD_LIFETIME);
+      uint8_t priority = BUNDLE_PRIORITY_NORMAL;
+      if (argc > 6) {
+          priority = (strcmp(argv[6], "expedited") == 0) ? BUNDLE_PRIORITY_EXPEDITED :
+                     (strcmp(argv[6], "bulk") == 0) ? BUNDLE_PRIORITY_BULK : BUNDLE_PRIORITY_NORMAL;
+      }
+      if (send_bundle((uint8_t *)argv[4], atoi(argv[5]),argv[2], "1", NOCRC, DUMMY_PAYLOAD_LIFETIME, priority) < 0) {
+          puts("error: could not send bundle");
+          return 1;
+      }
     }
     else if (strcmp(argv[1], "receive") == 0) {
       msg_t msg;
-      int res = msg_try_receive(&msg);
-      printf("received message with data = %s with res = %d.\n", (char *)msg.content.ptr, res);
+      if (msg_try_receive(&msg) < 1 || msg.type != GNRC_NETAPI_MSG_TYPE_RCV) {
+          puts("no bundle received");
+          return 1;
+      }
+      /* the payload is not null terminated */
+      gnrc_pktsnip_t *payload = msg.content.ptr;
+      printf("received message with data = %.*s.\n", (int)payload->size, (char *)payload->data);
+      gnrc_pktbuf_release(payload);
     }
     else {
         puts("error: invalid command");
@@ -48,8 +48,8 @@ int main(void)
     msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
     puts("Bundle network stack example application");
 
-    /*Initialize the bundle protocol with pid 9 (pid of network driver)*/
-    bundle_protocol_init(9);
+    /*Initialize the bundle protocol on all network interfaces*/
+    bundle_protocol_init();
 
     register_application(1234, thread_getpid());
     set_registration_state(1234, REGISTRATION_PASSIVE);
@@ -14,6 +14,8 @@ PSEUDOMODULES += ecc_%
 PSEUDOMODULES += emb6_router
 PSEUDOMODULES += event_%
 PSEUDOMODULES += fmt_%
+PSEUDOMODULES += gnrc_contact_scheduler_periodic
+PSEUDOMODULES += gnrc_contact_scheduler_trickle
 PSEUDOMODULES += gnrc_dhcpv6_%
 PSEUDOMODULES += gnrc_ipv6_default
 PSEUDOMODULES += gnrc_ipv6_ext_frag_stats
@@ -74,6 +76,10 @@ PSEUDOMODULES += prng
 PSEUDOMODULES += prng_%
 PSEUDOMODULES += qmc5883l_int
 PSEUDOMODULES += riotboot_%
+PSEUDOMODULES += routing_cgr
+PSEUDOMODULES += routing_epidemic
+PSEUDOMODULES += routing_prophet
+PSEUDOMODULES += routing_spray_and_wait
 PSEUDOMODULES += saul_adc
 PSEUDOMODULES += saul_default
 PSEUDOMODULES += saul_gpio
@@ -109,10 +109,26 @@
 #include "net/gnrc/bundle_protocol/contact_scheduler_periodic.h"
 #endif
 
+#ifdef MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE
+#include "net/gnrc/bundle_protocol/contact_scheduler_trickle.h"
+#endif
+
 #ifdef MODULE_ROUTING_EPIDEMIC
 #include "net/gnrc/bundle_protocol/routing_epidemic.h"
 #endif
 
+#ifdef MODULE_ROUTING_PROPHET
+#include "net/gnrc/bundle_protocol/routing_prophet.h"
+#endif
+
+#ifdef MODULE_ROUTING_CGR
+#include "net/gnrc/bundle_protocol/routing_cgr.h"
+#endif
+
+#ifdef MODULE_ROUTING_SPRAY_AND_WAIT
+#include "net/gnrc/bundle_protocol/routing_spray_and_wait.h"
+#endif
+
 #ifdef MODULE_TEST_UTILS_INTERACTIVE_SYNC
 #if !defined(MODULE_SHELL_COMMANDS) || !defined(MODULE_SHELL)
 #include "test_utils/interactive_sync.h"
@@ -167,10 +183,26 @@ void auto_init(void)
     DEBUG("Auto init gnrc_contact_scheduler_periodic module.\n");
     gnrc_contact_scheduler_periodic_init();
 #endif
+#ifdef MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE
+    DEBUG("Auto init gnrc_contact_scheduler_trickle module.\n");
+    gnrc_contact_scheduler_trickle_init();
+#endif
 #ifdef MODULE_ROUTING_EPIDEMIC
     DEBUG("Auto init routing_epidemic module.\n");
     routing_epidemic_init();
 #endif
+#ifdef MODULE_ROUTING_PROPHET
+    DEBUG("Auto init routing_prophet module.\n");
+    routing_prophet_init();
+#endif
+#ifdef MODULE_ROUTING_CGR
+    DEBUG("Auto init routing_cgr module.\n");
+    routing_cgr_init();
+#endif
+#ifdef MODULE_ROUTING_SPRAY_AND_WAIT
+    DEBUG("Auto init routing_spray_and_wait module.\n");
+    routing_spray_and_wait_init();
+#endif
 #ifdef MODULE_GNRC_IPV6
     DEBUG("Auto init gnrc_ipv6 module.\n");
     gnrc_ipv6_init();
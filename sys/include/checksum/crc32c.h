@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_checksum_crc32c CRC32C
+ * @ingroup     sys_checksum
+ *
+ * @brief       CRC-32C (Castagnoli) checksum algorithm
+ * @details     CRC-32C as used by the bundle protocol, iSCSI and SCTP
+ *              (reflected polynomial 0x82F63B78, initial value and final
+ *              XOR 0xFFFFFFFF).
+ *
+ *              The implementation is chosen at compile time, trading
+ *              flash for speed:
+ *
+ *              - `CONFIG_CRC32C_NO_TABLE`: bit-at-a-time, no look-up table
+ *              - `CONFIG_CRC32C_SMALL_TABLE`: 16 entry (64 byte) look-up
+ *                table, two look-ups per byte
+ *              - default: 256 entry (1 KiB) look-up table
+ *              - `CONFIG_CRC32C_SLICE_BY_8`: eight 256 entry (8 KiB) look-up
+ *                tables, processing eight bytes per iteration
+ *
+ *              On the native board the SSE4.2 `crc32` instruction is used
+ *              instead whenever the host CPU supports it.
+ *
+ *              The checksum can be computed incrementally: pass the result
+ *              of a previous call to crc32c_update() (or @ref CRC32C_INIT for
+ *              the first chunk) to continue the calculation over the next
+ *              chunk of data.
+ *
+ * @{
+ * @file
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ */
+
+#ifndef CHECKSUM_CRC32C_H
+#define CHECKSUM_CRC32C_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Start value for an incremental CRC32C calculation
+ */
+#define CRC32C_INIT         (0x00000000UL)
+
+/**
+ * @brief           Update CRC32C
+ *
+ * @param[in]  crc  CRC32C of the preceding data, i.e. the return value of a
+ *                  previous call to crc32c_update() or crc32c_calc(), or
+ *                  @ref CRC32C_INIT
+ * @param[in]  buf  Start of the memory area to checksum
+ * @param[in]  len  Number of bytes to checksum
+ *
+ * @return          Checksum of the preceding data followed by the specified
+ *                  memory area
+ */
+uint32_t crc32c_update(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * @brief           Calculate CRC32C
+ *
+ * @param[in]  buf  Start of the memory area to checksum
+ * @param[in]  len  Number of bytes to checksum
+ *
+ * @return          Checksum of the specified memory area
+ */
+static inline uint32_t crc32c_calc(const void *buf, size_t len)
+{
+    return crc32c_update(CRC32C_INIT, buf, len);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKSUM_CRC32C_H */
+
+/** @} */
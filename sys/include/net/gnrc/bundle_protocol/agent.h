@@ -14,16 +14,18 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <math.h>
 
+#include "iolist.h"
 #include "thread.h"
 #include "net/gnrc.h"
 #include "net/gnrc/netif.h"
+#include "net/gnrc/bundle_protocol/bundle_fragment.h"
 
 #define REGISTRATION_ACTIVE 0x01
 #define REGISTRATION_PASSIVE 0x02
 #define NOT_REGISTERED 0x00
 
+/* Statistics types passed to update_statistics(), counted in bp_metrics */
 #define BUNDLE_DELIVERY 0x01
 #define BUNDLE_RECEIVE 0x02
 #define BUNDLE_SEND 0x03
@@ -33,29 +35,36 @@
 #define ACK_RECEIVE 0x07
 #define DISCOVERY_BUNDLE_RECEIVE 0x08
 #define DISCOVERY_BUNDLE_SEND 0x09
+#define SUMMARY_SEND 0x0A
+#define SUMMARY_RECEIVE 0x0B
+#define BUNDLE_REFUSE 0x0C
 
 struct registration_status {
 	uint32_t service_num;
 	uint8_t status;
 	kernel_pid_t pid;
+	/* Receives payloads piece by piece instead of messages to pid if set */
+	bundle_payload_write_t sink;
+	void *sink_arg;
 	struct registration_status *next;
 };
 
-struct statistics {
-	int bundles_delivered;
-	int bundles_received;
-	int bundles_forwarded;
-	int bundles_retransmitted;
-	int bundles_sent;
-	int acks_sent;
-	int acks_received;
-	int discovery_bundle_sent;
-	int discovery_bundle_receive;
-};
-
-void bundle_protocol_init(kernel_pid_t pid);
-void send_bundle(uint8_t *payload_data, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime);
+void bundle_protocol_init(void);
+/*
+ * priority is one of the BUNDLE_PRIORITY_ classes of bundle.h. Returns OK once the bundle, or all of
+ * its fragments, were handed to the BP thread and ERROR otherwise.
+ */
+int send_bundle(uint8_t *payload_data, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority);
+int send_bundle_iolist(const iolist_t *payload, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority);
+/*
+ * Sends data_len payload bytes pulled from read while the bundle, or its fragments, are being sent.
+ * Fails before the first fragment is sent if the storage has no room for all of them.
+ */
+int send_bundle_stream(bundle_payload_read_t read, void *arg, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority);
+/* Payloads are sent to pid as packet buffer snips it has to release, see deliver_bundle() */
 bool register_application(uint32_t service_num, kernel_pid_t pid);
+/* Registers an application receiving its payloads through sink, without a size limit on fragmented payloads */
+bool register_application_sink(uint32_t service_num, kernel_pid_t pid, bundle_payload_write_t sink, void *sink_arg);
 bool set_registration_state(uint32_t service_num, uint8_t state);
 uint8_t get_registration_status(uint32_t service_num);
 struct registration_status *get_registration (uint32_t service_num);
@@ -23,9 +23,12 @@
 #include "nanocbor/nanocbor.h"
 #include "fmt.h"
 #include "xtimer.h"
+#include "net/gnrc/pkt.h"
 
 #define DUMMY_EID "test"
+#ifndef DUMMY_SRC_NUM
 #define DUMMY_SRC_NUM "01"
+#endif
 #define BROADCAST_EID "11111111"
 #define INVALID_EID  0xFFFFFFFF 
 
@@ -39,11 +42,15 @@
 #define BUNDLE_BLOCK_TYPE_PRIMARY 0x88
 #define BUNDLE_BLOCK_TYPE_CANONICAL 0x89
 
-//Bundle type codes
+//Bundle type codes, as assigned by RFC 9171
 #define BUNDLE_BLOCK_TYPE_PAYLOAD 0x01
-#define BUNDLE_BLOCK_TYPE_PREVIOUS_NODE 0x07
-#define BUNDLE_BLOCK_TYPE_HOP_COUNT 0x09
-#define BUNDLE_BLOCK_TYPE_BUNDLE_AGE 0x08
+#define BUNDLE_BLOCK_TYPE_PREVIOUS_NODE 0x06
+#define BUNDLE_BLOCK_TYPE_BUNDLE_AGE 0x07
+#define BUNDLE_BLOCK_TYPE_HOP_COUNT 0x0A
+// routing data of discovery bundles, from the block types reserved for private use
+#define BUNDLE_BLOCK_TYPE_ROUTING 0xC0
+// copies a spray and wait receiver may hand out, also private use
+#define BUNDLE_BLOCK_TYPE_COPY_COUNT 0xC1
 
 //Retention constraints
 #define DISPATCH_PENDING_RETENTION_CONSTRAINT 0x01
@@ -57,19 +64,42 @@
 #define CRC_16 0x01
 #define CRC_32 0x02
 
-#define CRC16_FUNCTION 0x1021
-#define CRC32_FUNCTION 0x1EDC6F41
+// CRC-16 is CRC-16/CCITT-FALSE (poly 0x1021), CRC-32 is CRC-32C (Castagnoli)
+#define CRC16_INIT 0xFFFF
 
 #define FRAGMENT_IDENTIFICATION_MASK 0x0000000000000001
+#define BUNDLE_DONT_FRAGMENT_MASK 0x0000000000000004
+/*
+ * Class of service in bits 7 and 8 of the primary block flags, where RFC 5050 had it. BPv7 left
+ * these bits unassigned, bundles of nodes without priorities are bulk.
+ */
+#define BUNDLE_PRIORITY_MASK 0x0000000000000180
+#define BUNDLE_PRIORITY_SHIFT 7
 
+// Priority classes, in order
+#define BUNDLE_PRIORITY_BULK 0
+#define BUNDLE_PRIORITY_NORMAL 1
+#define BUNDLE_PRIORITY_EXPEDITED 2
+#define BUNDLE_PRIORITY_CLASSES 3
+
+// Largest block data, the chunk size of the largest class of the block pool
+#ifndef BLOCK_DATA_BUF_SIZE
 #define BLOCK_DATA_BUF_SIZE 100
-#define MAX_ACK_SIZE 70
-#define DUMMY_PAYLOAD_LIFETIME 100000000
-#define ACK_IDENTIFIER_SIZE 3
+#endif
+// Bundle age block data, a CBOR uint with a 4 byte argument so that it can be patched in place
+#define BUNDLE_AGE_DATA_LEN 5
+// Hop count block data, the CBOR array [hop limit, hop count] with 1 byte arguments
+#define BUNDLE_HOP_COUNT_DATA_LEN 5
+// Lifetime and age are in ms
+#define DUMMY_PAYLOAD_LIFETIME 100000
 
 #define IPN_IDENTIFIER_SIZE 6
 
-#define MAX_NUM_OF_BLOCKS 3
+//Largest possible CBOR head (initial byte followed by a 64 bit argument)
+#define CBOR_HEAD_MAX_LEN 9
+
+// Payload, bundle age, hop count and one routing block
+#define MAX_NUM_OF_BLOCKS 4
 #define MAX_ENDPOINT_SIZE 32
 
 //Primary block defines
@@ -137,7 +167,8 @@ struct bundle_canonical_block_t{
   uint8_t block_number;
   uint64_t flags;
   uint8_t crc_type;
-  uint8_t block_data[BLOCK_DATA_BUF_SIZE];
+  /* Either a chunk of the block pool or a view into the packet the bundle was decoded from */
+  uint8_t *block_data;
   uint32_t crc;
   size_t data_len;
   struct bundle_canonical_block_t* next;
@@ -147,22 +178,72 @@ struct actual_bundle{
   struct bundle_primary_block_t primary_block;
   struct bundle_canonical_block_t other_blocks[MAX_NUM_OF_BLOCKS];
   int num_of_blocks;
+  /* When the bundle reached this node, in ms of uptime */
   uint32_t local_creation_time;
+  /* When the bundle was last sent to a neighbor, 0 if never, for the ack round trip time */
+  uint32_t last_send_time;
+  /* Next retransmission in ms of uptime, 0 if none is scheduled */
+  uint32_t retx_deadline;
+  /* Retransmissions so far, the convergence layer stops retransmitting once a neighbor acked it */
+  uint8_t retx_count;
+  /* Copies this node may still hand out with spray and wait routing, 0 until the router looked at it */
+  uint16_t copies;
   uint8_t retention_constraint;
   uint32_t previous_endpoint_num;
+  /* Received packet held for as long as the bundle references it, NULL for local bundles */
+  gnrc_pktsnip_t *pkt;
+  /* Encoded image sent to neighbors, from the first transmission until an encoded field changes */
+  gnrc_pktsnip_t *wire;
+  /* Offset and encoded length of the bundle age block in wire, 0 if it has none */
+  uint16_t wire_age_at;
+  uint8_t wire_age_len;
+};
+
+/* Identifies a bundle or fragment across nodes, only for IPN endpoints */
+struct bundle_id {
+  uint32_t src_num;
+  uint32_t creation_timestamp[2];
+  uint32_t fragment_offset;
+  uint32_t total_application_data_length;
 };
 
 bool is_same_bundle(struct actual_bundle* current_bundle, struct actual_bundle* compare_to_bundle);
-uint16_t calculate_crc_16(uint8_t type, void *block);
-uint32_t calculate_crc_32(uint8_t type, void *block);
-bool verify_checksum(void *block, uint8_t type, uint32_t crc);
+bool bundle_is_fragment(struct actual_bundle* bundle);
+/* The reserved fourth class is taken as normal */
+uint8_t bundle_get_priority(struct actual_bundle* bundle);
+void bundle_set_priority(struct actual_bundle* bundle, uint8_t priority);
 void calculate_primary_flag(uint64_t *flag, bool is_fragment, bool dont_fragment);
 int calculate_canonical_flag(uint64_t *flag, bool replicate_block);
 
 struct actual_bundle* create_bundle(void);
+/* Bundle in a slot kept for discovery beacons, which never purges another bundle */
+struct actual_bundle* create_discovery_bundle(void);
 int fill_bundle(struct actual_bundle* bundle, int version, uint8_t endpoint_scheme, char* dest_eid, char* report_eid, uint32_t lifetime, int crc_type, char* service_num);
+void bundle_skip_sequence_num(uint32_t seq);
 int bundle_encode(struct actual_bundle* bundle, nanocbor_encoder_t *enc);
+size_t bundle_encoded_len_max(struct actual_bundle* bundle);
+size_t bundle_encoded_len(struct actual_bundle* bundle);
+gnrc_pktsnip_t *bundle_encode_pkt(struct actual_bundle* bundle, gnrc_nettype_t type);
+/*
+ * Encoded stored bundle to send, with a reference for the caller. Encoded once and kept with the
+ * bundle, later calls only write the current age into the image.
+ */
+gnrc_pktsnip_t *bundle_wire_pkt(struct actual_bundle* bundle);
+/* Drops the image of bundle_wire_pkt(), has to be called whenever an encoded field changes */
+void bundle_wire_invalidate(struct actual_bundle* bundle);
 int bundle_decode(struct actual_bundle* bundle, uint8_t *buffer, size_t buf_len);
+int bundle_decode_pkt(struct actual_bundle* bundle, gnrc_pktsnip_t *pkt);
+void bundle_release_pkt(struct actual_bundle* bundle);
+/* Returns the block data of all blocks to the block pool, the bundle has no blocks afterwards */
+void bundle_release_blocks(struct actual_bundle* bundle);
+void bundle_get_id(struct actual_bundle* bundle, struct bundle_id *id);
+int bundle_peek_id(const uint8_t *buffer, size_t buf_len, struct bundle_id *id);
+/* Priority class of an encoded bundle without decoding it, ERROR if it is malformed */
+int bundle_peek_priority(const uint8_t *buffer, size_t buf_len);
+/* Destination service number of an encoded ipn bundle without decoding it, ERROR otherwise */
+int bundle_peek_service(const uint8_t *buffer, size_t buf_len, uint32_t *service_num);
+/* Hop limit and count of an encoded bundle without decoding it, ERROR if it has no hop count block */
+int bundle_peek_hop_count(const uint8_t *buffer, size_t buf_len, uint32_t *hop_limit, uint32_t *hop_count);
 int encode_primary_block(struct actual_bundle *bundle, nanocbor_encoder_t *enc);
 int encode_canonical_block(struct bundle_canonical_block_t *canonical_block, nanocbor_encoder_t *enc);
 
@@ -172,20 +253,40 @@ struct bundle_canonical_block_t* get_block_by_type(struct actual_bundle* bundle,
 
 //main api to be used to add blocks to bundle
 int bundle_add_block(struct actual_bundle* bundle, uint8_t type, uint64_t flags, uint8_t *data, uint8_t crc_type, size_t data_len);
+/*
+ * Copies len bytes of data into a chunk of the block pool held by the block, which is only
+ * reallocated if it is too small. data may be NULL to fill the block data in place afterwards.
+ * Older bundles are only purged for the chunk in the BP thread, see bundle_storage_set_purge_pid().
+ */
+int bundle_block_set_data(struct actual_bundle* bundle, struct bundle_canonical_block_t *block, const uint8_t *data, size_t len);
+/*
+ * Like bundle_block_set_data(), but fails instead of purging other bundles when the block pool is
+ * exhausted. Used for blocks rewritten while the bundle list is iterated, e.g. right before sending.
+ */
+int bundle_block_set_data_nopurge(struct actual_bundle* bundle, struct bundle_canonical_block_t *block,
+                                  const uint8_t *data, size_t len);
 uint8_t bundle_get_attribute(struct actual_bundle* bundle, uint8_t type, void* val);
 uint8_t bundle_set_attribute(struct actual_bundle* bundle, uint8_t type, void* val);
 
 void print_bundle(struct actual_bundle* bundle);
-int increment_bundle_age(struct bundle_canonical_block_t *bundle_age_block, struct actual_bundle *bundle);
-int reset_bundle_age(struct bundle_canonical_block_t *bundle_age_block, uint32_t original_age);
+int bundle_add_age_block(struct actual_bundle *bundle, uint32_t age, uint8_t crc_type);
+/*
+ * Current age in ms, the age block value plus the time the bundle has been at this node. Returns
+ * ERROR if the bundle has no valid age block, age is then only the time at this node.
+ */
+int bundle_get_age(struct actual_bundle *bundle, uint32_t *age);
+int bundle_add_hop_count_block(struct actual_bundle *bundle, uint8_t hop_limit, uint8_t crc_type);
+/* Counts the hop to this node, returns ERROR if the bundle exceeds its hop limit with it */
+int bundle_count_hop(struct actual_bundle *bundle);
 bool is_expired_bundle(struct actual_bundle *bundle);
 
 void set_retention_constraint(struct actual_bundle *bundle, uint8_t constraint);
 uint8_t get_retention_constraint(struct actual_bundle *bundle);
-uint32_t crc32_func(const void* data, size_t length, uint32_t previousCrc32, uint32_t polynomial);
 
 char *get_src_eid(void);
 char *get_src_num(void);
+/* Sets the ipn node number of this node, a decimal string, returns OK or ERROR */
+int set_src_num(const char *num);
 bool check_if_fragment_bundle(void);
 bool check_if_node_has_clock(void);
 
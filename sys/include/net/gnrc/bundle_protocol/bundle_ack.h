@@ -0,0 +1,69 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Batched binary acknowledgements of received bundles
+ *
+ * Acks for received bundles are queued per neighbor and sent together in one link frame, a CBOR
+ * array [0, [src_num, creation time, start, count, start, count, ...], ...] holding one group per
+ * source and creation time with ranges of consecutive sequence numbers. With at most 22 groups the
+ * frame starts with a byte from 0x82 to 0x97 followed by 0, which neither an encoded bundle (0x9f)
+ * nor an uncompressed, IPHC compressed or fragmented 6LoWPAN datagram starts with.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_ACK_BP_H
+#define _BUNDLE_ACK_BP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "kernel_types.h"
+#include "net/gnrc/netif/conf.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+
+/* First element of every ack frame */
+#define BUNDLE_ACK_FRAME_TYPE 0
+
+/* Number of acks waiting to be sent over all neighbors */
+#ifndef BUNDLE_ACK_QUEUE_SIZE
+#define BUNDLE_ACK_QUEUE_SIZE 16
+#endif
+
+/* Groups of one source and creation time per frame, at most 22 to keep the first byte apart */
+#ifndef BUNDLE_ACK_MAX_GROUPS
+#define BUNDLE_ACK_MAX_GROUPS 8
+#endif
+#if BUNDLE_ACK_MAX_GROUPS > 22
+#error "BUNDLE_ACK_MAX_GROUPS must be at most 22"
+#endif
+
+/* Receives the acked range of count sequence numbers from start of the given source and creation time */
+typedef void (*bundle_ack_range_t)(void *arg, uint32_t src_num, uint32_t creation_timestamp0,
+                                   uint32_t start, uint32_t count);
+
+bool bundle_ack_is_frame(const uint8_t *buf, size_t len);
+
+/*
+ * Queues an ack for the bundle id to the neighbor with the given link layer address, reached over
+ * the interface iface. Returns the number of free queue entries left, 0 meaning the queue has to be
+ * flushed, or ERROR if it is full.
+ */
+int bundle_ack_queue(const struct bundle_id *id, const uint8_t *l2addr, size_t l2addr_len, kernel_pid_t iface);
+
+/*
+ * Encodes as many acks queued for one neighbor as fit into len bytes into buf and removes them from
+ * the queue. The address of the neighbor is copied to l2addr, which has room for
+ * GNRC_NETIF_L2ADDR_MAXLEN bytes, and the interface to send them on to iface. Returns the encoded
+ * length, 0 if nothing is queued, or ERROR if not even one ack fits.
+ */
+int bundle_ack_encode_next(uint8_t *buf, size_t len, uint8_t *l2addr, size_t *l2addr_len, kernel_pid_t *iface);
+
+/* Calls range for every range in an ack frame, returns the number of ranges or ERROR */
+int bundle_ack_decode(const uint8_t *buf, size_t len, bundle_ack_range_t range, void *arg);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Block data pool of the bundle storage
+ *
+ * Block data of stored bundles is held in chunks of a few size classes, each a memarray with its
+ * own free list, instead of a buffer of BLOCK_DATA_BUF_SIZE bytes in every block. Allocation takes
+ * the smallest class the data fits into and falls back to the larger ones. Blocks that are views
+ * into a received packet take no chunk.
+ *
+ * The RAM used by the bundle protocol for MAX_BUNDLES bundles is
+ * MAX_BUNDLES * sizeof(struct bundle_list) + BUNDLE_BLOCK_POOL_BYTES. bpstats prints both and how
+ * many chunks of every class were in use at most, to size MAX_BUNDLES and the classes per board.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_BLOCK_POOL_H
+#define _BUNDLE_BLOCK_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+/* Bundle age, hop count and copy count blocks and link layer addresses */
+#ifndef BUNDLE_BLOCK_POOL_SMALL_SIZE
+#define BUNDLE_BLOCK_POOL_SMALL_SIZE 8
+#endif
+#ifndef BUNDLE_BLOCK_POOL_SMALL_NUM
+#define BUNDLE_BLOCK_POOL_SMALL_NUM (3 * MAX_BUNDLES)
+#endif
+/* Short payloads and routing data */
+#ifndef BUNDLE_BLOCK_POOL_MEDIUM_SIZE
+#define BUNDLE_BLOCK_POOL_MEDIUM_SIZE 32
+#endif
+#ifndef BUNDLE_BLOCK_POOL_MEDIUM_NUM
+#define BUNDLE_BLOCK_POOL_MEDIUM_NUM MAX_BUNDLES
+#endif
+/* Blocks of up to BLOCK_DATA_BUF_SIZE bytes */
+#ifndef BUNDLE_BLOCK_POOL_LARGE_NUM
+#define BUNDLE_BLOCK_POOL_LARGE_NUM ((MAX_BUNDLES + 1) / 2)
+#endif
+
+#define BUNDLE_BLOCK_POOL_CLASSES 3
+
+/* Chunks are kept pointer aligned for the free lists of memarray */
+#define BUNDLE_BLOCK_POOL_STRIDE(size) ((((size) + sizeof(void *) - 1) / sizeof(void *)) * sizeof(void *))
+
+/* RAM taken by the chunks of all classes */
+#define BUNDLE_BLOCK_POOL_BYTES \
+  (BUNDLE_BLOCK_POOL_SMALL_NUM * BUNDLE_BLOCK_POOL_STRIDE(BUNDLE_BLOCK_POOL_SMALL_SIZE) + \
+   BUNDLE_BLOCK_POOL_MEDIUM_NUM * BUNDLE_BLOCK_POOL_STRIDE(BUNDLE_BLOCK_POOL_MEDIUM_SIZE) + \
+   BUNDLE_BLOCK_POOL_LARGE_NUM * BUNDLE_BLOCK_POOL_STRIDE(BLOCK_DATA_BUF_SIZE))
+
+struct bundle_block_pool_stats {
+  uint16_t size;
+  uint16_t num;
+  uint16_t used;
+  /* Most chunks in use at once since bundle_block_pool_init() */
+  uint16_t peak;
+  /* Allocations that found the class full, whether a larger class took them or not */
+  uint32_t full;
+};
+
+void bundle_block_pool_init(void);
+/* Chunk of at least len bytes, NULL if len is larger than BLOCK_DATA_BUF_SIZE or no class has room */
+uint8_t *bundle_block_pool_alloc(size_t len);
+/* Returns the chunk data points into to its class, does nothing for data that is not from the pool */
+void bundle_block_pool_free(uint8_t *data);
+/* Bytes of the chunk data points to, 0 if it is not from the pool */
+size_t bundle_block_pool_chunk_size(const uint8_t *data);
+void bundle_block_pool_stats(unsigned cls, struct bundle_block_pool_stats *stats);
+void bundle_block_pool_print(void);
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Proactive bundle fragmentation and reassembly
+ *
+ * Payloads that do not fit into a single link frame are split into fragment bundles that each fit
+ * into the link MTU. The payload is read piece by piece from its source while the fragments are
+ * created, so it never has to be held in memory as a whole. Fragments addressed to this node are
+ * collected in a reassembly buffer, which tracks the received byte ranges of every payload as a
+ * sorted list of intervals, until the whole application data unit is present, or are handed
+ * straight to a sink of the application.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_FRAGMENT_BP_H
+#define _BUNDLE_FRAGMENT_BP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "timex.h"
+
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+
+/* Number of payloads reassembled at the same time */
+#ifndef BUNDLE_REASSEMBLY_SIZE
+#define BUNDLE_REASSEMBLY_SIZE 2
+#endif
+
+/* Number of received byte ranges tracked over all payloads */
+#ifndef BUNDLE_REASSEMBLY_INT_SIZE
+#define BUNDLE_REASSEMBLY_INT_SIZE (4 * BUNDLE_REASSEMBLY_SIZE)
+#endif
+
+/* Incomplete payloads are dropped once no fragment was added to them for this long */
+#ifndef BUNDLE_REASSEMBLY_TIMEOUT_USEC
+#define BUNDLE_REASSEMBLY_TIMEOUT_USEC (60LU * US_PER_SEC)
+#endif
+
+/* Largest application data unit reassembled in the buffer, streamed payloads are not limited */
+#ifndef BUNDLE_REASSEMBLY_MAX_SIZE
+#define BUNDLE_REASSEMBLY_MAX_SIZE 1024
+#endif
+
+/* Reads len bytes of a payload starting at offset into buf, returns OK or ERROR */
+typedef int (*bundle_payload_read_t)(void *arg, size_t offset, uint8_t *buf, size_t len);
+
+/*
+ * Receives len bytes of the payload identified by id at offset. Pieces arrive in any order and may
+ * be repeated, done is set on the piece completing the payload.
+ */
+typedef void (*bundle_payload_write_t)(void *arg, const struct bundle_id *id, size_t offset,
+                                       const uint8_t *data, size_t len, bool done);
+
+/*
+ * Adds an empty payload block for a payload of len bytes to a filled bundle and marks it as a
+ * fragment if the payload does not fit into one bundle of at most mtu encoded bytes. Returns the
+ * number of payload bytes per bundle, BUNDLE_TOO_LARGE_ERROR if the payload has to be split but the
+ * bundle must not be fragmented or the link frame has no room for payload, ERROR otherwise.
+ */
+int bundle_fragment_prepare(struct actual_bundle *bundle, size_t len, uint64_t payload_flag, uint8_t crc_type,
+                            size_t mtu);
+
+/*
+ * Reads len payload bytes at offset into the payload block of fragment. Unless fragment is from
+ * itself, it is set up as a copy of from first, a prepared bundle or an earlier fragment of it,
+ * so fragments can be created one at a time without keeping the first one around.
+ * Returns OK or ERROR.
+ */
+int bundle_fragment_fill(struct actual_bundle *fragment, struct actual_bundle *from, size_t offset, size_t len,
+                         bundle_payload_read_t read, void *arg);
+
+/*
+ * Copies the payload of a received fragment into the reassembly buffer. Returns 0 while the payload
+ * is incomplete and OK once it is complete, then payload holds the whole application data unit.
+ * It stays valid until the next payload completes. Returns ERROR if the fragment was dropped.
+ */
+int bundle_reassembly_add(struct actual_bundle *fragment, gnrc_pktsnip_t **payload);
+
+/*
+ * Hands the payload of a received fragment to write instead of buffering it, only the received
+ * ranges are tracked, so payloads are not limited by BUNDLE_REASSEMBLY_MAX_SIZE. Returns like
+ * bundle_reassembly_add().
+ */
+int bundle_reassembly_stream(struct actual_bundle *fragment, bundle_payload_write_t write, void *arg);
+
+/* Drops all partially reassembled payloads */
+void bundle_reassembly_reset(void);
+
+#endif
@@ -16,33 +16,102 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "timex.h"
+
+#include "net/gnrc/pktbuf.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
 #include "net/gnrc/bundle_protocol/routing.h"
 
-//Implemented bundle storage as a linkedlist of bundles
+//Implemented bundle storage as a linkedlist of bundles, indexed by bundle id
 struct bundle_list{
   struct actual_bundle current_bundle;
   struct bundle_list* next;
+  struct bundle_list* prev;
   uint32_t unique_id;
+  uint16_t heap_pos;
+  int16_t store_slot;
+  /* taken by get_space_for_discovery_bundle() */
+  bool discovery;
 };
 
-/* Designed to only work for IPN endpoints */
-struct processed_bundle_list {
-	uint32_t src_num;
-	uint32_t creation_timestamp[2];
-	uint32_t fragment_offset;
-	uint32_t total_application_data_length;
-	struct processed_bundle_list *next;
+/* store_slot of bundles only held in RAM */
+#define BUNDLE_STORAGE_NOT_PERSISTED (-1)
+
+typedef int (*bundle_storage_restore_cb_t)(gnrc_pktsnip_t *pkt, uint32_t previous_endpoint_num, int slot);
+
+/*
+ * Optional persistent backend behind the RAM store. Bundles handed to bundle_storage_persist() are
+ * written to it and removed again by delete_bundle(), bundle_storage_init() reloads the bundles
+ * still held by it through restore. Without a backend the store is RAM only.
+ */
+struct bundle_storage_backend {
+  /* Writes the encoded bundle, returns the backend slot holding it or ERROR */
+  int (*store) (struct actual_bundle *bundle, const uint8_t *data, size_t len);
+  void (*remove) (int slot);
+  /* Calls cb for every bundle held, slots for which cb does not return OK are removed */
+  int (*restore) (bundle_storage_restore_cb_t cb);
 };
 
+extern struct bundle_storage_backend *this_storage_backend;
+
+static inline struct bundle_storage_backend *get_storage_backend(void) {
+  return this_storage_backend;
+}
+
 
+#ifndef MAX_BUNDLES
 #define MAX_BUNDLES 5
-#define MAX_PROCESSED_BUNDLES 5
+#endif
+
+/*
+ * Stored bundles above which received bundles of the bulk and normal class are refused, unless a
+ * bundle of a lower class can be purged for them. Keeps room for bundles of the higher classes.
+ */
+#ifndef BUNDLE_STORAGE_BULK_LIMIT
+#define BUNDLE_STORAGE_BULK_LIMIT ((MAX_BUNDLES * 3) / 4)
+#endif
+#ifndef BUNDLE_STORAGE_NORMAL_LIMIT
+#define BUNDLE_STORAGE_NORMAL_LIMIT ((MAX_BUNDLES * 7) / 8)
+#endif
+
+/*
+ * Slots only discovery beacons are stored in. Beacons are deleted right after they were sent or
+ * handed to the contact manager, so they neither purge bundles nor get lost with a full store.
+ */
+#ifndef BUNDLE_STORAGE_DISCOVERY_SLOTS
+#define BUNDLE_STORAGE_DISCOVERY_SLOTS 1
+#endif
+
+/* Number of processed bundle ids held by each of the two duplicate detection bloom filters */
+#ifndef PROCESSED_BUNDLES_CAPACITY
+#define PROCESSED_BUNDLES_CAPACITY 64
+#endif
+/* False positive target of the duplicate detection as 2^-PROCESSED_BUNDLES_FP_EXP, also the number
+   of hash functions used, at most 8 */
+#ifndef PROCESSED_BUNDLES_FP_EXP
+#define PROCESSED_BUNDLES_FP_EXP 7
+#endif
+/* Processed bundle ids are forgotten after one to two of these periods */
+#ifndef PROCESSED_BUNDLES_AGING_USEC
+#define PROCESSED_BUNDLES_AGING_USEC (600LU * US_PER_SEC)
+#endif
+/* Optimal size for the target is n * k / ln(2) bits */
+#define PROCESSED_BUNDLES_BLOOM_BITS ((PROCESSED_BUNDLES_CAPACITY * PROCESSED_BUNDLES_FP_EXP * 1443UL + 999) / 1000)
+#define PROCESSED_BUNDLES_BLOOM_BYTES ((PROCESSED_BUNDLES_BLOOM_BITS + 7) / 8)
+
+/* Number of slots of the bundle id index, has to be larger than MAX_BUNDLES */
+#ifndef BUNDLE_INDEX_SIZE
+#define BUNDLE_INDEX_SIZE (2 * MAX_BUNDLES)
+#endif
 
 
 struct bundle_list* bundle_storage_init(void);
 struct actual_bundle* get_space_for_bundle(void);
+/* Slot for a discovery beacon, NULL instead of purging a bundle if none is free */
+struct actual_bundle* get_space_for_discovery_bundle(void);
 bool delete_bundle(struct actual_bundle* bundle);
+void bundle_storage_index(struct actual_bundle* bundle);
+int bundle_storage_persist(struct actual_bundle* bundle);
 uint8_t get_next_block_number(void);
 struct bundle_list* get_previous_bundle_in_list(struct actual_bundle* bundle);
 struct bundle_list* find_bundle_in_list(struct actual_bundle* bundle);
@@ -50,12 +119,38 @@ struct actual_bundle *get_bundle_from_list(uint32_t creation_timestamp0, uint32_
 void print_bundle_storage(void);
 struct bundle_list *get_bundle_list(void);
 struct bundle_list *find_oldest_bundle_to_purge(void);
-uint8_t get_current_active_bundles(void);
+uint16_t get_current_active_bundles(void);
+/* Whether a received bundle of this priority class is stored, see BUNDLE_STORAGE_BULK_LIMIT */
+bool bundle_storage_admit(uint8_t priority);
+/*
+ * Whether num more bundles of this priority class fit into the storage, in free slots or in place
+ * of bundles of the same or a lower priority that may be purged for them. Nothing is purged here.
+ */
+bool bundle_storage_has_room(uint16_t num, uint8_t priority);
+/*
+ * Deletes the oldest bundle of the lowest priority to free its block data for bundle, unless that
+ * is bundle itself or of a higher priority. Returns whether a bundle was deleted.
+ */
+bool bundle_storage_purge_for(struct actual_bundle *bundle);
+/*
+ * Sets the thread the store is walked by, bundle_storage_purge_for() fails in any other. Every
+ * thread may purge until it is set.
+ */
+void bundle_storage_set_purge_pid(kernel_pid_t pid);
 bool is_redundant_bundle(struct actual_bundle *bundle);
 
 
 int add_bundle_to_processed_bundle_list(struct actual_bundle *bundle);
+void add_bundle_id_to_processed_bundle_list(const struct bundle_id *id);
 bool verify_bundle_processed(struct actual_bundle *bundle);
+bool verify_bundle_id_processed(const struct bundle_id *id);
+/*
+ * Summary vector of the bundles this node processed, the union of both processed bundle filters.
+ * Writes PROCESSED_BUNDLES_BLOOM_BYTES into bits, returns their number or ERROR if len is too small.
+ */
+int bundle_storage_summary(uint8_t *bits, size_t len);
+/* Whether the summary vector of a neighbor, built with the same filter configuration, holds id */
+bool bundle_storage_summary_check(const uint8_t *bits, size_t len, const struct bundle_id *id);
 
 
 #endif
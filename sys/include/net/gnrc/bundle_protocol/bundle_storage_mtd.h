@@ -0,0 +1,66 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Persistent bundle storage backend on a raw MTD device
+ *
+ * Bundles are appended to a log in one of two equally sized regions of the device, deletions
+ * append a tombstone. A RAM index maps the stored bundles to their records. Once the log fills
+ * up to BUNDLE_STORAGE_MTD_COMPACT_PERCENT, a low priority thread copies the live records into
+ * the other region, seals it and erases the old one. On init both regions are replayed, so the
+ * bundles held before a reset are reloaded by bundle_storage_init().
+ *
+ * Records are programmed in several steps at increasing offsets, which needs a device that allows
+ * programming erased bytes of an already written page, such as NOR flash or cpu/native/mtd.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_STORAGE_MTD_BP_H
+#define _BUNDLE_STORAGE_MTD_BP_H
+
+#include "mtd.h"
+#include "thread.h"
+
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+/* Device bundle_protocol_init() keeps the bundles on, the first MTD device of the board by default */
+#if !defined(BUNDLE_STORAGE_MTD_DEV) && defined(MTD_0)
+#define BUNDLE_STORAGE_MTD_DEV MTD_0
+#endif
+
+/* First sector of the device used for bundles */
+#ifndef BUNDLE_STORAGE_MTD_FIRST_SECTOR
+#define BUNDLE_STORAGE_MTD_FIRST_SECTOR 0
+#endif
+
+/* Sectors per region, two regions are used. A region has to hold MAX_BUNDLES of the largest bundles */
+#ifndef BUNDLE_STORAGE_MTD_REGION_SECTORS
+#define BUNDLE_STORAGE_MTD_REGION_SECTORS 4
+#endif
+
+/* Fill level of the log in percent starting a background compaction */
+#ifndef BUNDLE_STORAGE_MTD_COMPACT_PERCENT
+#define BUNDLE_STORAGE_MTD_COMPACT_PERCENT 75
+#endif
+
+/* Stack size and priority of the compaction thread, below the bundle protocol thread */
+#ifndef BUNDLE_STORAGE_MTD_STACK_SIZE
+#define BUNDLE_STORAGE_MTD_STACK_SIZE (THREAD_STACKSIZE_DEFAULT)
+#endif
+#ifndef BUNDLE_STORAGE_MTD_PRIO
+#define BUNDLE_STORAGE_MTD_PRIO (THREAD_PRIORITY_MAIN + 1)
+#endif
+
+/*
+ * Replays the log on dev and registers the backend, has to be called before bundle_storage_init().
+ * bundle_protocol_init() does so with BUNDLE_STORAGE_MTD_DEV. Returns OK or ERROR.
+ */
+int bundle_storage_mtd_init(mtd_dev_t *dev);
+
+/* Runs pending compaction and erase work to completion in the calling thread */
+void bundle_storage_mtd_sync(void);
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Summary vectors exchanged with new neighbors
+ *
+ * On a new contact both nodes send each other a summary vector of the bundles they processed, so
+ * that only bundles missing at the other node are sent. A summary vector is the union of the
+ * processed bundle bloom filters of the store, sent in one link frame as the CBOR array
+ * [1, request, bits]. A frame with request set asks for the summary vector of the receiver in
+ * return, which covers summaries lost because the receiver had not discovered the sender yet. The
+ * frame starts with 0x83 0x01, apart from ack frames, bundles and 6LoWPAN datagrams.
+ *
+ * The filter has to be configured alike on all nodes, bits of another size count as empty. With
+ * both filters full about one bundle in eight is taken as present at the neighbor although it is
+ * not, then the bundle only reaches it through retransmissions.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_SUMMARY_BP_H
+#define _BUNDLE_SUMMARY_BP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Second element of every summary frame, acks use 0 */
+#define BUNDLE_SUMMARY_FRAME_TYPE 1
+
+bool bundle_summary_is_frame(const uint8_t *buf, size_t len);
+
+/*
+ * Encodes the summary vector of this node into buf, with empty bits if they do not fit into len.
+ * Returns the encoded length or ERROR if not even that fits.
+ */
+int bundle_summary_encode(uint8_t *buf, size_t len, bool request);
+
+/* Points bits into a summary frame, returns OK or ERROR if it is malformed */
+int bundle_summary_decode(const uint8_t *buf, size_t len, bool *request, const uint8_t **bits, size_t *bits_len);
+
+#endif
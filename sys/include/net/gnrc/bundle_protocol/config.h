@@ -29,6 +29,68 @@ extern "C" {
 #define GNRC_BP_MSG_QUEUE_SIZE       (8U)
 #endif
 
+/**
+ * @brief   Link MTU bundles are fragmented to if no interface reports one,
+ *          the payload of an IEEE 802.15.4 frame with short addresses.
+ */
+#ifndef GNRC_BP_LINK_MTU
+#define GNRC_BP_LINK_MTU             (102U)
+#endif
+
+/**
+ * @brief   Delay in ms before an unacknowledged bundle is sent again, doubled for
+ *          every further retransmission up to @ref GNRC_BP_RETX_MAX_MS.
+ */
+#ifndef GNRC_BP_RETX_BASE_MS
+#define GNRC_BP_RETX_BASE_MS         (10000U)
+#endif
+
+/**
+ * @brief   Longest delay in ms between two retransmissions of a bundle.
+ */
+#ifndef GNRC_BP_RETX_MAX_MS
+#define GNRC_BP_RETX_MAX_MS          (320000U)
+#endif
+
+/**
+ * @brief   Retransmission delays are spread randomly by up to this many percent
+ *          either way, so that nodes do not retransmit in lockstep.
+ */
+#ifndef GNRC_BP_RETX_JITTER_PERCENT
+#define GNRC_BP_RETX_JITTER_PERCENT  (25U)
+#endif
+
+/**
+ * @brief   Number of retransmissions of an unacknowledged bundle, afterwards it
+ *          is only handed to newly discovered neighbors.
+ */
+#ifndef GNRC_BP_RETX_LIMIT
+#define GNRC_BP_RETX_LIMIT           (6U)
+#endif
+
+/**
+ * @brief   Retransmissions due within this many ms are sent in the same wakeup.
+ */
+#ifndef GNRC_BP_RETX_BATCH_MS
+#define GNRC_BP_RETX_BATCH_MS        (500U)
+#endif
+
+/**
+ * @brief   Acks of received bundles are collected for this many ms and sent
+ *          together, one frame per neighbor.
+ */
+#ifndef GNRC_BP_ACK_DELAY_MS
+#define GNRC_BP_ACK_DELAY_MS         (100U)
+#endif
+
+/**
+ * @brief   Hop limit of the bundles created by this node, from 1 to 255.
+ *          Bundles are deleted once they took more hops.
+ */
+#ifndef GNRC_BP_HOP_LIMIT
+#define GNRC_BP_HOP_LIMIT            (32U)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,7 +20,10 @@
 
 #include "net/gnrc/bundle_protocol/contact_manager_config.h"
 #include "net/gnrc/bundle_protocol/contact_scheduler_periodic.h"
+#include "net/gnrc/bundle_protocol/contact_scheduler_trickle.h"
 #include "net/gnrc/ipv6/nib/conf.h"
+#include "net/gnrc/netif/conf.h"
+#include "net/gnrc/pkt.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,24 +31,69 @@ extern "C" {
 
 #ifdef MODULE_GNRC_CONTACT_SCHEDULER_PERIODIC
 #define NEIGHBOR_PURGE_TIMER_SECONDS (2*CONTACT_PERIOD_SECONDS)
-#elif
-#define NEIGHBOR_PURGE_TIMER_SECONDS (40) 	
+#elif defined(MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE)
+/* Discovery bundles are up to one and a half maximum intervals apart, this outlasts one lost */
+#define NEIGHBOR_PURGE_TIMER_SECONDS (3*CONTACT_TRICKLE_MAX_INTERVAL_SECONDS)
+#else
+#define NEIGHBOR_PURGE_TIMER_SECONDS (40)
 #endif
 
-#define SECS_TO_MICROSECS 1000000
+/* Neighbors kept at a time, the one heard from longest ago makes room for a new one */
+#ifndef CONTACT_MANAGER_MAX_NEIGHBORS
+#define CONTACT_MANAGER_MAX_NEIGHBORS 16
+#endif
+
+/* Interfaces a neighbor is kept on at most, the link heard from longest ago makes room for a new one */
+#ifndef CONTACT_MANAGER_MAX_LINKS
+#define CONTACT_MANAGER_MAX_LINKS GNRC_NETIF_NUMOF
+#endif
+
+/* Buckets of the neighbor lookups by l2 address and by endpoint number, a power of two */
+#ifndef CONTACT_MANAGER_NEIGHBOR_BUCKETS
+#define CONTACT_MANAGER_NEIGHBOR_BUCKETS 16
+#endif
+#if (CONTACT_MANAGER_NEIGHBOR_BUCKETS & (CONTACT_MANAGER_NEIGHBOR_BUCKETS - 1)) != 0 || \
+    CONTACT_MANAGER_NEIGHBOR_BUCKETS > 256
+#error "CONTACT_MANAGER_NEIGHBOR_BUCKETS must be a power of two up to 256"
+#endif
 
+/*
+ * Interface a neighbor was heard on. Link quality is that of the netif headers of the frames heard
+ * over it, smoothed with a gain of 1/4, and stays 0 for interfaces that do not report it.
+ */
+struct neighbor_link_t {
+  kernel_pid_t iface;
+  uint8_t l2addr[GNRC_IPV6_NIB_L2ADDR_MAX_LEN];
+  uint8_t l2addr_len;
+  uint8_t lqi;
+  int16_t rssi;
+  /* Uptime in ms the last frame was heard over this link, 0 if none was yet */
+  uint32_t heard;
+  /* Next link in the same bucket of the lookup by l2 address */
+  struct neighbor_link_t *l2addr_next;
+  struct neighbor_t *neighbor;
+};
+
+/*
+ * Entry of the fixed neighbor table, it stays in place while the neighbor is known. num_links is 0
+ * in unused entries.
+ */
 struct neighbor_t{
   uint8_t endpoint_scheme;
   uint32_t endpoint_num;
   uint8_t *eid;
-  uint8_t l2addr [GNRC_IPV6_NIB_L2ADDR_MAX_LEN];
-  uint8_t 	l2addr_len;
-  xtimer_t expiry_timer;
+  /* One per interface the neighbor was heard on, a node with several radios has an address on each */
+  struct neighbor_link_t links[CONTACT_MANAGER_MAX_LINKS];
+  uint8_t num_links;
+  /* Smoothed round trip time of bundles acked by this neighbor in us, 0 until the first ack */
+  uint32_t srtt;
+  /* Uptime in ms the neighbor is purged at unless a discovery bundle arrives from it before */
+  uint32_t expires;
+  /* Next neighbor in the same bucket of the lookup by endpoint number */
+  struct neighbor_t *endpoint_next;
   struct neighbor_t *next;
 };
 
-
-
 /**
  * @brief   Initialization of the CONTACT_MANAGER thread.
  *
@@ -58,11 +106,26 @@ struct neighbor_t{
  * @return  -EOVERFLOW, if there are too many threads running already in general
  */
 kernel_pid_t gnrc_contact_manager_init(void);
+/*
+ * Removes the neighbor and tells the router, its entry may be reused afterwards. Runs in the BP
+ * thread, which walks the neighbors and the delivery records of the router.
+ */
+void contact_manager_remove_neighbor(struct neighbor_t *neighbor);
 void print_neighbor_list(void);
 struct neighbor_t *get_neighbor_from_endpoint_num(uint32_t endpoint_num);
-struct neighbor_t *get_neighbor_from_l2addr(uint8_t *addr);
+struct neighbor_t *get_neighbor_from_l2addr(const uint8_t *addr, size_t addr_len);
+/*
+ * Neighbor that sent a received packet, NULL if it was not discovered on the interface the packet
+ * came in on. Updates the link quality of that link from the netif header of the packet.
+ */
+struct neighbor_t *neighbor_heard(gnrc_pktsnip_t *pkt);
+/*
+ * Fills links with the links of the neighbor, best first, and returns their number. Links heard
+ * within NEIGHBOR_PURGE_TIMER_SECONDS come first, then those with the higher LQI and then RSSI.
+ */
+int get_neighbor_links(struct neighbor_t *neighbor, struct neighbor_link_t **links);
+/* Known neighbors linked by next, in the order they were discovered */
 struct neighbor_t *get_neighbor_list(void);
-void create_neighbor_expiry_timer(struct neighbor_t *neighbor);
 bool is_same_neighbor(struct neighbor_t *neighbor, struct neighbor_t *compare_to_neighbor);
 
 #ifdef __cplusplus
@@ -0,0 +1,46 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Discovery packets shared by the contact schedulers
+ *
+ * A contact scheduler decides when discovery bundles are broadcast, either every
+ * CONTACT_PERIOD_SECONDS with gnrc_contact_scheduler_periodic or adaptively with
+ * gnrc_contact_scheduler_trickle. Only one of them can be used.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _CONTACT_SCHEDULER_H
+#define _CONTACT_SCHEDULER_H
+
+#include "net/gnrc/bundle_protocol/contact_manager_config.h"
+
+#if defined(MODULE_GNRC_CONTACT_SCHEDULER_PERIODIC) && defined(MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE)
+#error "Only one of gnrc_contact_scheduler_periodic and gnrc_contact_scheduler_trickle can be used"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Default priority for the contact scheduler thread.
+ */
+#ifndef GNRC_CONTACT_SCHEDULER_PRIO
+#define GNRC_CONTACT_SCHEDULER_PRIO                 (THREAD_PRIORITY_MAIN - 2)
+#endif
+
+/*
+ * Broadcasts a discovery bundle on every interface, with the l2 address of this node on that
+ * interface and the routing data. Returns 0 if it was sent on at least one interface.
+ */
+int send(int data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,23 +14,16 @@
 
 #include <stdbool.h>
 
-#include "net/gnrc/bundle_protocol/contact_manager_config.h"
+#include "net/gnrc/bundle_protocol/contact_scheduler.h"
 
+#ifndef CONTACT_PERIOD_SECONDS
 #define CONTACT_PERIOD_SECONDS 30
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-extern int iface;		
-
-/**
- * @brief   Default priority for the _CONTACT_MANAGER_BP thread.
- */
-#ifndef GNRC_CONTACT_SCHEDULER_PRIO
-#define GNRC_CONTACT_SCHEDULER_PRIO                 (THREAD_PRIORITY_MAIN - 2)
-#endif
-
 /**
  * @brief   Initialization of the CONTACT_SCHEDULER_PERIODIC thread.
  *
@@ -43,7 +36,6 @@ extern int iface;
  * @return  -EOVERFLOW, if there are too many threads running already in general
  */
 kernel_pid_t gnrc_contact_scheduler_periodic_init(void);
-int send(int data);
 
 #ifdef __cplusplus
 }
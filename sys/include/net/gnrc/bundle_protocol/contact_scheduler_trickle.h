@@ -0,0 +1,70 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Trickle discovery packet scheduler header
+ *
+ * Sends discovery bundles with Trickle (RFC 6206). The interval starts at CONTACT_TRICKLE_IMIN_MS
+ * and doubles up to CONTACT_TRICKLE_DOUBLINGS times while the neighbor set stays the same. It
+ * starts over from CONTACT_TRICKLE_IMIN_MS when a new neighbor is discovered or a bundle is stored
+ * for forwarding, so short contacts are found while there is something to send.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _CONTACT_SCHEDULER_TRICKLE_H
+#define _CONTACT_SCHEDULER_TRICKLE_H
+
+#include "kernel_types.h"
+
+#include "net/gnrc/bundle_protocol/contact_scheduler.h"
+
+#ifndef CONTACT_TRICKLE_IMIN_MS
+#define CONTACT_TRICKLE_IMIN_MS 2000
+#endif
+
+/* Doublings of the minimum interval, 5 sends a discovery bundle every 32 to 64 seconds at most */
+#ifndef CONTACT_TRICKLE_DOUBLINGS
+#define CONTACT_TRICKLE_DOUBLINGS 5
+#endif
+
+/*
+ * Discovery bundles heard from known neighbors per interval that suppress the one of this node, 0
+ * never suppresses. Neighbors only keep this node while they hear from it, so suppression only
+ * suits dense networks with a purge time well above the maximum interval.
+ */
+#ifndef CONTACT_TRICKLE_K
+#define CONTACT_TRICKLE_K 0
+#endif
+
+#define CONTACT_TRICKLE_MAX_INTERVAL_SECONDS \
+  (((uint32_t)CONTACT_TRICKLE_IMIN_MS << CONTACT_TRICKLE_DOUBLINGS) / 1000)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Initialization of the CONTACT_SCHEDULER_TRICKLE thread.
+ *
+ * @details If CONTACT_SCHEDULER_TRICKLE was already initialized, it will just return the PID of
+ *          the CONTACT_SCHEDULER_TRICKLE thread.
+ *
+ * @return  The PID to the CONTACT_SCHEDULER_TRICKLE thread, on success.
+ * @return  -EINVAL, if @ref GNRC_CONTACT_SCHEDULER_PRIO was greater than or equal to
+ *          @ref SCHED_PRIO_LEVELS
+ * @return  -EOVERFLOW, if there are too many threads running already in general
+ */
+kernel_pid_t gnrc_contact_scheduler_trickle_init(void);
+/* Starts over from the minimum interval, may be called from any thread */
+void gnrc_contact_scheduler_trickle_reset(void);
+/* Counts a discovery bundle heard from a known neighbor, may be called from any thread */
+void gnrc_contact_scheduler_trickle_consistent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
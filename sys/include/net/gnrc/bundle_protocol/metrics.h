@@ -0,0 +1,62 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Counters and histograms of the bundle protocol
+ *
+ * All metrics are updated with relaxed atomics, so they can be recorded from any thread or from
+ * interrupt context. Histograms count values in log2 buckets: bucket 0 holds 0, bucket i holds
+ * values from 2^(i-1) to 2^i - 1 and the last bucket everything above. Reading several metrics is
+ * not atomic as a whole.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BP_METRICS_H
+#define _BP_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Number of counters, indexed by the statistics types of agent.h minus one */
+#define BP_METRICS_COUNTERS 12
+
+/* Histograms, with the unit of the values they record */
+#define BP_METRICS_HIST_LATENCY 0       /* age of delivered bundles in ms */
+#define BP_METRICS_HIST_RESIDENCY 1     /* time bundles were held in the store in ms */
+#define BP_METRICS_HIST_ACK_RTT 2       /* time from sending a bundle to its ack in us */
+#define BP_METRICS_HIST_STORE_DEPTH 3   /* bundles in the store when one is added */
+#define BP_METRICS_HIST_QUEUE_DEPTH 4   /* messages waiting for the BP thread */
+#define BP_METRICS_HISTS 5
+
+/* Buckets per histogram, the default covers about 37 hours in ms */
+#ifndef BP_METRICS_BUCKETS
+#define BP_METRICS_BUCKETS 28
+#endif
+
+/* Keys of the CBOR snapshot map */
+#define BP_METRICS_KEY_TIME 0
+#define BP_METRICS_KEY_COUNTERS 1
+#define BP_METRICS_KEY_HISTS 2
+
+void bp_metrics_count(unsigned counter);
+uint32_t bp_metrics_get_count(unsigned counter);
+void bp_metrics_record(unsigned hist, uint32_t value);
+/* Number of values recorded in a histogram and the largest of them */
+uint32_t bp_metrics_hist_count(unsigned hist);
+uint32_t bp_metrics_hist_max(unsigned hist);
+/* Upper bound of the bucket holding the given percentile, limited to the largest value */
+uint32_t bp_metrics_percentile(unsigned hist, unsigned percent);
+void bp_metrics_reset(void);
+void bp_metrics_print(void);
+
+/*
+ * Encodes all metrics as a CBOR map {0: uptime in ms, 1: [counters], 2: [[count, max, [buckets]]]}
+ * into buf, the buckets of every histogram without the trailing empty ones. Returns the encoded
+ * length, which is also returned for buf NULL, or -1 if buf is too small.
+ */
+int bp_metrics_snapshot(uint8_t *buf, size_t len);
+
+#endif
@@ -2,16 +2,31 @@
 #define _ROUTING_BP_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "net/gnrc/bundle_protocol/contact_manager.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
 
+/* Most neighbors a bundle is handed to at once */
+#ifndef ROUTING_MAX_RECEIVERS
+#define ROUTING_MAX_RECEIVERS 8
+#endif
+
 struct router{
-	struct neighbor_t* (*route_receivers) (uint32_t dst_num);
+	/* Fills receivers with at most max neighbors to send the bundle to, returns how many */
+	int (*route_receivers) (struct actual_bundle *bundle, struct neighbor_t **receivers, int max);
 	void (*received_ack) (struct neighbor_t *src_neighbor, uint32_t creation_timestamp0, uint32_t creation_timestamp1, uint32_t src_num);
 	void (*notify_bundle_deletion) (struct actual_bundle *bundle);
 	struct delivered_bundle_list* (*get_delivered_bundle_list) (void);
+	/* Optional, writes routing data for discovery bundles into buf and returns its length, 0 for none */
+	int (*discovery_data) (uint8_t *buf, size_t len);
+	/* Optional, called for every discovery bundle of a neighbor, data is NULL if it has no routing data */
+	void (*received_discovery) (struct neighbor_t *neighbor, const uint8_t *data, size_t len);
+	/* Optional, called right before the bundle is encoded for the receivers, may rewrite its blocks */
+	void (*prepare_send) (struct actual_bundle *bundle, struct neighbor_t **receivers, int num);
+	/* Optional, called after prepare_send with the receivers the bundle was sent to, num may be 0 */
+	void (*sent) (struct actual_bundle *bundle, struct neighbor_t **receivers, int num);
 };
 
 struct delivered_bundle_list{
@@ -27,4 +42,15 @@ static inline struct router *get_router(void) {
 	return this_router;
 }
 
+/*
+ * Bookkeeping of the neighbors bundles were delivered to, shared by the routers. An ack from the
+ * destination deletes the bundle, others record the neighbor so it is not sent the bundle again.
+ */
+void routing_received_ack(struct neighbor_t *src_neighbor, uint32_t creation_timestamp0, uint32_t creation_timestamp1, uint32_t src_num);
+void routing_notify_bundle_deletion(struct actual_bundle *bundle);
+/* Drops the deliveries to a neighbor that was purged, its entry may be reused for another one */
+void routing_notify_neighbor_deletion(struct neighbor_t *neighbor);
+struct delivered_bundle_list *routing_get_delivered_bundle_list(void);
+void print_delivered_bundle_list(void);
+
 #endif
@@ -0,0 +1,65 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Contact graph routing for bundle protocol
+ *
+ * Routes bundles over contacts known ahead of time, like gateway passes or duty cycled relays. A
+ * contact plan lists when a node can send to another one. For every destination the route with
+ * the earliest arrival is computed with Dijkstra over the contacts of the plan and cached until
+ * one of its contacts ends or the plan changes. A bundle is handed to its destination if in
+ * contact, otherwise to the first hop of its route once that neighbor was discovered.
+ *
+ * Plans are loaded from CBOR [now, [from, to, start, end, owlt], ...] with all times in seconds:
+ * now is the time of the plan when it is loaded, start and end bound every contact and owlt is
+ * its one way light time. Nodes without a clock load the plan with now 0 at boot.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_ROUTING_CGR_H
+#define _BUNDLE_ROUTING_CGR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "net/gnrc/bundle_protocol/routing.h"
+
+/* Contacts of the plan, every one takes 20 bytes and 7 more while computing routes */
+#ifndef CGR_MAX_CONTACTS
+#define CGR_MAX_CONTACTS 128
+#endif
+#if CGR_MAX_CONTACTS >= 65535
+#error "CGR_MAX_CONTACTS must be below 65535"
+#endif
+
+/* Destinations a route is cached for */
+#ifndef CGR_ROUTE_CACHE_SIZE
+#define CGR_ROUTE_CACHE_SIZE 8
+#endif
+
+/* With the vfs module, a plan file named by CGR_CONTACT_PLAN_FILE is loaded at init */
+
+struct cgr_contact {
+	uint32_t from;
+	uint32_t to;
+	uint32_t start;
+	uint32_t end;
+	uint32_t owlt;
+};
+
+void routing_cgr_init(void);
+/* Replaces the contact plan by num contacts, now being the current time of the plan */
+int routing_cgr_set_plan(const struct cgr_contact *contacts, size_t num, uint32_t now);
+/* Replaces the contact plan by one encoded in CBOR */
+int routing_cgr_load(const uint8_t *buf, size_t len);
+#ifdef MODULE_VFS
+int routing_cgr_load_file(const char *path);
+#endif
+/* Next hop towards endpoint_num, INVALID_EID if the plan has no route to it */
+uint32_t routing_cgr_next_hop(uint32_t endpoint_num);
+void routing_cgr_print(void);
+
+#endif
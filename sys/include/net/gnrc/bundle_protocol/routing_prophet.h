@@ -0,0 +1,69 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       PRoPHET routing for bundle protocol
+ *
+ * Every node keeps the probability to deliver a bundle to each known node, raised when the nodes
+ * meet, aged while they do not and derived transitively over common neighbors (RFC 6693). The
+ * highest predictabilities are sent along in discovery bundles as a CBOR array
+ * [endpoint_num, predictability, ...], and a bundle is only handed to neighbors that are more
+ * likely to deliver it than this node. Predictabilities are fixed point numbers with
+ * PROPHET_P_MAX for 1, so no floating point is needed.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_ROUTING_PROPHET_H
+#define _BUNDLE_ROUTING_PROPHET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "net/gnrc/bundle_protocol/routing.h"
+
+#define PROPHET_P_MAX UINT16_MAX
+
+/* Number of nodes this node keeps a delivery predictability for */
+#ifndef PROPHET_TABLE_SIZE
+#define PROPHET_TABLE_SIZE 16
+#endif
+
+/* Number of neighbors whose last predictabilities are kept */
+#ifndef PROPHET_NEIGHBOR_VECTORS
+#define PROPHET_NEIGHBOR_VECTORS 4
+#endif
+
+/* Predictabilities per discovery bundle, the highest ones are sent */
+#ifndef PROPHET_VECTOR_SIZE
+#define PROPHET_VECTOR_SIZE 10
+#endif
+
+/* Predictability added on an encounter, 0.75 */
+#ifndef PROPHET_P_ENCOUNTER
+#define PROPHET_P_ENCOUNTER 49151
+#endif
+
+/* Scaling of transitive predictabilities, 0.25 */
+#ifndef PROPHET_BETA
+#define PROPHET_BETA 16384
+#endif
+
+/* Aging per time unit, 0.98 */
+#ifndef PROPHET_GAMMA
+#define PROPHET_GAMMA 64224
+#endif
+
+/* Length of the aging time unit */
+#ifndef PROPHET_AGING_SECONDS
+#define PROPHET_AGING_SECONDS 30
+#endif
+
+void routing_prophet_init(void);
+/* Delivery predictability of this node for endpoint_num, 0 if unknown */
+uint16_t routing_prophet_get_predictability(uint32_t endpoint_num);
+void routing_prophet_print(void);
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Binary spray and wait routing for bundle protocol
+ *
+ * A bundle created here may be handed out as SPRAY_AND_WAIT_COPIES copies. Every node holding
+ * more than one copy keeps half of them and hands the other half to a neighbor without one, the
+ * copies handed over travel in a copy count block of the bundle. With a single copy left a node
+ * waits until it meets the destination, so a bundle is sent at most SPRAY_AND_WAIT_COPIES times
+ * plus retransmissions instead of to every neighbor on every hop. Copies are counted as handed
+ * over once sent, so a lost transmission loses copies rather than creating extra ones. A receiver
+ * that was not sent the bundle keeps them, retransmissions to a receiver carry the copies it was
+ * handed before instead of splitting the rest again.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#ifndef _BUNDLE_ROUTING_SPRAY_AND_WAIT_H
+#define _BUNDLE_ROUTING_SPRAY_AND_WAIT_H
+
+#include <stdint.h>
+
+#include "net/gnrc/bundle_protocol/routing.h"
+
+/* Copies of a bundle created at this node, L in the spray and wait paper */
+#ifndef SPRAY_AND_WAIT_COPIES
+#define SPRAY_AND_WAIT_COPIES 8
+#endif
+
+/* Receivers of bundles remembered with the copies handed to them, the oldest is overwritten once full */
+#ifndef SPRAY_AND_WAIT_HANDOFFS
+#define SPRAY_AND_WAIT_HANDOFFS (2 * MAX_BUNDLES)
+#endif
+
+void routing_spray_and_wait_init(void);
+/* Copies of the bundle this node may still hand out, 1 once it only waits for the destination */
+uint16_t routing_spray_and_wait_copies(struct actual_bundle *bundle);
+
+#endif
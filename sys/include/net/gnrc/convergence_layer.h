@@ -26,11 +26,11 @@
 extern "C" {
 #endif
 
-#define RETRANSMIT_TIMER_SECONDS (40000000)
 #define NET_STATS_SECONDS (2000000)
 #define TESTING_SECONDS (20000000)
 
-extern int iface;
+/* Sent by the contact manager, which waits for the reply until the BP thread removed the neighbor */
+#define GNRC_BP_MSG_TYPE_REMOVE_NEIGHBOR (0x0293)
 
 /**
  * @brief   Initialization of the BP thread.
@@ -44,14 +44,21 @@ extern int iface;
  * @return  -EOVERFLOW, if there are too many threads running already in general
  */
 kernel_pid_t gnrc_bp_init(void);
+/* PID of the BP thread, KERNEL_PID_UNDEF if it was not started */
+kernel_pid_t gnrc_bp_get_pid(void);
 
 int gnrc_bp_dispatch(gnrc_nettype_t type, uint32_t demux_ctx, struct actual_bundle *bundle, uint16_t cmd);
 
-void deliver_bundle(void *ptr, struct registration_status *application);
+/*
+ * Sends the payload to the application as a GNRC_NETAPI_MSG_TYPE_RCV message, the application
+ * releases it once consumed. It is released here if the application does not take it.
+ */
+void deliver_bundle(gnrc_pktsnip_t *payload, struct registration_status *application);
 bool check_lifetime_expiry(struct actual_bundle *bundle);
 
-void send_bundles_to_new_neighbor (struct neighbor_t *neighbor);
-void send_non_bundle_ack(struct actual_bundle *bundle, gnrc_pktsnip_t *pkt);
+/* Starts the exchange of summary vectors with a new neighbor, which then gets the bundles it misses */
+void send_summary_vector(struct neighbor_t *neighbor);
+void send_non_bundle_ack(const struct bundle_id *id, gnrc_pktsnip_t *pkt);
 void send_ack(struct actual_bundle *bundle);
 
 int deliver_bundles_to_application(struct registration_status *application);
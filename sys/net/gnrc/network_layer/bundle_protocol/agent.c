@@ -9,12 +9,22 @@
  *
  * @}
  */
+#include <inttypes.h>
+
 #include "utlist.h"
 
 #include "net/gnrc/netif.h"
+#include "net/gnrc/netapi.h"
 #include "net/gnrc/bundle_protocol/agent.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_fragment.h"
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
+#ifdef MODULE_GNRC_BP_STORAGE_MTD
+#include "board.h"
+#include "net/gnrc/bundle_protocol/bundle_storage_mtd.h"
+#endif
+#include "net/gnrc/bundle_protocol/config.h"
+#include "net/gnrc/bundle_protocol/metrics.h"
 #include "net/gnrc/convergence_layer.h"
 
 #define ENABLE_DEBUG (0)
@@ -22,41 +32,36 @@
 
 static struct registration_status *application_list = NULL;
 
-struct statistics network_stats;
 
-static int calculate_size_of_num(uint32_t num);
+static size_t _link_mtu(void);
+static int _read_buf(void *arg, size_t offset, uint8_t *buf, size_t len);
+static int _read_iolist(void *arg, size_t offset, uint8_t *buf, size_t len);
+static bool _register(uint32_t service_num, kernel_pid_t pid, bundle_payload_write_t sink, void *sink_arg);
 
-void bundle_protocol_init(kernel_pid_t pid) {
+/* Bundles are received on all interfaces, each neighbor is sent to over the best link it was heard on */
+void bundle_protocol_init(void) {
+#ifdef MODULE_GNRC_BP_STORAGE_MTD
+	/* bundles kept before a reset are reloaded by bundle_storage_init() */
+	if (bundle_storage_mtd_init(BUNDLE_STORAGE_MTD_DEV) < 0) {
+		DEBUG("agent: Could not open MTD bundle storage, keeping bundles in RAM only.\n");
+	}
+#endif
 	bundle_storage_init();
-	gnrc_netif_t *netif = NULL;
-
-	netif = gnrc_netif_get_by_pid(pid);
 	DEBUG("agent: numof interfaces :%d.\n",gnrc_netif_numof());
-	if (netif == NULL) {
-		DEBUG("agent: Provided network interface is NULL, using hardcoded interface 9.\n");
-		iface = 9;
-	}
-	else if (gnrc_netif_numof() == 1) {
-		iface = netif->pid;
-	}
-	else {
-		/*Implement handling with multiple network interfaces*/
-		DEBUG("agent: Num of interfaces greater than 1.\n");
-		iface = netif->pid;
-	}
+	bp_metrics_reset();
+}
+
+int send_bundle(uint8_t *payload_data, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority) 
+{
+	return send_bundle_stream(_read_buf, payload_data, data_len, ipn_dst, report_num, crctype, lifetime, priority);
+}
 
-	network_stats.bundles_delivered = 0;
-	network_stats.bundles_received = 0;
-	network_stats.bundles_forwarded = 0;
-	network_stats.bundles_retransmitted = 0;
-	network_stats.bundles_sent = 0;
-	network_stats.acks_sent = 0;
-	network_stats.acks_received = 0;
-	network_stats.discovery_bundle_sent = 0;
-	network_stats.discovery_bundle_receive = 0;
+int send_bundle_iolist(const iolist_t *payload, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority)
+{
+	return send_bundle_stream(_read_iolist, (void *)payload, iolist_size(payload), ipn_dst, report_num, crctype, lifetime, priority);
 }
 
-void send_bundle(uint8_t *payload_data, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime) 
+int send_bundle_stream(bundle_payload_read_t read, void *arg, size_t data_len, char *ipn_dst, char *report_num, uint8_t crctype, uint32_t lifetime, uint8_t priority)
 {
 	// (void) data;
 	// (void) iface;
@@ -73,65 +78,157 @@ void send_bundle(uint8_t *payload_data, size_t data_len, char *ipn_dst, char *re
 	}
 	else {
 		DEBUG("agent: Provide ipn endpoint id.\n");
-		return ;
+		return ERROR;
 	}
 
 	uint64_t payload_flag;
 
 	if (calculate_canonical_flag(&payload_flag, false) < 0) {
 		DEBUG("agent: Error creating payload flag.\n");
-		return;
+		return ERROR;
 	}
 
 	if (strcmp(dst, get_src_num()) == 0) {
 		DEBUG("agent: Bundle destination and source same.\n");
-		return ;
+		return ERROR;
 	}
 
 	if (get_registration_status(strtoul(service_num, NULL, 10)) != REGISTRATION_ACTIVE) {
 		DEBUG("agent: Application registration not active for sending bundle.\n");
-		return ;
+		return ERROR;
 	}
 
 	struct actual_bundle *bundle;
 	if((bundle = create_bundle()) == NULL){
 	DEBUG("agent: Could not create bundle.\n");
-	return;
+	return ERROR;
 	}
 
 	int res = fill_bundle(bundle, 7, IPN, dst, report_num, lifetime, crctype, service_num);
 	if (res < 0) {
 		DEBUG("agent: Invalid bundle.\n");
 		delete_bundle(bundle);
-		return ;
+		return ERROR;
+	}
+	/* Fragments copy the flags of the primary block */
+	bundle_set_priority(bundle, priority);
+	if (bundle_add_age_block(bundle, 0, crctype) < 0 || bundle_add_hop_count_block(bundle, GNRC_BP_HOP_LIMIT, crctype) < 0) {
+		DEBUG("agent: Could not add bundle age and hop count blocks.\n");
+		delete_bundle(bundle);
+		return ERROR;
 	}
-	bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, payload_flag, payload_data, crctype, data_len);
 
-	/* Creating bundle age block*/
-	size_t bundle_age_len;
-	uint8_t *bundle_age_data;
-	uint64_t bundle_age_flag;
+	/* Payload block goes last, split over several bundles if it does not fit into a link frame */
+	int fragment_len = bundle_fragment_prepare(bundle, data_len, payload_flag, crctype, _link_mtu());
+	if (fragment_len < 0) {
+		DEBUG("agent: Could not fit payload of %u bytes into bundles.\n", (unsigned)data_len);
+		delete_bundle(bundle);
+		return ERROR;
+	}
 
-	if (calculate_canonical_flag(&bundle_age_flag, false) < 0) {
-		DEBUG("agent: Error creating payload flag.\n");
-		return ;
+	/* A stream cut short could never be reassembled, so all fragments have to fit before the first is sent */
+	size_t num_fragments = (data_len + fragment_len - 1) / fragment_len;
+	if (num_fragments > 1 && !bundle_storage_has_room(num_fragments - 1, priority)) {
+		DEBUG("agent: No room for %u fragments in the storage.\n", (unsigned)num_fragments);
+		delete_bundle(bundle);
+		return ERROR;
+	}
+
+	size_t offset = 0, len = (data_len < (size_t)fragment_len) ? data_len : (size_t)fragment_len;
+	if (bundle_fragment_fill(bundle, bundle, offset, len, read, arg) < 0) {
+		DEBUG("agent: Could not read payload.\n");
+		delete_bundle(bundle);
+		return ERROR;
+	}
+	/*
+	 * Every fragment is created as a copy of the previous one before that is sent, so only the
+	 * fragment being sent is held here and the payload is read piece by piece. A dispatched
+	 * fragment stays retained until the BP thread takes it over, so that it is not purged while
+	 * it is still in the message queue.
+	 */
+	while (bundle != NULL) {
+		struct actual_bundle *next = NULL;
+		set_retention_constraint(bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
+		offset += len;
+		if (offset < data_len) {
+			len = (data_len - offset < (size_t)fragment_len) ? data_len - offset : (size_t)fragment_len;
+			next = create_bundle();
+			if (next == NULL || bundle_fragment_fill(next, bundle, offset, len, read, arg) < 0) {
+				DEBUG("agent: Could not create fragment at %u, payload incomplete.\n", (unsigned)offset);
+				delete_bundle(next);
+				next = NULL;
+			}
+		}
+
+		/* Copies echoed back by neighbors are dropped on receive */
+		add_bundle_to_processed_bundle_list(bundle);
+		/* Kept until delivered across reboots if a persistent storage backend is used */
+		bundle_storage_persist(bundle);
+
+		if (gnrc_bp_dispatch(GNRC_NETTYPE_BP, GNRC_NETREG_DEMUX_CTX_ALL, bundle, GNRC_NETAPI_MSG_TYPE_SND) < 1) {
+			DEBUG("agent: Unable to find BP thread.\n");
+			set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+			delete_bundle(bundle);
+			delete_bundle(next);
+			return ERROR;
+		}
+		if (offset < data_len && next == NULL) {
+			return ERROR;
+		}
+		bundle = next;
 	}
+	return OK;
+}
+
+static int _read_buf(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+	memcpy(buf, (uint8_t *)arg + offset, len);
+	return OK;
+}
 
-	uint32_t initial_bundle_age = 0;
-	bundle_age_len = calculate_size_of_num(initial_bundle_age);
-	bundle_age_data = malloc(bundle_age_len * sizeof(char));
-	sprintf((char*)bundle_age_data, "%lu", initial_bundle_age);
+static int _read_iolist(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+	for (const iolist_t *iol = arg; iol != NULL && len > 0; iol = iol->iol_next) {
+		if (offset >= iol->iol_len) {
+			offset -= iol->iol_len;
+			continue;
+		}
+		size_t n = (iol->iol_len - offset < len) ? iol->iol_len - offset : len;
+		memcpy(buf, (uint8_t *)iol->iol_base + offset, n);
+		buf += n;
+		len -= n;
+		offset = 0;
+	}
+	return (len == 0) ? OK : ERROR;
+}
 
-	bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE, bundle_age_flag, bundle_age_data, crctype, bundle_age_len);
+/* Smallest of all interfaces, the link a bundle goes out on is only picked when it is sent */
+static size_t _link_mtu(void)
+{
+	gnrc_netif_t *netif = NULL;
+	size_t min_mtu = 0;
 
-	if(!gnrc_bp_dispatch(GNRC_NETTYPE_BP, GNRC_NETREG_DEMUX_CTX_ALL, bundle, GNRC_NETAPI_MSG_TYPE_SND)) {
-	    DEBUG("agent: Unable to find BP thread.\n");
-	    delete_bundle(bundle);
-	    return ;
+	while ((netif = gnrc_netif_iter(netif)) != NULL) {
+		uint16_t mtu;
+		if (gnrc_netapi_get(netif->pid, NETOPT_MAX_PDU_SIZE, 0, &mtu, sizeof(mtu)) >= 0 &&
+		    (min_mtu == 0 || mtu < min_mtu)) {
+			min_mtu = mtu;
+		}
 	}
+	return (min_mtu == 0) ? GNRC_BP_LINK_MTU : min_mtu;
 }
 
 bool register_application(uint32_t service_num, kernel_pid_t pid)
+{
+	return _register(service_num, pid, NULL, NULL);
+}
+
+bool register_application_sink(uint32_t service_num, kernel_pid_t pid, bundle_payload_write_t sink, void *sink_arg)
+{
+	return _register(service_num, pid, sink, sink_arg);
+}
+
+static bool _register(uint32_t service_num, kernel_pid_t pid, bundle_payload_write_t sink, void *sink_arg)
 {
 	struct registration_status *temp;
 	LL_SEARCH_SCALAR(application_list, temp, service_num, service_num);
@@ -143,6 +240,8 @@ bool register_application(uint32_t service_num, kernel_pid_t pid)
 	new_application->service_num = service_num;
 	new_application->status = REGISTRATION_ACTIVE;
 	new_application->pid = pid;
+	new_application->sink = sink;
+	new_application->sink_arg = sink_arg;
 	LL_APPEND(application_list, new_application);
 	deliver_bundles_to_application(new_application);
 	return true;
@@ -174,14 +273,6 @@ uint8_t get_registration_status(uint32_t service_num)
 	return temp->status;
 }
 
-static int calculate_size_of_num(uint32_t num) {
-	if(num == 0) {
-		return 0;
-	}
-	int a = ((ceil(log10(num))+1)*sizeof(char)); 
-	return a;
-}
-
 struct registration_status *get_registration (uint32_t service_num)
 {
 	struct registration_status *temp;
@@ -209,41 +300,19 @@ bool unregister_application(uint32_t service_num)
 
 void update_statistics(int type)
 {
-	switch(type) {
-		case BUNDLE_DELIVERY:
-			network_stats.bundles_delivered++;
-			break;
-		case BUNDLE_RECEIVE:
-			network_stats.bundles_received++;
-			break;
-		case BUNDLE_SEND:
-			network_stats.bundles_sent++;
-			break;
-		case BUNDLE_FORWARD:
-			network_stats.bundles_forwarded++;
-			break;
-		case ACK_SEND:
-			network_stats.acks_sent++;
-			break;
-		case ACK_RECEIVE:
-			network_stats.acks_received++;
-			break;
-		case DISCOVERY_BUNDLE_RECEIVE:
-			network_stats.discovery_bundle_receive++;
-			break;
-		case DISCOVERY_BUNDLE_SEND:
-			network_stats.discovery_bundle_sent++;
-			break;
-		case BUNDLE_RETRANSMIT:
-			network_stats.bundles_retransmitted++;
-			break;
-	}
+	/* The statistics types are numbered from one */
+	bp_metrics_count(type - 1);
+}
+
+static unsigned long _count(int type)
+{
+	return bp_metrics_get_count(type - 1);
 }
 
 void print_network_statistics(void)
 {
-	printf("#*#*,%lu, %d, %d, %d, %d, %d, %d, %d, %d,%d,%d,\n",xtimer_now().ticks32, get_current_active_bundles(), network_stats.bundles_sent, 
-						network_stats.bundles_received, network_stats.bundles_forwarded
-					, network_stats.bundles_retransmitted, network_stats.bundles_delivered, network_stats.acks_sent, network_stats.acks_received
-					, network_stats.discovery_bundle_sent, network_stats.discovery_bundle_receive);
+	printf("#*#*,%" PRIu32 ", %d, %lu, %lu, %lu, %lu, %lu, %lu, %lu,%lu,%lu,\n", xtimer_now().ticks32, get_current_active_bundles(),
+					_count(BUNDLE_SEND), _count(BUNDLE_RECEIVE), _count(BUNDLE_FORWARD), _count(BUNDLE_RETRANSMIT),
+					_count(BUNDLE_DELIVERY), _count(ACK_SEND), _count(ACK_RECEIVE), _count(DISCOVERY_BUNDLE_SEND),
+					_count(DISCOVERY_BUNDLE_RECEIVE));
 }
@@ -9,20 +9,24 @@
  *
  * @}
  */
-#include "checksum/ucrc16.h"
-#include "checksum/fletcher32.h"
-#include "byteorder.h"
+#include <inttypes.h>
+
+#include "checksum/crc16_ccitt.h"
+#include "checksum/crc32c.h"
+#include "net/gnrc/pktbuf.h"
 
 #include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_block_pool.h"
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
 #include "od.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
-static uint8_t sequence_num = 0;
+static uint32_t sequence_num = 0;
+/* Long enough for any 32 bit node number */
+static char src_num[11] = DUMMY_SRC_NUM;
 
-static bool is_fragment_bundle(struct actual_bundle* bundle);
 static int decode_primary_block_element(nanocbor_value_t *decoder, struct actual_bundle* bundle, uint8_t element);
 static int decode_canonical_block_element(nanocbor_value_t* decoder, struct bundle_canonical_block_t* block, uint8_t element);
 
@@ -53,14 +57,34 @@ bool is_same_bundle(struct actual_bundle* current_bundle, struct actual_bundle*
   return true;
 }
 
-static bool is_fragment_bundle(struct actual_bundle* bundle)
+bool bundle_is_fragment(struct actual_bundle* bundle)
 {
   return ((bundle->primary_block.flags & FRAGMENT_IDENTIFICATION_MASK) == 1);
 }
 
-int bundle_encode(struct actual_bundle* bundle, nanocbor_encoder_t *enc)
+static uint8_t _priority_of(uint64_t flags)
+{
+  uint8_t priority = (flags & BUNDLE_PRIORITY_MASK) >> BUNDLE_PRIORITY_SHIFT;
+  return (priority < BUNDLE_PRIORITY_CLASSES) ? priority : BUNDLE_PRIORITY_NORMAL;
+}
+
+uint8_t bundle_get_priority(struct actual_bundle* bundle)
+{
+  return _priority_of(bundle->primary_block.flags);
+}
+
+void bundle_set_priority(struct actual_bundle* bundle, uint8_t priority)
+{
+  bundle_wire_invalidate(bundle);
+  bundle->primary_block.flags = (bundle->primary_block.flags & ~(uint64_t)BUNDLE_PRIORITY_MASK) |
+                                (((uint64_t)priority << BUNDLE_PRIORITY_SHIFT) & BUNDLE_PRIORITY_MASK);
+  /* the store purges by priority */
+  bundle_storage_index(bundle);
+}
+
+/* Encodes the bundle, noting where a patchable bundle age block starts and how long it is if age_at is set */
+static void _encode(struct actual_bundle* bundle, nanocbor_encoder_t *enc, size_t *age_at, size_t *age_len)
 {
-  
   nanocbor_fmt_array_indefinite(enc);
 
   //parsing and encoding primary block
@@ -69,13 +93,188 @@ int bundle_encode(struct actual_bundle* bundle, nanocbor_encoder_t *enc)
   struct bundle_canonical_block_t* tempPtr = bundle->other_blocks;
   int i = 0;
   while(i < bundle->num_of_blocks){
+    size_t start = nanocbor_encoded_len(enc);
     encode_canonical_block(&tempPtr[i], enc);
+    if (age_at != NULL && tempPtr[i].type == BUNDLE_BLOCK_TYPE_BUNDLE_AGE && tempPtr[i].data_len == BUNDLE_AGE_DATA_LEN) {
+      *age_at = start;
+      *age_len = nanocbor_encoded_len(enc) - start;
+    }
     i++;
   }
   nanocbor_fmt_end_indefinite(enc);
+}
+
+int bundle_encode(struct actual_bundle* bundle, nanocbor_encoder_t *enc)
+{
+  _encode(bundle, enc, NULL, NULL);
   return 1;
 }
 
+static size_t _endpoint_len_max(struct actual_bundle *bundle, uint8_t *eid)
+{
+  // array header, endpoint scheme and then either the eid string or the [num, service] array
+  size_t len = 1 + CBOR_HEAD_MAX_LEN;
+  if (bundle->primary_block.endpoint_scheme == DTN) {
+    len += CBOR_HEAD_MAX_LEN + (eid == NULL ? 0 : strlen((char*)eid));
+  }
+  else {
+    len += 1 + 2 * CBOR_HEAD_MAX_LEN;
+  }
+  return len;
+}
+
+/*
+ * Upper bound of the encoded size of the bundle, assuming every integer takes the widest
+ * CBOR encoding. Cheap to compute, so that a transmit buffer can be reserved before encoding.
+ */
+size_t bundle_encoded_len_max(struct actual_bundle* bundle)
+{
+  // start and end of the indefinite array
+  size_t len = 2;
+
+  // array header, version, flags, crc type, creation timestamp, lifetime, fragment fields and crc
+  len += 1 + 3 * CBOR_HEAD_MAX_LEN + (1 + 2 * CBOR_HEAD_MAX_LEN) + 4 * CBOR_HEAD_MAX_LEN;
+  len += _endpoint_len_max(bundle, bundle->primary_block.dest_eid);
+  len += _endpoint_len_max(bundle, bundle->primary_block.src_eid);
+  len += _endpoint_len_max(bundle, bundle->primary_block.report_eid);
+
+  for (int i = 0; i < bundle->num_of_blocks; i++) {
+    // array header, type, block number, flags, crc type, data header, data and crc
+    len += 1 + 5 * CBOR_HEAD_MAX_LEN + bundle->other_blocks[i].data_len + CBOR_HEAD_MAX_LEN;
+  }
+  return len;
+}
+
+/* Exact encoded size of the bundle, from an encoding pass that does not write anything */
+size_t bundle_encoded_len(struct actual_bundle* bundle)
+{
+  nanocbor_encoder_t enc;
+  nanocbor_encoder_init(&enc, NULL, 0);
+  bundle_encode(bundle, &enc);
+  return nanocbor_encoded_len(&enc);
+}
+
+/*
+ * Encodes the bundle in a single pass directly into a new packet buffer snip. Space for the
+ * upper bound of the encoded size is reserved first and shrunk to the actual size afterwards.
+ */
+static gnrc_pktsnip_t *_encode_pkt(struct actual_bundle* bundle, gnrc_nettype_t type, size_t *age_at, size_t *age_len)
+{
+  nanocbor_encoder_t enc;
+  size_t max_len = bundle_encoded_len_max(bundle);
+
+  gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, NULL, max_len, type);
+  if (pkt == NULL) {
+    DEBUG("bundle: unable to reserve %u bytes in packet buffer.\n", (unsigned)max_len);
+    return NULL;
+  }
+  nanocbor_encoder_init(&enc, pkt->data, max_len);
+  _encode(bundle, &enc, age_at, age_len);
+
+  size_t len = nanocbor_encoded_len(&enc);
+  if (len > max_len) {
+    DEBUG("bundle: encoded bundle larger than reserved space.\n");
+    gnrc_pktbuf_release(pkt);
+    return NULL;
+  }
+  if (len < max_len && gnrc_pktbuf_realloc_data(pkt, len) != 0) {
+    DEBUG("bundle: unable to shrink encoded bundle.\n");
+    gnrc_pktbuf_release(pkt);
+    return NULL;
+  }
+  return pkt;
+}
+
+gnrc_pktsnip_t *bundle_encode_pkt(struct actual_bundle* bundle, gnrc_nettype_t type)
+{
+  return _encode_pkt(bundle, type, NULL, NULL);
+}
+
+static size_t _crc_len(uint8_t crc_type)
+{
+  switch (crc_type) {
+    case CRC_16:
+      return 2;
+    case CRC_32:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+static uint32_t _crc_update(uint8_t crc_type, uint32_t crc, const uint8_t *data, size_t len)
+{
+  if (crc_type == CRC_16) {
+    return crc16_ccitt_update(crc, data, len);
+  }
+  return crc32c_update(crc, data, len);
+}
+
+static uint32_t _crc_init(uint8_t crc_type)
+{
+  return (crc_type == CRC_16) ? CRC16_INIT : CRC32C_INIT;
+}
+
+/* Computes the CRC of an encoded block ending with its CRC byte string and writes it into place */
+static uint32_t _write_crc(uint8_t *start, size_t block_len, uint8_t crc_type)
+{
+  size_t crc_len = _crc_len(crc_type);
+  uint8_t *crc_pos = start + block_len - crc_len;
+
+  memset(crc_pos, 0, crc_len);
+  uint32_t crc = _crc_update(crc_type, _crc_init(crc_type), start, block_len);
+  for (size_t i = 0; i < crc_len; i++) {
+    crc_pos[i] = crc >> (8 * (crc_len - 1 - i));
+  }
+  return crc;
+}
+
+/*
+ * Appends the fixed width CRC byte string of a block whose encoding started at start. The CRC is
+ * taken over the bytes the encoder has just written for the block, with the CRC field zeroed, and
+ * then patched into place, so no scratch buffer or second encoding pass is needed. Returns 0 when
+ * only sizing or when the block did not fit into the buffer.
+ */
+static uint32_t _encode_crc(nanocbor_encoder_t *enc, uint8_t *start, size_t start_len, uint8_t crc_type)
+{
+  static const uint8_t zero_crc[4] = { 0 };
+
+  nanocbor_put_bstr(enc, zero_crc, _crc_len(crc_type));
+  size_t block_len = nanocbor_encoded_len(enc) - start_len;
+  if (start == NULL || (size_t)(enc->cur - start) != block_len) {
+    return 0;
+  }
+  return _write_crc(start, block_len, crc_type);
+}
+
+/*
+ * Checks the CRC of a received block against its wire encoding. end points right behind the CRC
+ * byte string, which is always the last element of the block.
+ */
+static bool _verify_crc(uint8_t crc_type, uint32_t crc, const uint8_t *start, const uint8_t *end)
+{
+  static const uint8_t zero_crc[4] = { 0 };
+  size_t crc_len = _crc_len(crc_type);
+
+  uint32_t crc_val = _crc_update(crc_type, _crc_init(crc_type), start, end - start - crc_len);
+  crc_val = _crc_update(crc_type, crc_val, zero_crc, crc_len);
+  return crc_val == crc;
+}
+
+static int _decode_crc(nanocbor_value_t *decoder, uint8_t crc_type, uint32_t *crc)
+{
+  size_t len;
+  const uint8_t *buf = NULL;
+  if (nanocbor_get_bstr(decoder, &buf, &len) < 0 || len != _crc_len(crc_type)) {
+    return ERROR;
+  }
+  *crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    *crc = (*crc << 8) | buf[i];
+  }
+  return 0;
+}
+
 static int decode_primary_block_element(nanocbor_value_t *decoder, struct actual_bundle* bundle, uint8_t element)
 {
   switch(element){
@@ -202,8 +401,8 @@ static int decode_primary_block_element(nanocbor_value_t *decoder, struct actual
     break;
     case FRAGMENT_OFFSET:
     {
-      if(is_fragment_bundle(bundle)){
-        nanocbor_get_uint32(decoder, &bundle->primary_block.fragment_offset);
+      if(bundle_is_fragment(bundle)){
+        return nanocbor_get_uint32(decoder, &bundle->primary_block.fragment_offset);
       }
       else{
         bundle->primary_block.fragment_offset=0;
@@ -212,8 +411,8 @@ static int decode_primary_block_element(nanocbor_value_t *decoder, struct actual
     break;
     case TOTAL_APPLICATION_DATA_LENGTH:
     {
-      if(is_fragment_bundle(bundle)){
-        nanocbor_get_uint32(decoder, &bundle->primary_block.total_application_data_length);
+      if(bundle_is_fragment(bundle)){
+        return nanocbor_get_uint32(decoder, &bundle->primary_block.total_application_data_length);
       }
       else{
         bundle->primary_block.total_application_data_length=0;
@@ -222,7 +421,7 @@ static int decode_primary_block_element(nanocbor_value_t *decoder, struct actual
     break;
     case CRC_PRIMARY:
     {
-      nanocbor_get_uint32(decoder, &bundle->primary_block.crc);
+      return _decode_crc(decoder, bundle->primary_block.crc_type, &bundle->primary_block.crc);
     }
     break;
     default:
@@ -290,9 +489,9 @@ static int decode_canonical_block_element(nanocbor_value_t* decoder, struct bund
         size_t len;
         const uint8_t *buf = NULL;
         if(nanocbor_get_bstr(decoder, &buf, &len) >= 0 && buf) {
+          /* Only a view into the decoded buffer, copied afterwards if the bundle does not hold the buffer */
+          block->block_data = (uint8_t*)buf;
           block->data_len = len;
-          // memcpy(block->block_data, buf, len);
-          sprintf((char*)block->block_data, "%s", buf);
           return 0;
         }
         else {
@@ -302,16 +501,10 @@ static int decode_canonical_block_element(nanocbor_value_t* decoder, struct bund
       break;
       case CRC_CANONICAL:
       {
-        uint32_t temp;
         if(block->crc_type != NOCRC){
-          if (nanocbor_get_uint32(decoder, &temp) >= 0) {
-            block->crc = temp;
-            return 0;
-          }
-          else {
-            return ERROR;
-          }
+          return _decode_crc(decoder, block->crc_type, &block->crc);
         }
+        block->crc = 0;
       }
       break;
       default:
@@ -323,40 +516,105 @@ static int decode_canonical_block_element(nanocbor_value_t* decoder, struct bund
     return 0;
 }
 
-//assuming space is preallocated for the bundle here
-int bundle_decode(struct actual_bundle* bundle, uint8_t *buffer, size_t buf_len)
+/*
+ * Blocks are views into the buffer when decoding zero copy, except for blocks that are rewritten
+ * by this node before forwarding (bundle age), those always live in the block's own buffer.
+ */
+/* Writes the age as the BUNDLE_AGE_DATA_LEN bytes CBOR uint of the age block data */
+static void _age_write(uint8_t *buf, uint32_t age)
+{
+  buf[0] = 0x1a;
+  buf[1] = age >> 24;
+  buf[2] = age >> 16;
+  buf[3] = age >> 8;
+  buf[4] = age;
+}
+
+/* The age block data as sent by this node, so that the age can be patched in bundle_wire_pkt() */
+static int _age_normalize(struct actual_bundle* bundle, struct bundle_canonical_block_t *block)
+{
+  nanocbor_value_t decoder;
+  uint8_t data[BUNDLE_AGE_DATA_LEN];
+  uint32_t age;
+
+  nanocbor_decoder_init(&decoder, block->block_data, block->data_len);
+  if (nanocbor_get_uint32(&decoder, &age) < 0) {
+    DEBUG("bundle: Malformed bundle age block.\n");
+    return ERROR;
+  }
+  _age_write(data, age);
+  return bundle_block_set_data(bundle, block, data, sizeof(data));
+}
+
+/* Writes the BUNDLE_HOP_COUNT_DATA_LEN bytes of the hop count block data, counted in place */
+static void _hop_count_write(uint8_t *buf, uint8_t hop_limit, uint8_t hop_count)
+{
+  buf[0] = 0x82;
+  buf[1] = 0x18;
+  buf[2] = hop_limit;
+  buf[3] = 0x18;
+  buf[4] = hop_count;
+}
+
+static int _hop_count_normalize(struct actual_bundle* bundle, struct bundle_canonical_block_t *block)
+{
+  nanocbor_value_t decoder, arr;
+  uint8_t data[BUNDLE_HOP_COUNT_DATA_LEN];
+  uint32_t hop_limit, hop_count;
+
+  nanocbor_decoder_init(&decoder, block->block_data, block->data_len);
+  if (nanocbor_enter_array(&decoder, &arr) < 0 || nanocbor_get_uint32(&arr, &hop_limit) < 0 ||
+      nanocbor_get_uint32(&arr, &hop_count) < 0 || hop_limit > UINT8_MAX || hop_count > UINT8_MAX) {
+    DEBUG("bundle: Malformed hop count block.\n");
+    return ERROR;
+  }
+  _hop_count_write(data, hop_limit, hop_count);
+  return bundle_block_set_data(bundle, block, data, sizeof(data));
+}
+
+static int _bundle_decode(struct actual_bundle* bundle, uint8_t *buffer, size_t buf_len, bool zero_copy)
 {
   DEBUG("bundle: Trying to decode bundle.\n");
   nanocbor_value_t decoder;
 
   nanocbor_decoder_init(&decoder, buffer, buf_len);
 
-  if (*decoder.cur != 0x9f) {
+  if (buf_len < 2 || *decoder.cur != 0x9f) {
     return ERROR;
   }
   //moving the pointer in the decoder 1 byte ahead to ignore start of indefinite array thing
   decoder.cur++;
   //decoding and parsing the primary block
+  const uint8_t *block_start = decoder.cur;
   nanocbor_value_t arr;
-  nanocbor_enter_array(&decoder, &arr);
-  
-  decode_primary_block_element(&arr, bundle, VERSION);
-  decode_primary_block_element(&arr, bundle, FLAGS_PRIMARY);
-  decode_primary_block_element(&arr, bundle, CRC_TYPE_PRIMARY);
+  if (nanocbor_enter_array(&decoder, &arr) < 0) {
+    return ERROR;
+  }
+
+  if (decode_primary_block_element(&arr, bundle, VERSION) < 0 ||
+      decode_primary_block_element(&arr, bundle, FLAGS_PRIMARY) < 0 ||
+      decode_primary_block_element(&arr, bundle, CRC_TYPE_PRIMARY) < 0) {
+    return ERROR;
+  }
   decode_primary_block_element(&arr, bundle, EID);
   decode_primary_block_element(&arr, bundle, CREATION_TIMESTAMP);
   decode_primary_block_element(&arr, bundle, LIFETIME);
-  if(is_fragment_bundle(bundle)) {
-    decode_primary_block_element(&arr, bundle, FRAGMENT_OFFSET);
-    decode_primary_block_element(&arr, bundle, TOTAL_APPLICATION_DATA_LENGTH);
+  if(bundle_is_fragment(bundle)) {
+    if (decode_primary_block_element(&arr, bundle, FRAGMENT_OFFSET) < 0 ||
+        decode_primary_block_element(&arr, bundle, TOTAL_APPLICATION_DATA_LENGTH) < 0) {
+      return ERROR;
+    }
+  }
+  else {
+    // part of the bundle id, storage slots are reused
+    bundle->primary_block.fragment_offset = 0;
+    bundle->primary_block.total_application_data_length = 0;
   }
   if(bundle->primary_block.crc_type != NOCRC) {
-    decode_primary_block_element(&arr, bundle, CRC_PRIMARY);
-    uint32_t crc_bundle = bundle->primary_block.crc;
-    bundle->primary_block.crc = 0x00000000;
-    bool valid_bundle = verify_checksum(bundle, BUNDLE_BLOCK_TYPE_PRIMARY, crc_bundle);
-    if (valid_bundle) {
-      bundle_set_attribute(bundle, CRC_TYPE_PRIMARY, &crc_bundle);
+    if (decode_primary_block_element(&arr, bundle, CRC_PRIMARY) < 0 ||
+        !_verify_crc(bundle->primary_block.crc_type, bundle->primary_block.crc, block_start, arr.cur)) {
+      DEBUG("bundle: primary block crc check failed.\n");
+      return ERROR;
     }
   }
   else {
@@ -365,28 +623,289 @@ int bundle_decode(struct actual_bundle* bundle, uint8_t *buffer, size_t buf_len)
   nanocbor_leave_container(&decoder, &arr);
 
   //decoding and parsing other canonical blocks
-  while(!(*decoder.cur == 0xFF && (buffer+buf_len-1) == decoder.cur) && bundle->num_of_blocks < MAX_NUM_OF_BLOCKS){
+  while(decoder.cur < buffer + buf_len && !(*decoder.cur == 0xFF && (buffer+buf_len-1) == decoder.cur) && bundle->num_of_blocks < MAX_NUM_OF_BLOCKS){
     struct bundle_canonical_block_t* block = &bundle->other_blocks[bundle->num_of_blocks];
+    block_start = decoder.cur;
     nanocbor_value_t arr;
-    nanocbor_enter_array(&decoder, &arr);
-    decode_canonical_block_element(&arr, block, TYPE);
-    decode_canonical_block_element(&arr, block, BLOCK_NUMBER);
-    decode_canonical_block_element(&arr, block, FLAGS_CANONICAL);
-    decode_canonical_block_element(&arr, block, CRC_TYPE_CANONICAL);
-    decode_canonical_block_element(&arr, block, BLOCK_DATA);
-    decode_canonical_block_element(&arr, block, CRC_CANONICAL);
+    if (nanocbor_enter_array(&decoder, &arr) < 0 ||
+        decode_canonical_block_element(&arr, block, TYPE) < 0 ||
+        decode_canonical_block_element(&arr, block, BLOCK_NUMBER) < 0 ||
+        decode_canonical_block_element(&arr, block, FLAGS_CANONICAL) < 0 ||
+        decode_canonical_block_element(&arr, block, CRC_TYPE_CANONICAL) < 0 ||
+        decode_canonical_block_element(&arr, block, BLOCK_DATA) < 0) {
+      return ERROR;
+    }
+    if (decode_canonical_block_element(&arr, block, CRC_CANONICAL) < 0 ||
+        (block->crc_type != NOCRC && !_verify_crc(block->crc_type, block->crc, block_start, arr.cur))) {
+      DEBUG("bundle: canonical block crc check failed.\n");
+      return ERROR;
+    }
     nanocbor_leave_container(&decoder, &arr);
+    /* counted before the block data is copied, so that a failed copy is released with the bundle */
     bundle->num_of_blocks++;
+    /* blocks rewritten before the bundle is forwarded cannot stay in the received packet */
+    if (block->type == BUNDLE_BLOCK_TYPE_BUNDLE_AGE) {
+      if (_age_normalize(bundle, block) < 0) {
+        return ERROR;
+      }
+    }
+    else if (block->type == BUNDLE_BLOCK_TYPE_HOP_COUNT) {
+      if (_hop_count_normalize(bundle, block) < 0) {
+        return ERROR;
+      }
+    }
+    else if (!zero_copy || block->type == BUNDLE_BLOCK_TYPE_COPY_COUNT) {
+      if (block->data_len > BLOCK_DATA_BUF_SIZE) {
+        DEBUG("bundle: block of %u bytes does not fit into block pool.\n", (unsigned)block->data_len);
+        return BUNDLE_TOO_LARGE_ERROR;
+      }
+      if (bundle_block_set_data(bundle, block, block->block_data, block->data_len) < 0) {
+        return ERROR;
+      }
+    }
   }
-  if (*decoder.cur != 0xFF && bundle->num_of_blocks >= MAX_NUM_OF_BLOCKS) {
+  if (decoder.cur >= buffer + buf_len || *decoder.cur != 0xFF) {
     return ERROR;
   }
+  bundle_storage_index(bundle);
   return 1;
 }
 
+//assuming space is preallocated for the bundle here
+int bundle_decode(struct actual_bundle* bundle, uint8_t *buffer, size_t buf_len)
+{
+  return _bundle_decode(bundle, buffer, buf_len, false);
+}
+
+/*
+ * Decodes the bundle without copying its blocks out of the received packet. On success the bundle
+ * holds its own reference to pkt until it is deleted from storage, the caller still has to release
+ * its reference.
+ */
+int bundle_decode_pkt(struct actual_bundle* bundle, gnrc_pktsnip_t *pkt)
+{
+  int res = _bundle_decode(bundle, pkt->data, pkt->size, true);
+  if (res < 0) {
+    return res;
+  }
+  gnrc_pktbuf_hold(pkt, 1);
+  bundle->pkt = pkt;
+  return res;
+}
+
+void bundle_release_pkt(struct actual_bundle* bundle)
+{
+  if (bundle->pkt != NULL) {
+    gnrc_pktbuf_release(bundle->pkt);
+    bundle->pkt = NULL;
+  }
+}
+
+void bundle_release_blocks(struct actual_bundle* bundle)
+{
+  for (int i = 0; i < bundle->num_of_blocks; i++) {
+    bundle_block_pool_free(bundle->other_blocks[i].block_data);
+    bundle->other_blocks[i].block_data = NULL;
+  }
+  bundle->num_of_blocks = 0;
+}
+
+/* Writes the current age into the bundle age block of the image and the CRC of that block */
+static void _wire_patch_age(struct actual_bundle* bundle)
+{
+  struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
+  uint32_t age;
+
+  if (bundle->wire_age_at == 0 || block == NULL || bundle_get_age(bundle, &age) < 0) {
+    return ;
+  }
+  uint8_t *start = (uint8_t *)bundle->wire->data + bundle->wire_age_at;
+  size_t crc_len = _crc_len(block->crc_type);
+  /* the age ends the block data, only followed by the CRC byte string */
+  _age_write(start + bundle->wire_age_len - crc_len - (crc_len ? 1 : 0) - BUNDLE_AGE_DATA_LEN, age);
+  if (block->crc_type != NOCRC) {
+    _write_crc(start, bundle->wire_age_len, block->crc_type);
+  }
+}
+
+/*
+ * Sending to several neighbors, or again on the next contact, only patches the age. The image of an
+ * earlier transmission may still be queued at the interface, then it is copied first, so that a
+ * packet is never changed while it is being sent.
+ */
+gnrc_pktsnip_t *bundle_wire_pkt(struct actual_bundle* bundle)
+{
+  if (bundle->wire == NULL) {
+    size_t age_at = 0, age_len = 0;
+    if ((bundle->wire = _encode_pkt(bundle, GNRC_NETTYPE_BP, &age_at, &age_len)) == NULL) {
+      return NULL;
+    }
+    bundle->wire_age_at = age_at;
+    bundle->wire_age_len = age_len;
+  }
+  else {
+    gnrc_pktsnip_t *wire = gnrc_pktbuf_start_write(bundle->wire);
+    if (wire == NULL) {
+      DEBUG("bundle: unable to copy bundle image still being sent.\n");
+      return NULL;
+    }
+    bundle->wire = wire;
+  }
+  _wire_patch_age(bundle);
+  gnrc_pktbuf_hold(bundle->wire, 1);
+  return bundle->wire;
+}
+
+void bundle_wire_invalidate(struct actual_bundle* bundle)
+{
+  if (bundle->wire != NULL) {
+    gnrc_pktbuf_release(bundle->wire);
+    bundle->wire = NULL;
+  }
+}
+
+void bundle_get_id(struct actual_bundle* bundle, struct bundle_id *id)
+{
+  id->src_num = bundle->primary_block.src_num;
+  id->creation_timestamp[0] = bundle->primary_block.creation_timestamp[0];
+  id->creation_timestamp[1] = bundle->primary_block.creation_timestamp[1];
+  id->fragment_offset = bundle->primary_block.fragment_offset;
+  id->total_application_data_length = bundle->primary_block.total_application_data_length;
+}
+
+/*
+ * Reads only the bundle id out of an encoded bundle, without a bundle to decode into, so that
+ * duplicates can be dropped before claiming a storage slot. Nothing is verified here.
+ */
+int bundle_peek_id(const uint8_t *buffer, size_t buf_len, struct bundle_id *id)
+{
+  nanocbor_value_t decoder, arr, eid, num;
+  uint32_t flags, scheme;
+
+  memset(id, 0, sizeof(*id));
+  nanocbor_decoder_init(&decoder, buffer, buf_len);
+  if (buf_len < 2 || *decoder.cur != 0x9f) {
+    return ERROR;
+  }
+  decoder.cur++;
+  if (nanocbor_enter_array(&decoder, &arr) < 0 ||
+      nanocbor_skip(&arr) < 0 ||                       // version
+      nanocbor_get_uint32(&arr, &flags) < 0 ||
+      nanocbor_skip(&arr) < 0 ||                       // crc type
+      nanocbor_skip(&arr) < 0) {                       // destination
+    return ERROR;
+  }
+  if (nanocbor_enter_array(&arr, &eid) < 0 || nanocbor_get_uint32(&eid, &scheme) < 0 || scheme != IPN ||
+      nanocbor_enter_array(&eid, &num) < 0 || nanocbor_get_uint32(&num, &id->src_num) < 0 ||
+      nanocbor_skip(&num) < 0) {                       // service number
+    return ERROR;
+  }
+  nanocbor_leave_container(&eid, &num);
+  nanocbor_leave_container(&arr, &eid);
+  if (nanocbor_skip(&arr) < 0 ||                       // report to
+      nanocbor_enter_array(&arr, &num) < 0 ||
+      nanocbor_get_uint32(&num, &id->creation_timestamp[0]) < 0 ||
+      nanocbor_get_uint32(&num, &id->creation_timestamp[1]) < 0) {
+    return ERROR;
+  }
+  nanocbor_leave_container(&arr, &num);
+  if (flags & FRAGMENT_IDENTIFICATION_MASK) {
+    if (nanocbor_skip(&arr) < 0 ||                     // lifetime
+        nanocbor_get_uint32(&arr, &id->fragment_offset) < 0 ||
+        nanocbor_get_uint32(&arr, &id->total_application_data_length) < 0) {
+      return ERROR;
+    }
+  }
+  return OK;
+}
+
+int bundle_peek_service(const uint8_t *buffer, size_t buf_len, uint32_t *service_num)
+{
+  nanocbor_value_t decoder, arr, eid, num;
+  uint32_t scheme;
+
+  nanocbor_decoder_init(&decoder, buffer, buf_len);
+  if (buf_len < 2 || *decoder.cur != 0x9f) {
+    return ERROR;
+  }
+  decoder.cur++;
+  if (nanocbor_enter_array(&decoder, &arr) < 0 ||
+      nanocbor_skip(&arr) < 0 ||                       // version
+      nanocbor_skip(&arr) < 0 ||                       // flags
+      nanocbor_skip(&arr) < 0) {                       // crc type
+    return ERROR;
+  }
+  if (nanocbor_enter_array(&arr, &eid) < 0 || nanocbor_get_uint32(&eid, &scheme) < 0 || scheme != IPN ||
+      nanocbor_enter_array(&eid, &num) < 0 || nanocbor_skip(&num) < 0 ||   // node number
+      nanocbor_get_uint32(&num, service_num) < 0) {
+    return ERROR;
+  }
+  return OK;
+}
+
+int bundle_peek_priority(const uint8_t *buffer, size_t buf_len)
+{
+  nanocbor_value_t decoder, arr;
+  uint32_t flags;
+
+  nanocbor_decoder_init(&decoder, buffer, buf_len);
+  if (buf_len < 2 || *decoder.cur != 0x9f) {
+    return ERROR;
+  }
+  decoder.cur++;
+  if (nanocbor_enter_array(&decoder, &arr) < 0 ||
+      nanocbor_skip(&arr) < 0 ||                       // version
+      nanocbor_get_uint32(&arr, &flags) < 0) {
+    return ERROR;
+  }
+  return _priority_of(flags);
+}
+
+int bundle_peek_hop_count(const uint8_t *buffer, size_t buf_len, uint32_t *hop_limit, uint32_t *hop_count)
+{
+  nanocbor_value_t decoder, arr, data;
+  const uint8_t *buf;
+  size_t len;
+  uint32_t type;
+
+  nanocbor_decoder_init(&decoder, buffer, buf_len);
+  if (buf_len < 2 || *decoder.cur != 0x9f) {
+    return ERROR;
+  }
+  decoder.cur++;
+  if (nanocbor_skip(&decoder) < 0) {                   // primary block
+    return ERROR;
+  }
+  while (decoder.cur < buffer + buf_len && *decoder.cur != 0xFF) {
+    if (nanocbor_enter_array(&decoder, &arr) < 0 || nanocbor_get_uint32(&arr, &type) < 0) {
+      return ERROR;
+    }
+    if (type == BUNDLE_BLOCK_TYPE_HOP_COUNT) {
+      if (nanocbor_skip(&arr) < 0 ||                   // block number
+          nanocbor_skip(&arr) < 0 ||                   // flags
+          nanocbor_skip(&arr) < 0 ||                   // crc type
+          nanocbor_get_bstr(&arr, &buf, &len) < 0) {
+        return ERROR;
+      }
+      nanocbor_decoder_init(&decoder, buf, len);
+      if (nanocbor_enter_array(&decoder, &data) < 0 || nanocbor_get_uint32(&data, hop_limit) < 0 ||
+          nanocbor_get_uint32(&data, hop_count) < 0) {
+        return ERROR;
+      }
+      return OK;
+    }
+    if (nanocbor_skip(&decoder) < 0) {
+      return ERROR;
+    }
+  }
+  return ERROR;
+}
+
 int encode_primary_block(struct actual_bundle *bundle, nanocbor_encoder_t *enc)
 {
-  bool isFragment= is_fragment_bundle(bundle);
+  uint8_t *start = enc->cur;
+  size_t start_len = nanocbor_encoded_len(enc);
+  bool isFragment= bundle_is_fragment(bundle);
   if (!isFragment && bundle->primary_block.crc_type == NOCRC) {
     nanocbor_fmt_array(enc, 8);
     nanocbor_fmt_uint(enc, bundle->primary_block.version);
@@ -516,7 +1035,7 @@ int encode_primary_block(struct actual_bundle *bundle, nanocbor_encoder_t *enc)
 
     nanocbor_fmt_uint(enc, bundle->primary_block.lifetime);
 
-    nanocbor_fmt_uint(enc,bundle->primary_block.crc);
+    bundle->primary_block.crc = _encode_crc(enc, start, start_len, bundle->primary_block.crc_type);
   }
   else if (isFragment && bundle->primary_block.crc_type == NOCRC) {
     nanocbor_fmt_array(enc, 10);
@@ -584,8 +1103,6 @@ int encode_primary_block(struct actual_bundle *bundle, nanocbor_encoder_t *enc)
 
     nanocbor_fmt_uint(enc, bundle->primary_block.fragment_offset);
     nanocbor_fmt_uint(enc, bundle->primary_block.total_application_data_length);
-
-    nanocbor_fmt_uint(enc,bundle->primary_block.crc);
   }
   /* 
     isFragment && bundle->primary-block.crc_type != NOCRC
@@ -657,13 +1174,15 @@ int encode_primary_block(struct actual_bundle *bundle, nanocbor_encoder_t *enc)
     nanocbor_fmt_uint(enc, bundle->primary_block.fragment_offset);
     nanocbor_fmt_uint(enc, bundle->primary_block.total_application_data_length);
 
-    nanocbor_fmt_uint(enc,bundle->primary_block.crc);
+    bundle->primary_block.crc = _encode_crc(enc, start, start_len, bundle->primary_block.crc_type);
   }
   return OK;
 }
 
 int encode_canonical_block(struct bundle_canonical_block_t *canonical_block, nanocbor_encoder_t *enc)
 {
+  uint8_t *start = enc->cur;
+  size_t start_len = nanocbor_encoded_len(enc);
   if (canonical_block->crc_type == NOCRC) {
     nanocbor_fmt_array(enc,5);
     nanocbor_fmt_int(enc,canonical_block->type);
@@ -679,198 +1198,18 @@ int encode_canonical_block(struct bundle_canonical_block_t *canonical_block, nan
     nanocbor_fmt_int(enc,canonical_block->flags);
     nanocbor_fmt_int(enc,canonical_block->crc_type);
     nanocbor_put_bstr(enc,canonical_block->block_data, canonical_block->data_len);
-    nanocbor_fmt_int(enc, canonical_block->crc);
+    canonical_block->crc = _encode_crc(enc, start, start_len, canonical_block->crc_type);
   }
   return OK;
 }
 
-uint16_t calculate_crc_16(uint8_t type, void *block)
-{
-  switch(type){
-    case BUNDLE_BLOCK_TYPE_PRIMARY:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-
-      uint16_t crc_val = ucrc16_calc_be(data, required_size, CRC16_FUNCTION, 0xFFFF);
-      DEBUG("bundle: crc_val = %u for data = ", crc_val);
-      for(int i=0;i<(int)required_size;i++){
-        printf("%02x",data[i]);
-      }
-      printf(" .\n");
-      free(data);
-      return crc_val;
-    }
-    break;
-    case BUNDLE_BLOCK_TYPE_CANONICAL:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-      free(data);
-
-      return byteorder_htons(ucrc16_calc_be(data, required_size, CRC16_FUNCTION, 0xFFFF)).u16;
-    }
-    break;
-    default:
-    {
-      return 0;
-    }
-    break;
-  }
-  return 0;
-}
-
-uint32_t calculate_crc_32(uint8_t type, void *block)
-{
-  switch(type){
-    case BUNDLE_BLOCK_TYPE_PRIMARY:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-      uint32_t crc_val = crc32_func(data, required_size, 0x00000000, CRC32_FUNCTION);
-      DEBUG("bundle: crc32_val = %lu for data = ", crc_val);
-      for(int i=0;i<(int)required_size;i++){
-        printf("%02x",data[i]);
-      }
-      printf(" .\n");
-      free(data);
-      return crc_val;
-    }
-    break;
-    case BUNDLE_BLOCK_TYPE_CANONICAL:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-      uint32_t crc_val = crc32_func(data, required_size, 0x00000000, CRC32_FUNCTION);
-      DEBUG("bundle: crc32_val = %lu for data = ", crc_val);
-      for(int i=0;i<(int)required_size;i++){
-        printf("%02x",data[i]);
-      }
-      printf(" .\n");
-      free(data);
-      return crc_val;
-    }
-    break;
-    default:
-    {
-      return 0;
-    }
-    break;
-  }
-  return 0;
-}
-
-bool verify_checksum(void *block, uint8_t type, uint32_t crc) 
-{
-  switch(type){
-    case BUNDLE_BLOCK_TYPE_PRIMARY:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-      uint32_t crc_val = 0;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_primary_block((struct actual_bundle *)block, &enc);
-
-      if (((struct actual_bundle *)block)->primary_block.crc_type == CRC_16){
-        crc_val = ucrc16_calc_be(data, required_size, CRC16_FUNCTION, 0xFFFF);
-      }
-      else if (((struct actual_bundle *)block)->primary_block.crc_type == CRC_32) {
-        crc_val = crc32_func(data, required_size, 0x00000000, CRC32_FUNCTION);
-      }
-      free(data);
-      if (crc_val == crc) {
-        DEBUG("bundle: crc check passed.\n");
-        return true;
-      }
-      else {
-        return false;
-      }
-    }
-    break;
-    case BUNDLE_BLOCK_TYPE_CANONICAL:
-    {
-      uint8_t *data;
-      nanocbor_encoder_t enc;
-      size_t required_size;
-      uint32_t crc_val = 0;
-
-      nanocbor_encoder_init(&enc, NULL, 0);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-      required_size = nanocbor_encoded_len(&enc);
-      data = malloc(required_size);
-      nanocbor_encoder_init(&enc, data, required_size);
-      encode_canonical_block((struct bundle_canonical_block_t *)block, &enc);
-
-      if (((struct actual_bundle *)block)->primary_block.crc_type == CRC_16){
-        crc_val = ucrc16_calc_be(data, required_size, CRC16_FUNCTION, 0xFFFF);
-      }
-      else if (((struct actual_bundle *)block)->primary_block.crc_type == CRC_32) {
-        crc_val = crc32_func(data, required_size, 0x00000000, CRC32_FUNCTION);
-      }
-      free(data);
-      if (crc_val == crc) {
-        DEBUG("bundle: canonical crc check passed.\n");
-        return true;
-      }
-      else {
-        return false;
-      }
-    }
-    break;
-    default:
-    {
-      return false;
-    }
-    break;
-  }
-
-}
-
 void calculate_primary_flag(uint64_t *flag, bool is_fragment, bool dont_fragment)
 {
   if(is_fragment){
     *flag |= FRAGMENT_IDENTIFICATION_MASK;
   }
   if(dont_fragment){
-    *flag |= FRAGMENT_IDENTIFICATION_MASK << 2;
+    *flag |= BUNDLE_DONT_FRAGMENT_MASK;
   }
 
   return ;
@@ -883,18 +1222,28 @@ int calculate_canonical_flag(uint64_t *flag, bool replicate_block)
   return 0;
 }
 
-struct actual_bundle* create_bundle(void)
+static struct actual_bundle* _init_bundle(struct actual_bundle* bundle)
 {
-  struct actual_bundle* bundle = get_space_for_bundle();
   if(bundle == NULL) {
     DEBUG("No more space in the bundle storage for new bundles.\n");
     return NULL;
   }
   bundle->num_of_blocks=0;
-  bundle->local_creation_time = xtimer_usec_from_ticks(xtimer_now());
+  bundle->pkt = NULL;
+  bundle->wire = NULL;
   return bundle;
 }
 
+struct actual_bundle* create_bundle(void)
+{
+  return _init_bundle(get_space_for_bundle());
+}
+
+struct actual_bundle* create_discovery_bundle(void)
+{
+  return _init_bundle(get_space_for_discovery_bundle());
+}
+
 
 int fill_bundle(struct actual_bundle* bundle, int version, uint8_t endpoint_scheme, char* dst_eid, char* report_eid, uint32_t lifetime, int crc_type, char* service_num)
 {
@@ -908,7 +1257,8 @@ int fill_bundle(struct actual_bundle* bundle, int version, uint8_t endpoint_sche
   //Local vars
   uint64_t primary_flag = 0;
   bool is_fragment= check_if_fragment_bundle();
-  bool dont_fragment = true;
+  /* Payloads larger than a link frame are split by bundle_fragment_prepare() */
+  bool dont_fragment = false;
 
   bundle->previous_endpoint_num = INVALID_EID;
   calculate_primary_flag(&primary_flag, is_fragment, dont_fragment);
@@ -998,45 +1348,25 @@ int fill_bundle(struct actual_bundle* bundle, int version, uint8_t endpoint_sche
   }
   
   /*
-    Sets the crc value to be zero by default and is required to be set later inside the convergence layer after encoding 
-    the bundle for the first time
+    The crc itself is calculated while encoding the primary block
   */
   uint32_t zero_crc = 0x00000000;
-  switch(crc_type){
-    case NOCRC:
-      {
-        if(!bundle_set_attribute(bundle, CRC_PRIMARY, &zero_crc)){
-          DEBUG("bundle: Could not set bundle crc.\n");
-          return ERROR;
-        }
-        break;
-      }
-    case CRC_16:
-    {
-      if(!bundle_set_attribute(bundle, CRC_PRIMARY, &zero_crc)){
-        DEBUG("bundle: Could not set bundle crc.\n");
-        return ERROR;
-      }
-      uint16_t crc = calculate_crc_16(BUNDLE_BLOCK_TYPE_PRIMARY, bundle);
-      if(!bundle_set_attribute(bundle, CRC_PRIMARY, &crc)){
-        DEBUG("bundle: Could not set bundle crc.\n");
-        return ERROR;
-      }
-      break;
-    }
-    case CRC_32:
-    {
-      uint32_t crc = calculate_crc_32(BUNDLE_BLOCK_TYPE_PRIMARY, bundle);
-      if(!bundle_set_attribute(bundle, CRC_PRIMARY, &crc)){
-        DEBUG("bundle: Could not set bundle crc.\n");
-        return ERROR;
-      }
-      break;
-    }
+  if(!bundle_set_attribute(bundle, CRC_PRIMARY, &zero_crc)){
+    DEBUG("bundle: Could not set bundle crc.\n");
+    return ERROR;
   }
+  bundle_storage_index(bundle);
   return OK;
 }
 
+/* Bundles created from now on get a sequence number after seq, used when reloading stored bundles */
+void bundle_skip_sequence_num(uint32_t seq)
+{
+  if (seq >= sequence_num) {
+    sequence_num = seq + 1;
+  }
+}
+
 struct bundle_primary_block_t* bundle_get_primary_block(struct actual_bundle* bundle)
 {
   return &(bundle->primary_block);
@@ -1063,38 +1393,77 @@ struct bundle_canonical_block_t* get_block_by_type(struct actual_bundle* bundle,
 
 int bundle_add_block(struct actual_bundle* bundle, uint8_t type, uint64_t flags, uint8_t *data, uint8_t crc_type, size_t data_len)
 {
+  bundle_wire_invalidate(bundle);
   if (bundle->num_of_blocks == MAX_NUM_OF_BLOCKS) {
     DEBUG("bundle: Cannot add more blocks to bundle.\n");
     return ERROR;
   }
+  if (data_len > BLOCK_DATA_BUF_SIZE) {
+    DEBUG("bundle: Block data of %u bytes too large for block.\n", (unsigned)data_len);
+    return BUNDLE_TOO_LARGE_ERROR;
+  }
   struct bundle_canonical_block_t *block = &bundle->other_blocks[bundle->num_of_blocks];
+  /* The payload block stays the last one, blocks added later go in front of it */
+  if (bundle->num_of_blocks > 0 && type != BUNDLE_BLOCK_TYPE_PAYLOAD && block[-1].type == BUNDLE_BLOCK_TYPE_PAYLOAD) {
+    *block = block[-1];
+    block--;
+  }
+  block->block_data = NULL;
+  block->data_len = 0;
+  if (bundle_block_set_data(bundle, block, data, data_len) < 0) {
+    /* move the payload block back */
+    if (block != &bundle->other_blocks[bundle->num_of_blocks]) {
+      *block = block[1];
+    }
+    return ERROR;
+  }
   block->type = type;
   block->flags = flags;
   block->block_number = get_next_block_number();
   block->crc_type = crc_type;
-  switch(crc_type){
-    case NOCRC:
-      {
-        block->crc=0;
-      }
-      break;
-    case CRC_16:
-      {
-        block->crc = calculate_crc_16(BUNDLE_BLOCK_TYPE_CANONICAL, block);
-      }
-      break;
-    case CRC_32:
-      {
-        block->crc = calculate_crc_32(BUNDLE_BLOCK_TYPE_CANONICAL, block);
-      }
-      break;
-  }
-  memcpy(block->block_data, data, data_len);
-  block->data_len = data_len;
+  // calculated while encoding the block
+  block->crc = 0;
   bundle->num_of_blocks++;
   return 1;
 }
 
+static int _block_set_data(struct actual_bundle* bundle, struct bundle_canonical_block_t *block, const uint8_t *data,
+                           size_t len, bool purge)
+{
+  uint8_t *chunk = block->block_data;
+
+  if (bundle_block_pool_chunk_size(chunk) < len) {
+    /* room is made like in a full store, by purging older bundles of at most the same priority */
+    while ((chunk = bundle_block_pool_alloc(len)) == NULL) {
+      if (!purge || len > BLOCK_DATA_BUF_SIZE || !bundle_storage_purge_for(bundle)) {
+        DEBUG("bundle: No block pool chunk for %u bytes of block data.\n", (unsigned)len);
+        return ERROR;
+      }
+    }
+  }
+  if (data != NULL && len > 0) {
+    memmove(chunk, data, len);
+  }
+  if (chunk != block->block_data) {
+    bundle_block_pool_free(block->block_data);
+    block->block_data = chunk;
+  }
+  block->data_len = len;
+  bundle_wire_invalidate(bundle);
+  return OK;
+}
+
+int bundle_block_set_data(struct actual_bundle* bundle, struct bundle_canonical_block_t *block, const uint8_t *data, size_t len)
+{
+  return _block_set_data(bundle, block, data, len, true);
+}
+
+int bundle_block_set_data_nopurge(struct actual_bundle* bundle, struct bundle_canonical_block_t *block,
+                                  const uint8_t *data, size_t len)
+{
+  return _block_set_data(bundle, block, data, len, false);
+}
+
 uint8_t bundle_get_attribute(struct actual_bundle* bundle, uint8_t type, void* val)
 {
   switch(type){
@@ -1184,6 +1553,7 @@ uint8_t bundle_get_attribute(struct actual_bundle* bundle, uint8_t type, void* v
 }
 uint8_t bundle_set_attribute(struct actual_bundle* bundle, uint8_t type, void* val)
 {
+  bundle_wire_invalidate(bundle);
   switch(type){
     case VERSION:
     {
@@ -1272,7 +1642,7 @@ uint8_t bundle_set_attribute(struct actual_bundle* bundle, uint8_t type, void* v
 void print_bundle(struct actual_bundle* bundle)
 {
   (void) bundle;
-  DEBUG("Printing bundle created at %lu.\n", bundle->local_creation_time);
+  DEBUG("Printing bundle created at %" PRIu32 ".\n", bundle->local_creation_time);
   DEBUG("Printing primary block of bundle.\n");
   DEBUG("Bundle primary block version: %d\n", bundle->primary_block.version);
   DEBUG("Bundle primary block flags:");
@@ -1290,22 +1660,22 @@ void print_bundle(struct actual_bundle* bundle)
     }
   }
   else if (bundle->primary_block.endpoint_scheme == IPN) {
-    DEBUG("Bundle primary block dest_num: %lu\n", bundle->primary_block.dst_num);
-    DEBUG("Bundle primary block src_num: %lu\n", bundle->primary_block.src_num);
-    DEBUG("Bundle primary block report_num: %lu\n",bundle->primary_block.report_num);
-    DEBUG("Bundle primary block service_num: %lu\n",bundle->primary_block.service_num);
+    DEBUG("Bundle primary block dest_num: %" PRIu32 "\n", bundle->primary_block.dst_num);
+    DEBUG("Bundle primary block src_num: %" PRIu32 "\n", bundle->primary_block.src_num);
+    DEBUG("Bundle primary block report_num: %" PRIu32 "\n",bundle->primary_block.report_num);
+    DEBUG("Bundle primary block service_num: %" PRIu32 "\n",bundle->primary_block.service_num);
   }
   // DEBUG("Bundle primary block report_eid: %s\n", bundle->primary_block.report_eid == NULL ? 0 :  (char*)bundle->primary_block.report_eid);
-  DEBUG("Bundle primary block creation_timestamp: %ld, %ld\n", bundle->primary_block.creation_timestamp[0], bundle->primary_block.creation_timestamp[1]);
-  DEBUG("Bundle primary block lifetime: %lu\n", bundle->primary_block.lifetime);
-  DEBUG("Bundle primary block fragment_offset: %ld\n", bundle->primary_block.fragment_offset);
-  DEBUG("Bundle primary block total_application_data_length: %ld\n", bundle->primary_block.total_application_data_length);
-  DEBUG("Bundle primary block crc: %ld\n", bundle->primary_block.crc);
+  DEBUG("Bundle primary block creation_timestamp: %" PRIu32 ", %" PRIu32 "\n", bundle->primary_block.creation_timestamp[0], bundle->primary_block.creation_timestamp[1]);
+  DEBUG("Bundle primary block lifetime: %" PRIu32 "\n", bundle->primary_block.lifetime);
+  DEBUG("Bundle primary block fragment_offset: %" PRIu32 "\n", bundle->primary_block.fragment_offset);
+  DEBUG("Bundle primary block total_application_data_length: %" PRIu32 "\n", bundle->primary_block.total_application_data_length);
+  DEBUG("Bundle primary block crc: %" PRIu32 "\n", bundle->primary_block.crc);
 
   struct bundle_canonical_block_t *temp = bundle->other_blocks;
   int i = 0;
   while (i < bundle->num_of_blocks) {
-    DEBUG("Bundle canonical block of type: %d with data_len: %u and data: \n", temp[i].type, temp[i].data_len);
+    DEBUG("Bundle canonical block of type: %d with data_len: %u and data: \n", temp[i].type, (unsigned)temp[i].data_len);
     od_hex_dump(temp[i].block_data, temp[i].data_len, OD_WIDTH_DEFAULT);
 
     i++;
@@ -1313,40 +1683,72 @@ void print_bundle(struct actual_bundle* bundle)
   return ;
 }
 
-int increment_bundle_age(struct bundle_canonical_block_t *bundle_age_block, struct actual_bundle *bundle) {
-  uint32_t usecs_from_bundle = strtoul((char*)bundle_age_block->block_data, NULL, bundle_age_block->data_len);
-  uint32_t updated_time = usecs_from_bundle + (xtimer_now().ticks32 - bundle->local_creation_time);
-  if(updated_time > bundle->primary_block.lifetime) {
-    DEBUG("bundle: lifetime of bundle expired.\n");
-    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
-    // delete_bundle(bundle);
+int bundle_add_age_block(struct actual_bundle *bundle, uint32_t age, uint8_t crc_type)
+{
+  uint8_t data[BUNDLE_AGE_DATA_LEN];
+  uint64_t flags;
+
+  if (calculate_canonical_flag(&flags, false) < 0) {
     return ERROR;
   }
-  sprintf((char*)bundle_age_block->block_data, "%lu", updated_time);
-  return OK;
+  _age_write(data, age);
+  return bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE, flags, data, crc_type, sizeof(data));
+}
+
+int bundle_get_age(struct actual_bundle *bundle, uint32_t *age)
+{
+  struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
+  nanocbor_value_t decoder;
+  uint32_t block_age = 0;
+  int res = ERROR;
+
+  if (block != NULL) {
+    nanocbor_decoder_init(&decoder, block->block_data, block->data_len);
+    res = (nanocbor_get_uint32(&decoder, &block_age) < 0) ? ERROR : OK;
+  }
+  *age = block_age + ((uint32_t)(xtimer_now_usec64() / US_PER_MS) - bundle->local_creation_time);
+  return res;
+}
+
+int bundle_add_hop_count_block(struct actual_bundle *bundle, uint8_t hop_limit, uint8_t crc_type)
+{
+  uint8_t data[BUNDLE_HOP_COUNT_DATA_LEN];
+  uint64_t flags;
+
+  if (calculate_canonical_flag(&flags, false) < 0) {
+    return ERROR;
+  }
+  _hop_count_write(data, hop_limit, 0);
+  return bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_HOP_COUNT, flags, data, crc_type, sizeof(data));
 }
 
-int reset_bundle_age(struct bundle_canonical_block_t *bundle_age_block, uint32_t original_age) {
-  sprintf((char*)bundle_age_block->block_data, "%lu", original_age);
+int bundle_count_hop(struct actual_bundle *bundle)
+{
+  struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_HOP_COUNT);
+
+  /* normalized on decode */
+  if (block == NULL || block->data_len != BUNDLE_HOP_COUNT_DATA_LEN) {
+    return OK;
+  }
+  if (block->block_data[4] >= block->block_data[2]) {
+    DEBUG("bundle: Hop limit of %u exceeded.\n", block->block_data[2]);
+    return ERROR;
+  }
+  block->block_data[4]++;
+  bundle_wire_invalidate(bundle);
   return OK;
 }
 
 bool is_expired_bundle(struct actual_bundle *bundle) {
-  struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
-  if (block != NULL) {
-    uint32_t usecs_from_bundle = strtoul((char*)block->block_data, NULL, block->data_len);
-    if ((usecs_from_bundle + (xtimer_now().ticks32 - bundle->local_creation_time)) >= bundle->primary_block.lifetime) {
-      DEBUG("bundle: Bundle is expired with current age: %lu and lifetime : %lu.\n", (usecs_from_bundle + (xtimer_now().ticks32 - bundle->local_creation_time))
-                                                                                    , bundle->primary_block.lifetime);
-      return true;
-    }
-    else {
-      return false;
-    }
-  }
-  else {
+  uint32_t age;
+  if (bundle_get_age(bundle, &age) < 0) {
     return false;
   }
+  if (age >= bundle->primary_block.lifetime) {
+    DEBUG("bundle: Bundle is expired with current age: %" PRIu32 " and lifetime : %" PRIu32 ".\n", age, bundle->primary_block.lifetime);
+    return true;
+  }
+  return false;
 }
 
 void set_retention_constraint(struct actual_bundle *bundle, uint8_t constraint) {
@@ -1358,23 +1760,6 @@ uint8_t get_retention_constraint(struct actual_bundle *bundle) {
 }
 
 
-uint32_t crc32_func(const void* data, size_t length, uint32_t previousCrc32, uint32_t polynomial) {
-
-  uint32_t crc = ~previousCrc32; 
-  unsigned char* current = (unsigned char*) data;
-  while (length--)
-  {
-    crc ^= *current++;
-    for (unsigned int j = 0; j < 8; j++)
-      if (crc & 1)
-        crc = (crc >> 1) ^ polynomial;
-      else
-        crc =  crc >> 1;
-  }
-  return ~crc;
-}
-
-
 
 /*
  * Dummy functions to check various things
@@ -1386,7 +1771,19 @@ char *get_src_eid(void)
 }
 char *get_src_num(void)
 {
-  return DUMMY_SRC_NUM;
+  return src_num;
+}
+int set_src_num(const char *num)
+{
+  size_t len = strlen(num);
+  char *end;
+
+  if (len == 0 || len >= sizeof(src_num) || num[0] < '0' || num[0] > '9'
+      || strtoull(num, &end, 10) > UINT32_MAX || *end != '\0') {
+    return ERROR;
+  }
+  memcpy(src_num, num, len + 1);
+  return OK;
 }
 bool check_if_fragment_bundle(void)
 {
@@ -0,0 +1,217 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Batched binary acknowledgements implementation
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <string.h>
+
+#include "nanocbor/nanocbor.h"
+
+#include "net/gnrc/bundle_protocol/bundle_ack.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Ack waiting to be sent, unused while l2addr_len is 0 */
+struct ack_entry {
+  uint32_t src_num;
+  uint32_t creation_timestamp[2];
+  uint8_t l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+  uint8_t l2addr_len;
+  /* Interface the acked bundle came in on */
+  kernel_pid_t iface;
+};
+
+static struct ack_entry ack_queue[BUNDLE_ACK_QUEUE_SIZE];
+
+static bool _same_neighbor(const struct ack_entry *entry, const uint8_t *l2addr, size_t l2addr_len, kernel_pid_t iface)
+{
+  return entry->iface == iface && entry->l2addr_len == l2addr_len && memcmp(entry->l2addr, l2addr, l2addr_len) == 0;
+}
+
+static bool _same_group(const struct ack_entry *a, const struct ack_entry *b)
+{
+  return a->src_num == b->src_num && a->creation_timestamp[0] == b->creation_timestamp[0];
+}
+
+/* Orders acks by source, creation time and sequence number, so that groups and ranges are adjacent */
+static int _compare(const struct ack_entry *a, const struct ack_entry *b)
+{
+  if (a->src_num != b->src_num) {
+    return (a->src_num < b->src_num) ? -1 : 1;
+  }
+  if (a->creation_timestamp[0] != b->creation_timestamp[0]) {
+    return (a->creation_timestamp[0] < b->creation_timestamp[0]) ? -1 : 1;
+  }
+  if (a->creation_timestamp[1] != b->creation_timestamp[1]) {
+    return (a->creation_timestamp[1] < b->creation_timestamp[1]) ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Number of ranges of consecutive sequence numbers in the group starting at batch[0], sets its size */
+static unsigned _group_ranges(struct ack_entry **batch, unsigned num, unsigned *size)
+{
+  unsigned ranges = 1, i = 1;
+
+  for (; i < num && _same_group(batch[0], batch[i]); i++) {
+    if (batch[i]->creation_timestamp[1] != batch[i - 1]->creation_timestamp[1] + 1) {
+      ranges++;
+    }
+  }
+  *size = i;
+  return ranges;
+}
+
+/* Encodes the first num acks of the sorted batch, returns the number of groups */
+static unsigned _encode(nanocbor_encoder_t *enc, struct ack_entry **batch, unsigned num)
+{
+  unsigned groups = 0, size;
+
+  for (unsigned i = 0; i < num; i += size) {
+    _group_ranges(&batch[i], num - i, &size);
+    groups++;
+  }
+  nanocbor_fmt_array(enc, 1 + groups);
+  nanocbor_fmt_uint(enc, BUNDLE_ACK_FRAME_TYPE);
+  for (unsigned i = 0; i < num; i += size) {
+    unsigned ranges = _group_ranges(&batch[i], num - i, &size);
+    nanocbor_fmt_array(enc, 2 + 2 * ranges);
+    nanocbor_fmt_uint(enc, batch[i]->src_num);
+    nanocbor_fmt_uint(enc, batch[i]->creation_timestamp[0]);
+    for (unsigned start = 0, j = 1; j <= size; j++) {
+      if (j == size || batch[i + j]->creation_timestamp[1] != batch[i + j - 1]->creation_timestamp[1] + 1) {
+        nanocbor_fmt_uint(enc, batch[i + start]->creation_timestamp[1]);
+        nanocbor_fmt_uint(enc, j - start);
+        start = j;
+      }
+    }
+  }
+  return groups;
+}
+
+bool bundle_ack_is_frame(const uint8_t *buf, size_t len)
+{
+  return len >= 2 && buf[0] > 0x81 && buf[0] <= 0x81 + BUNDLE_ACK_MAX_GROUPS && buf[1] == BUNDLE_ACK_FRAME_TYPE;
+}
+
+int bundle_ack_queue(const struct bundle_id *id, const uint8_t *l2addr, size_t l2addr_len, kernel_pid_t iface)
+{
+  struct ack_entry *free_entry = NULL;
+  int free_entries = 0;
+  bool queued = false;
+
+  if (l2addr_len == 0 || l2addr_len > GNRC_NETIF_L2ADDR_MAXLEN) {
+    return ERROR;
+  }
+  for (unsigned i = 0; i < BUNDLE_ACK_QUEUE_SIZE; i++) {
+    struct ack_entry *entry = &ack_queue[i];
+    if (entry->l2addr_len == 0) {
+      free_entry = (free_entry == NULL) ? entry : free_entry;
+      free_entries++;
+    }
+    else if (entry->src_num == id->src_num && entry->creation_timestamp[0] == id->creation_timestamp[0] &&
+             entry->creation_timestamp[1] == id->creation_timestamp[1] &&
+             _same_neighbor(entry, l2addr, l2addr_len, iface)) {
+      queued = true;
+    }
+  }
+  if (queued) {
+    DEBUG("bundle_ack: Ack already queued.\n");
+    return free_entries;
+  }
+  if (free_entry == NULL) {
+    DEBUG("bundle_ack: Ack queue is full.\n");
+    return ERROR;
+  }
+  free_entry->src_num = id->src_num;
+  free_entry->creation_timestamp[0] = id->creation_timestamp[0];
+  free_entry->creation_timestamp[1] = id->creation_timestamp[1];
+  memcpy(free_entry->l2addr, l2addr, l2addr_len);
+  free_entry->l2addr_len = l2addr_len;
+  free_entry->iface = iface;
+  return free_entries - 1;
+}
+
+int bundle_ack_encode_next(uint8_t *buf, size_t len, uint8_t *l2addr, size_t *l2addr_len, kernel_pid_t *iface)
+{
+  struct ack_entry *batch[BUNDLE_ACK_QUEUE_SIZE];
+  unsigned num = 0;
+
+  /* acks to the neighbor of the first queued one, sorted by insertion */
+  for (unsigned i = 0; i < BUNDLE_ACK_QUEUE_SIZE; i++) {
+    struct ack_entry *entry = &ack_queue[i];
+    if (entry->l2addr_len == 0 || (num > 0 && !_same_neighbor(entry, batch[0]->l2addr, batch[0]->l2addr_len, batch[0]->iface))) {
+      continue;
+    }
+    unsigned j = num++;
+    while (j > 0 && _compare(batch[j - 1], entry) > 0) {
+      batch[j] = batch[j - 1];
+      j--;
+    }
+    batch[j] = entry;
+  }
+  if (num == 0) {
+    return 0;
+  }
+  memcpy(l2addr, batch[0]->l2addr, batch[0]->l2addr_len);
+  *l2addr_len = batch[0]->l2addr_len;
+  *iface = batch[0]->iface;
+
+  /* the longest sorted prefix that fits, the rest goes into the next frame */
+  nanocbor_encoder_t enc;
+  for (; num > 0; num--) {
+    nanocbor_encoder_init(&enc, NULL, 0);
+    if (_encode(&enc, batch, num) <= BUNDLE_ACK_MAX_GROUPS && nanocbor_encoded_len(&enc) <= len) {
+      break;
+    }
+  }
+  if (num == 0) {
+    DEBUG("bundle_ack: No room for a single ack in %u bytes.\n", (unsigned)len);
+    return ERROR;
+  }
+  nanocbor_encoder_init(&enc, buf, len);
+  _encode(&enc, batch, num);
+  for (unsigned i = 0; i < num; i++) {
+    batch[i]->l2addr_len = 0;
+  }
+  return nanocbor_encoded_len(&enc);
+}
+
+int bundle_ack_decode(const uint8_t *buf, size_t len, bundle_ack_range_t range, void *arg)
+{
+  nanocbor_value_t decoder, frame, group;
+  uint32_t type, src_num, creation_timestamp0, start, count;
+  int ranges = 0;
+
+  if (!bundle_ack_is_frame(buf, len)) {
+    return ERROR;
+  }
+  nanocbor_decoder_init(&decoder, buf, len);
+  if (nanocbor_enter_array(&decoder, &frame) < 0 || nanocbor_get_uint32(&frame, &type) < 0) {
+    return ERROR;
+  }
+  while (!nanocbor_at_end(&frame)) {
+    if (nanocbor_enter_array(&frame, &group) < 0 || nanocbor_get_uint32(&group, &src_num) < 0 ||
+        nanocbor_get_uint32(&group, &creation_timestamp0) < 0) {
+      DEBUG("bundle_ack: Malformed ack group.\n");
+      return ERROR;
+    }
+    while (!nanocbor_at_end(&group)) {
+      if (nanocbor_get_uint32(&group, &start) < 0 || nanocbor_get_uint32(&group, &count) < 0) {
+        DEBUG("bundle_ack: Malformed ack range.\n");
+        return ERROR;
+      }
+      range(arg, src_num, creation_timestamp0, start, count);
+      ranges++;
+    }
+    nanocbor_leave_container(&frame, &group);
+  }
+  return ranges;
+}
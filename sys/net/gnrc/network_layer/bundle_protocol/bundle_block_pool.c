@@ -0,0 +1,135 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Block data pool implementation
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "memarray.h"
+
+#include "net/gnrc/bundle_protocol/bundle_block_pool.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+#if BUNDLE_BLOCK_POOL_SMALL_SIZE < 1 || BUNDLE_BLOCK_POOL_SMALL_SIZE > BUNDLE_BLOCK_POOL_MEDIUM_SIZE || \
+    BUNDLE_BLOCK_POOL_MEDIUM_SIZE > BLOCK_DATA_BUF_SIZE
+#error "Block pool classes have to grow from BUNDLE_BLOCK_POOL_SMALL_SIZE to BLOCK_DATA_BUF_SIZE"
+#endif
+
+#define SMALL_STRIDE BUNDLE_BLOCK_POOL_STRIDE(BUNDLE_BLOCK_POOL_SMALL_SIZE)
+#define MEDIUM_STRIDE BUNDLE_BLOCK_POOL_STRIDE(BUNDLE_BLOCK_POOL_MEDIUM_SIZE)
+#define LARGE_STRIDE BUNDLE_BLOCK_POOL_STRIDE(BLOCK_DATA_BUF_SIZE)
+
+struct block_class {
+  memarray_t mem;
+  uint8_t *data;
+  uint16_t size;
+  uint16_t stride;
+  uint16_t num;
+  uint16_t used;
+  uint16_t peak;
+  uint32_t full;
+};
+
+/* Arrays of pointers, so that every chunk is pointer aligned */
+static void *small_data[BUNDLE_BLOCK_POOL_SMALL_NUM * SMALL_STRIDE / sizeof(void *)];
+static void *medium_data[BUNDLE_BLOCK_POOL_MEDIUM_NUM * MEDIUM_STRIDE / sizeof(void *)];
+static void *large_data[BUNDLE_BLOCK_POOL_LARGE_NUM * LARGE_STRIDE / sizeof(void *)];
+
+/* Ordered by size, allocation takes the first one with room */
+static struct block_class classes[BUNDLE_BLOCK_POOL_CLASSES] = {
+  { .data = (uint8_t *)small_data, .size = BUNDLE_BLOCK_POOL_SMALL_SIZE, .stride = SMALL_STRIDE,
+    .num = BUNDLE_BLOCK_POOL_SMALL_NUM },
+  { .data = (uint8_t *)medium_data, .size = BUNDLE_BLOCK_POOL_MEDIUM_SIZE, .stride = MEDIUM_STRIDE,
+    .num = BUNDLE_BLOCK_POOL_MEDIUM_NUM },
+  { .data = (uint8_t *)large_data, .size = BLOCK_DATA_BUF_SIZE, .stride = LARGE_STRIDE,
+    .num = BUNDLE_BLOCK_POOL_LARGE_NUM },
+};
+
+void bundle_block_pool_init(void)
+{
+  for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_CLASSES; i++) {
+    memarray_init(&classes[i].mem, classes[i].data, classes[i].stride, classes[i].num);
+    classes[i].used = 0;
+    classes[i].peak = 0;
+    classes[i].full = 0;
+  }
+}
+
+static struct block_class *class_of(const uint8_t *data)
+{
+  for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_CLASSES; i++) {
+    struct block_class *cls = &classes[i];
+    if (data >= cls->data && data < cls->data + cls->num * cls->stride) {
+      return ((data - cls->data) % cls->stride == 0) ? cls : NULL;
+    }
+  }
+  return NULL;
+}
+
+uint8_t *bundle_block_pool_alloc(size_t len)
+{
+  for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_CLASSES; i++) {
+    struct block_class *cls = &classes[i];
+    if (len > cls->size) {
+      continue;
+    }
+    uint8_t *chunk = memarray_alloc(&cls->mem);
+    if (chunk != NULL) {
+      cls->used++;
+      if (cls->used > cls->peak) {
+        cls->peak = cls->used;
+      }
+      return chunk;
+    }
+    cls->full++;
+  }
+  DEBUG("bundle_block_pool: No chunk left for %u bytes.\n", (unsigned)len);
+  return NULL;
+}
+
+void bundle_block_pool_free(uint8_t *data)
+{
+  struct block_class *cls = class_of(data);
+
+  if (cls == NULL) {
+    return ;
+  }
+  memarray_free(&cls->mem, data);
+  cls->used--;
+}
+
+size_t bundle_block_pool_chunk_size(const uint8_t *data)
+{
+  struct block_class *cls = class_of(data);
+
+  return (cls != NULL) ? cls->size : 0;
+}
+
+void bundle_block_pool_stats(unsigned cls, struct bundle_block_pool_stats *stats)
+{
+  stats->size = classes[cls].size;
+  stats->num = classes[cls].num;
+  stats->used = classes[cls].used;
+  stats->peak = classes[cls].peak;
+  stats->full = classes[cls].full;
+}
+
+void bundle_block_pool_print(void)
+{
+  printf("%-22s %u x %u bytes\n", "bundle slots", (unsigned)MAX_BUNDLES, (unsigned)sizeof(struct bundle_list));
+  printf("%-22s %u bytes\n", "block pool", (unsigned)BUNDLE_BLOCK_POOL_BYTES);
+  printf("%-22s %10s %10s %10s %10s %10s\n", "", "size", "num", "used", "peak", "full");
+  for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_CLASSES; i++) {
+    printf("%-22s %10u %10u %10u %10u %10" PRIu32 "\n", "block chunks", classes[i].size, classes[i].num,
+           classes[i].used, classes[i].peak, classes[i].full);
+  }
+}
@@ -0,0 +1,342 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Bundle fragmentation and reassembly implementation
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <inttypes.h>
+#include <string.h>
+
+#include "xtimer.h"
+
+#include "net/gnrc/bundle_protocol/bundle_fragment.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Received byte range [start, end) of a payload, unused while end is 0 */
+struct reassembly_int {
+  struct reassembly_int *next;
+  uint32_t start;
+  uint32_t end;
+};
+
+/* Payload under reassembly, unused while size is 0. pkt holds the payload unless it is streamed */
+struct reassembly_entry {
+  struct reassembly_int *ints;
+  gnrc_pktsnip_t *pkt;
+  uint32_t src_num;
+  uint32_t creation_timestamp[2];
+  uint32_t arrival;
+  uint32_t size;
+  uint32_t current_size;
+};
+
+static struct reassembly_entry reassembly_buf[BUNDLE_REASSEMBLY_SIZE];
+static struct reassembly_int reassembly_ints[BUNDLE_REASSEMBLY_INT_SIZE];
+/* Last completed payload, kept until the next one completes since applications get a pointer to it */
+static gnrc_pktsnip_t *completed_payload = NULL;
+
+static size_t cbor_head_len(size_t val)
+{
+  if (val < 24) {
+    return 1;
+  }
+  if (val <= UINT8_MAX) {
+    return 2;
+  }
+  if (val <= UINT16_MAX) {
+    return 3;
+  }
+  return 5;
+}
+
+int bundle_fragment_prepare(struct actual_bundle *bundle, size_t len, uint64_t payload_flag, uint8_t crc_type,
+                            size_t mtu)
+{
+  /* Sized with an empty payload block, the payload adds its bytes and possibly a longer head */
+  if (bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, payload_flag, NULL, crc_type, 0) < 0) {
+    DEBUG("bundle_fragment: Could not add payload block.\n");
+    return ERROR;
+  }
+  size_t whole_len = bundle_encoded_len(bundle) - 1 + cbor_head_len(len) + len;
+  if (len <= BLOCK_DATA_BUF_SIZE && whole_len <= mtu) {
+    return len;
+  }
+
+  if (bundle->primary_block.endpoint_scheme != IPN || (bundle->primary_block.flags & BUNDLE_DONT_FRAGMENT_MASK)
+      || (uint64_t)len > UINT32_MAX) {
+    DEBUG("bundle_fragment: Payload of %u bytes does not fit and bundle cannot be fragmented.\n", (unsigned)len);
+    bundle->num_of_blocks--;
+    return BUNDLE_TOO_LARGE_ERROR;
+  }
+
+  /* The offset of every fragment encodes to at most the size of the total length */
+  uint64_t flags = bundle->primary_block.flags;
+  bundle->primary_block.flags |= FRAGMENT_IDENTIFICATION_MASK;
+  bundle->primary_block.fragment_offset = len;
+  bundle->primary_block.total_application_data_length = len;
+  size_t overhead = bundle_encoded_len(bundle) - 1 + cbor_head_len(len);
+  bundle->primary_block.fragment_offset = 0;
+  if (overhead >= mtu) {
+    DEBUG("bundle_fragment: No room for payload in a link frame of %u bytes.\n", (unsigned)mtu);
+    bundle->num_of_blocks--;
+    bundle->primary_block.flags = flags;
+    bundle->primary_block.total_application_data_length = 0;
+    return BUNDLE_TOO_LARGE_ERROR;
+  }
+  size_t fragment_len = mtu - overhead;
+  if (fragment_len > BLOCK_DATA_BUF_SIZE) {
+    fragment_len = BLOCK_DATA_BUF_SIZE;
+  }
+  DEBUG("bundle_fragment: Splitting payload of %u bytes into fragments of %u bytes.\n", (unsigned)len,
+        (unsigned)fragment_len);
+  return fragment_len;
+}
+
+int bundle_fragment_fill(struct actual_bundle *fragment, struct actual_bundle *from, size_t offset, size_t len,
+                         bundle_payload_read_t read, void *arg)
+{
+  if (len > BLOCK_DATA_BUF_SIZE) {
+    return BUNDLE_TOO_LARGE_ERROR;
+  }
+  if (fragment != from) {
+    fragment->primary_block = from->primary_block;
+    fragment->previous_endpoint_num = from->previous_endpoint_num;
+    for (int i = 0; i < from->num_of_blocks; i++) {
+      struct bundle_canonical_block_t *block = &fragment->other_blocks[i];
+      *block = from->other_blocks[i];
+      block->block_data = NULL;
+      /* the payload is read below */
+      if (bundle_block_set_data(fragment, block, from->other_blocks[i].block_data,
+                                (i < from->num_of_blocks - 1) ? block->data_len : 0) < 0) {
+        return ERROR;
+      }
+      fragment->num_of_blocks = i + 1;
+    }
+  }
+  if (bundle_is_fragment(fragment)) {
+    fragment->primary_block.fragment_offset = offset;
+  }
+  /* The payload block is the last one, read straight into the chunk it is encoded from */
+  struct bundle_canonical_block_t *payload_block = &fragment->other_blocks[fragment->num_of_blocks - 1];
+  if (bundle_block_set_data(fragment, payload_block, NULL, len) < 0) {
+    return ERROR;
+  }
+  if (len > 0 && read(arg, offset, payload_block->block_data, len) < 0) {
+    DEBUG("bundle_fragment: Could not read %u payload bytes at %u.\n", (unsigned)len, (unsigned)offset);
+    return ERROR;
+  }
+  payload_block->data_len = len;
+  if (fragment != from) {
+    bundle_storage_index(fragment);
+  }
+  return OK;
+}
+
+static struct reassembly_int *int_alloc(void)
+{
+  for (unsigned i = 0; i < BUNDLE_REASSEMBLY_INT_SIZE; i++) {
+    if (reassembly_ints[i].end == 0) {
+      return &reassembly_ints[i];
+    }
+  }
+  return NULL;
+}
+
+static void entry_free(struct reassembly_entry *entry)
+{
+  struct reassembly_int *temp = entry->ints;
+  while (temp != NULL) {
+    struct reassembly_int *next = temp->next;
+    temp->next = NULL;
+    temp->end = 0;
+    temp = next;
+  }
+  if (entry->pkt != NULL) {
+    gnrc_pktbuf_release(entry->pkt);
+  }
+  memset(entry, 0, sizeof(*entry));
+}
+
+/*
+ * Adds [start, end) to the sorted ranges of entry, merging it with every range it overlaps or
+ * touches, so a complete payload is a single range.
+ */
+static int entry_add_int(struct reassembly_entry *entry, uint32_t start, uint32_t end)
+{
+  struct reassembly_int **prev = &entry->ints, *cur;
+  while (*prev != NULL && (*prev)->end < start) {
+    prev = &(*prev)->next;
+  }
+  cur = *prev;
+  if (cur == NULL || cur->start > end) {
+    struct reassembly_int *new_int = int_alloc();
+    if (new_int == NULL) {
+      return ERROR;
+    }
+    new_int->start = start;
+    new_int->end = end;
+    new_int->next = cur;
+    *prev = new_int;
+  }
+  else {
+    if (start < cur->start) {
+      cur->start = start;
+    }
+    if (end > cur->end) {
+      cur->end = end;
+    }
+    while (cur->next != NULL && cur->next->start <= cur->end) {
+      struct reassembly_int *next = cur->next;
+      if (next->end > cur->end) {
+        cur->end = next->end;
+      }
+      cur->next = next->next;
+      next->next = NULL;
+      next->end = 0;
+    }
+  }
+
+  entry->current_size = 0;
+  for (cur = entry->ints; cur != NULL; cur = cur->next) {
+    entry->current_size += cur->end - cur->start;
+  }
+  return OK;
+}
+
+static void reassembly_gc(uint32_t now)
+{
+  for (unsigned i = 0; i < BUNDLE_REASSEMBLY_SIZE; i++) {
+    if (reassembly_buf[i].size != 0 && now - reassembly_buf[i].arrival > BUNDLE_REASSEMBLY_TIMEOUT_USEC) {
+      DEBUG("bundle_fragment: Reassembly of bundle from %" PRIu32 " timed out.\n", reassembly_buf[i].src_num);
+      entry_free(&reassembly_buf[i]);
+    }
+  }
+}
+
+/*
+ * Finds the entry of the payload the fragment belongs to or starts a new one, evicting the oldest
+ * entry if all are in use. Only buffered entries hold a copy of the payload.
+ */
+static struct reassembly_entry *reassembly_get(struct actual_bundle *fragment, bool buffered)
+{
+  struct bundle_primary_block_t *primary = &fragment->primary_block;
+  struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(fragment);
+  uint32_t offset = primary->fragment_offset, total = primary->total_application_data_length;
+
+  if (!bundle_is_fragment(fragment) || primary->endpoint_scheme != IPN || payload_block == NULL
+      || payload_block->data_len == 0 || offset >= total || payload_block->data_len > total - offset
+      || (buffered && total > BUNDLE_REASSEMBLY_MAX_SIZE)) {
+    DEBUG("bundle_fragment: Invalid fragment, dropping it.\n");
+    return NULL;
+  }
+
+  uint32_t now = xtimer_now_usec();
+  reassembly_gc(now);
+  struct reassembly_entry *res = NULL, *oldest = NULL;
+  for (unsigned i = 0; i < BUNDLE_REASSEMBLY_SIZE; i++) {
+    struct reassembly_entry *entry = &reassembly_buf[i];
+    if (entry->size == 0) {
+      if (res == NULL) {
+        res = entry;
+      }
+      continue;
+    }
+    if (entry->src_num == primary->src_num && entry->size == total
+        && entry->creation_timestamp[0] == primary->creation_timestamp[0]
+        && entry->creation_timestamp[1] == primary->creation_timestamp[1]) {
+      entry->arrival = now;
+      return entry;
+    }
+    if (oldest == NULL || now - entry->arrival > now - oldest->arrival) {
+      oldest = entry;
+    }
+  }
+  if (res == NULL) {
+    DEBUG("bundle_fragment: Reassembly buffer full, dropping bundle from %" PRIu32 ".\n", oldest->src_num);
+    entry_free(oldest);
+    res = oldest;
+  }
+  if (buffered && (res->pkt = gnrc_pktbuf_add(NULL, NULL, total, GNRC_NETTYPE_UNDEF)) == NULL) {
+    DEBUG("bundle_fragment: No space to reassemble bundle.\n");
+    return NULL;
+  }
+  res->size = total;
+  res->src_num = primary->src_num;
+  res->creation_timestamp[0] = primary->creation_timestamp[0];
+  res->creation_timestamp[1] = primary->creation_timestamp[1];
+  res->arrival = now;
+  return res;
+}
+
+/* Records the range of the fragment, returns 0 while incomplete, OK once complete or ERROR */
+static int reassembly_update(struct reassembly_entry *entry, uint32_t offset, size_t len)
+{
+  if (entry_add_int(entry, offset, offset + len) < 0) {
+    DEBUG("bundle_fragment: Out of reassembly intervals, dropping bundle.\n");
+    entry_free(entry);
+    return ERROR;
+  }
+  return (entry->current_size < entry->size) ? 0 : OK;
+}
+
+int bundle_reassembly_add(struct actual_bundle *fragment, gnrc_pktsnip_t **payload)
+{
+  struct reassembly_entry *entry = reassembly_get(fragment, true);
+  if (entry == NULL) {
+    return ERROR;
+  }
+  struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(fragment);
+  uint32_t offset = fragment->primary_block.fragment_offset;
+  memcpy((uint8_t *)entry->pkt->data + offset, payload_block->block_data, payload_block->data_len);
+  int res = reassembly_update(entry, offset, payload_block->data_len);
+  if (res != OK) {
+    return res;
+  }
+
+  if (completed_payload != NULL) {
+    gnrc_pktbuf_release(completed_payload);
+  }
+  completed_payload = entry->pkt;
+  entry->pkt = NULL;
+  entry_free(entry);
+  *payload = completed_payload;
+  return OK;
+}
+
+int bundle_reassembly_stream(struct actual_bundle *fragment, bundle_payload_write_t write, void *arg)
+{
+  struct reassembly_entry *entry = reassembly_get(fragment, false);
+  if (entry == NULL) {
+    return ERROR;
+  }
+  struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(fragment);
+  uint32_t offset = fragment->primary_block.fragment_offset;
+  int res = reassembly_update(entry, offset, payload_block->data_len);
+  if (res < 0) {
+    return ERROR;
+  }
+  /* Identifies the whole payload rather than this fragment */
+  struct bundle_id id;
+  bundle_get_id(fragment, &id);
+  id.fragment_offset = 0;
+  write(arg, &id, offset, payload_block->block_data, payload_block->data_len, res == OK);
+  if (res == OK) {
+    entry_free(entry);
+  }
+  return res;
+}
+
+void bundle_reassembly_reset(void)
+{
+  for (unsigned i = 0; i < BUNDLE_REASSEMBLY_SIZE; i++) {
+    entry_free(&reassembly_buf[i]);
+  }
+}
@@ -9,24 +9,199 @@
  *
  * @}
  */
+#include <inttypes.h>
+#include <string.h>
+
+#include "bloom.h"
+#include "hashes.h"
+#include "kernel_defines.h"
 #include "random.h"
+#include "thread.h"
 #include "utlist.h"
+#include "xtimer.h"
 
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_block_pool.h"
+#include "net/gnrc/bundle_protocol/metrics.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+#if PROCESSED_BUNDLES_FP_EXP < 1 || PROCESSED_BUNDLES_FP_EXP > 8
+#error "PROCESSED_BUNDLES_FP_EXP has to be between 1 and 8"
+#endif
+
+#if BUNDLE_STORAGE_DISCOVERY_SLOTS >= MAX_BUNDLES
+#error "BUNDLE_STORAGE_DISCOVERY_SLOTS has to leave slots for bundles"
+#endif
+
+struct bundle_storage_backend *this_storage_backend = NULL;
+
 static uint8_t next_block_number = 0;
 struct bundle_list* free_list;
 struct bundle_list* head_of_store;
-static uint8_t active_bundles = 0;
+static uint16_t active_bundles = 0;
+/* Of active_bundles */
+static uint16_t discovery_bundles = 0;
+/* Deleting bundles from other threads would change the store while it walks it */
+static kernel_pid_t purge_pid = KERNEL_PID_UNDEF;
+
+/*
+ * Open addressing (linear probing) index over the bundle id. Slots hash on the source and
+ * creation timestamp only, so that acknowledgements, which do not carry the fragment fields,
+ * can be looked up as well. Always has free slots since it is larger than MAX_BUNDLES.
+ */
+static struct bundle_list *bundle_index[BUNDLE_INDEX_SIZE];
+
+/*
+ * Min-heap of the stored bundles on priority class and then local_creation_time, the root is
+ * purged first
+ */
+static struct bundle_list *purge_heap[MAX_BUNDLES];
+
+/*
+ * Bundles already processed by this node are remembered in a pair of bloom filters. New ids go
+ * into the current filter, lookups check both. Once the current filter holds
+ * PROCESSED_BUNDLES_CAPACITY ids or PROCESSED_BUNDLES_AGING_USEC have passed, the older filter is
+ * cleared and becomes the current one, so ids are forgotten after one to two rotations.
+ */
+static uint8_t processed_bits[2][PROCESSED_BUNDLES_BLOOM_BYTES];
+static bloom_t processed_filter[2];
+static uint8_t processed_current;
+static uint16_t processed_count;
+static uint32_t processed_rotated_at;
+
+/* bloom takes the length as int, sys/hashes as size_t */
+#define PROCESSED_HASH(hash) \
+  static uint32_t processed_##hash(const uint8_t *buf, int len) { return hash(buf, len); }
+PROCESSED_HASH(fnv_hash)
+PROCESSED_HASH(sax_hash)
+PROCESSED_HASH(sdbm_hash)
+PROCESSED_HASH(djb2_hash)
+PROCESSED_HASH(kr_hash)
+PROCESSED_HASH(dek_hash)
+PROCESSED_HASH(rotating_hash)
+PROCESSED_HASH(one_at_a_time_hash)
+
+static hashfp_t processed_hashes[] = {
+  processed_fnv_hash, processed_sax_hash, processed_sdbm_hash, processed_djb2_hash,
+  processed_kr_hash, processed_dek_hash, processed_rotating_hash, processed_one_at_a_time_hash,
+};
+
+static void processed_bundles_init(void);
+static int restore_bundle(gnrc_pktsnip_t *pkt, uint32_t previous_endpoint_num, int slot);
+
+static unsigned index_hash(uint32_t src_num, uint32_t creation_timestamp0, uint32_t creation_timestamp1)
+{
+  uint32_t hash = src_num * 0x9E3779B1;
+  hash = (hash ^ creation_timestamp0) * 0x85EBCA6B;
+  hash = (hash ^ creation_timestamp1) * 0xC2B2AE35;
+  hash ^= hash >> 16;
+  return hash % BUNDLE_INDEX_SIZE;
+}
+
+static unsigned index_slot_of(struct actual_bundle *bundle)
+{
+  return index_hash(bundle->primary_block.src_num, bundle->primary_block.creation_timestamp[0],
+                    bundle->primary_block.creation_timestamp[1]);
+}
+
+static int index_find(struct bundle_list *node)
+{
+  unsigned i = index_slot_of(&node->current_bundle);
+  while (bundle_index[i] != NULL) {
+    if (bundle_index[i] == node) {
+      return i;
+    }
+    i = (i + 1) % BUNDLE_INDEX_SIZE;
+  }
+  return -1;
+}
+
+static void index_remove(struct bundle_list *node)
+{
+  int res = index_find(node);
+  if (res < 0) {
+    return;
+  }
+  /* backward shift deletion, moves later entries of the probe sequence into the hole */
+  unsigned hole = res, i = res;
+  while (1) {
+    i = (i + 1) % BUNDLE_INDEX_SIZE;
+    if (bundle_index[i] == NULL) {
+      break;
+    }
+    unsigned home = index_slot_of(&bundle_index[i]->current_bundle);
+    bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+    if (!stays) {
+      bundle_index[hole] = bundle_index[i];
+      hole = i;
+    }
+  }
+  bundle_index[hole] = NULL;
+}
+
+static void heap_swap(uint16_t a, uint16_t b)
+{
+  struct bundle_list *temp = purge_heap[a];
+  purge_heap[a] = purge_heap[b];
+  purge_heap[b] = temp;
+  purge_heap[a]->heap_pos = a;
+  purge_heap[b]->heap_pos = b;
+}
+
+static bool heap_less(uint16_t a, uint16_t b)
+{
+  struct actual_bundle *bundle_a = &purge_heap[a]->current_bundle, *bundle_b = &purge_heap[b]->current_bundle;
+  uint8_t priority_a = bundle_get_priority(bundle_a), priority_b = bundle_get_priority(bundle_b);
+
+  /* discovery bundles stay below the root, they have slots of their own */
+  if (purge_heap[a]->discovery != purge_heap[b]->discovery) {
+    return purge_heap[b]->discovery;
+  }
+  if (priority_a != priority_b) {
+    return priority_a < priority_b;
+  }
+  return bundle_a->local_creation_time < bundle_b->local_creation_time;
+}
+
+static void heap_sift_up(uint16_t pos)
+{
+  while (pos > 0 && heap_less(pos, (pos - 1) / 2)) {
+    heap_swap(pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+}
 
-struct processed_bundle_list *head_processed_list_ptr;
-static uint8_t num_processed_list = 0;
+static void heap_sift_down(uint16_t pos, uint16_t size)
+{
+  while (1) {
+    uint16_t smallest = pos, left = 2 * pos + 1, right = 2 * pos + 2;
+    if (left < size && heap_less(left, smallest)) {
+      smallest = left;
+    }
+    if (right < size && heap_less(right, smallest)) {
+      smallest = right;
+    }
+    if (smallest == pos) {
+      return;
+    }
+    heap_swap(pos, smallest);
+    pos = smallest;
+  }
+}
 
-static void delete_oldest(void);
+/* Has to be called before active_bundles is decremented */
+static void heap_remove(struct bundle_list *node)
+{
+  uint16_t pos = node->heap_pos, last = active_bundles - 1;
+  if (pos != last) {
+    heap_swap(pos, last);
+    heap_sift_down(pos, last);
+    heap_sift_up(pos);
+  }
+}
 
 struct bundle_list* bundle_storage_init(void)
 {
@@ -37,34 +212,60 @@ struct bundle_list* bundle_storage_init(void)
   }
   free_list[MAX_BUNDLES-1].next = NULL;
   free_list[MAX_BUNDLES-1].unique_id = 0;
-  head_of_store = free_list;
+  head_of_store = NULL;
+  active_bundles = 0;
+  discovery_bundles = 0;
   next_block_number = 0;
+  memset(bundle_index, 0, sizeof(bundle_index));
+  bundle_block_pool_init();
+  processed_bundles_init();
 
   random_init(RANDOM_SEED_DEFAULT);
 
+  if (get_storage_backend() != NULL) {
+    int restored = get_storage_backend()->restore(restore_bundle);
+    DEBUG("bundle_storage: Restored %d bundles from persistent storage.\n", restored);
+    (void)restored;
+  }
+
   return free_list;
 }
 
-struct actual_bundle* get_space_for_bundle(void)
+/* Only run when the store is full, not on every allocation */
+static void delete_expired_bundles(void)
 {
-  struct bundle_list *temp = head_of_store;
-  int i = 0;
-  while(temp != NULL && i < active_bundles) {
+  struct bundle_list *temp, *next;
+  DL_FOREACH_SAFE(head_of_store, temp, next) {
     if (is_expired_bundle(&temp->current_bundle)) {
       set_retention_constraint(&temp->current_bundle, NO_RETENTION_CONSTRAINT);
-      // get_router()->notify_bundle_deletion(&temp->current_bundle);
       delete_bundle(&temp->current_bundle);
     }
-    temp = temp->next;
-    i++;
   }
+}
+
+/* Whether a bundle of the kind fits without deleting another one, bundles leave the discovery slots free */
+static bool _has_free_slot(bool discovery)
+{
+  return free_list != NULL &&
+         (discovery || active_bundles - discovery_bundles < MAX_BUNDLES - BUNDLE_STORAGE_DISCOVERY_SLOTS);
+}
+
+static struct actual_bundle* _get_space(bool discovery)
+{
   struct bundle_list *ret = NULL;
-  if(free_list == NULL){
-    DEBUG("bundle_storage: Bundle storage is full, deleting oldest bundle.\n");
+  if(!_has_free_slot(discovery)){
+    delete_expired_bundles();
+  }
+  if(!_has_free_slot(discovery)){
+    if (discovery) {
+      DEBUG("bundle_storage: No free slot for a discovery bundle.\n");
+      return NULL;
+    }
+    DEBUG("bundle_storage: Bundle storage is full, deleting oldest bundle of the lowest priority.\n");
     struct bundle_list *oldest_bundle = find_oldest_bundle_to_purge();
     if(delete_bundle(&oldest_bundle->current_bundle)) {
-      DEBUG("bundle_storage: deleted oldest bundle .\n");
-      return get_space_for_bundle();
+      DEBUG("bundle_storage: deleted oldest bundle of priority %u.\n", bundle_get_priority(&oldest_bundle->current_bundle));
+      return _get_space(discovery);
     }
     return NULL;
   }
@@ -72,20 +273,36 @@ struct actual_bundle* get_space_for_bundle(void)
   ret->unique_id = 	random_uint32();
   free_list = free_list->next;
 
-  if(head_of_store != ret) {
-    ret->next = head_of_store;
-    head_of_store = ret;
-  } else {
-    // returning the bundle at head_of_store
-    ret->next = NULL;
-  }
+  DL_PREPEND(head_of_store, ret);
+  /* set here already, the purge heap is ordered by it, the priority follows in bundle_storage_index */
+  ret->current_bundle.primary_block.flags = 0;
+  ret->current_bundle.local_creation_time = xtimer_now_usec64() / US_PER_MS;
+  ret->store_slot = BUNDLE_STORAGE_NOT_PERSISTED;
+  ret->discovery = discovery;
+  discovery_bundles += discovery;
+  ret->heap_pos = active_bundles;
+  purge_heap[active_bundles] = ret;
+  heap_sift_up(active_bundles);
   active_bundles++;
+  ret->current_bundle.last_send_time = 0;
+  ret->current_bundle.retx_deadline = 0;
+  ret->current_bundle.retx_count = 0;
+  ret->current_bundle.copies = 0;
   set_retention_constraint(&ret->current_bundle, NO_RETENTION_CONSTRAINT);
+  bp_metrics_record(BP_METRICS_HIST_STORE_DEPTH, active_bundles);
   return &ret->current_bundle;
 }
 
-// Implement the case when the node is not found since NULL is returned when both the
-// first node is to be deleted and when the node is not found
+struct actual_bundle* get_space_for_bundle(void)
+{
+  return _get_space(false);
+}
+
+struct actual_bundle* get_space_for_discovery_bundle(void)
+{
+  return _get_space(true);
+}
+
 bool delete_bundle(struct actual_bundle* bundle)
 {
   if (bundle == NULL) {
@@ -96,29 +313,102 @@ bool delete_bundle(struct actual_bundle* bundle)
     DEBUG("bundle_storage: Cannot delete bundle since bundle's retention constraint is %u.\n", get_retention_constraint(bundle));
     return false;
   }
-  struct bundle_list* previous_of_to_delete_node = get_previous_bundle_in_list(bundle);
-  struct bundle_list* to_delete_node = NULL;
+  struct bundle_list* to_delete_node = container_of(bundle, struct bundle_list, current_bundle);
 
-  if(previous_of_to_delete_node != NULL) {
-    to_delete_node = previous_of_to_delete_node->next;
-    previous_of_to_delete_node->next = to_delete_node->next;
-  } else {
-    //When trying to delete the head_of_store
-    to_delete_node = head_of_store;
-    head_of_store = to_delete_node -> next;
+  if (to_delete_node->store_slot != BUNDLE_STORAGE_NOT_PERSISTED) {
+    get_storage_backend()->remove(to_delete_node->store_slot);
+    to_delete_node->store_slot = BUNDLE_STORAGE_NOT_PERSISTED;
   }
 
+  bp_metrics_record(BP_METRICS_HIST_RESIDENCY,
+                    (uint32_t)(xtimer_now_usec64() / US_PER_MS) - bundle->local_creation_time);
+  index_remove(to_delete_node);
+  heap_remove(to_delete_node);
+  DL_DELETE(head_of_store, to_delete_node);
+
   to_delete_node->next = free_list;
   free_list = to_delete_node;
 
-  if(head_of_store == NULL){
-    head_of_store = free_list;
+  /* bundles are restored before a router may be set up */
+  if (get_router() != NULL) {
+    get_router()->notify_bundle_deletion(bundle);
   }
-  get_router()->notify_bundle_deletion(bundle);
+  bundle_release_pkt(bundle);
+  bundle_release_blocks(bundle);
+  bundle_wire_invalidate(bundle);
   active_bundles--;
+  discovery_bundles -= to_delete_node->discovery;
   return true;
 }
 
+void bundle_storage_index(struct actual_bundle* bundle)
+{
+  struct bundle_list *node = container_of(bundle, struct bundle_list, current_bundle);
+  /* the priority is only known now, or changed */
+  heap_sift_down(node->heap_pos, active_bundles);
+  heap_sift_up(node->heap_pos);
+
+  unsigned i = index_slot_of(bundle);
+  while (bundle_index[i] != NULL) {
+    if (bundle_index[i] == node) {
+      return;
+    }
+    i = (i + 1) % BUNDLE_INDEX_SIZE;
+  }
+  bundle_index[i] = node;
+}
+
+/*
+ * Hands the bundle to the persistent backend, if there is one, so that it survives a reboot until it
+ * is deleted. Received bundles are written as received, bundles created here are encoded first.
+ */
+int bundle_storage_persist(struct actual_bundle* bundle)
+{
+  struct bundle_list *node = container_of(bundle, struct bundle_list, current_bundle);
+  if (get_storage_backend() == NULL || node->store_slot != BUNDLE_STORAGE_NOT_PERSISTED) {
+    return OK;
+  }
+
+  gnrc_pktsnip_t *pkt = bundle->pkt;
+  if (pkt != NULL) {
+    gnrc_pktbuf_hold(pkt, 1);
+  }
+  else if ((pkt = bundle_encode_pkt(bundle, GNRC_NETTYPE_BP)) == NULL) {
+    DEBUG("bundle_storage: Could not encode bundle to persist it.\n");
+    return ERROR;
+  }
+  int slot = get_storage_backend()->store(bundle, pkt->data, pkt->size);
+  gnrc_pktbuf_release(pkt);
+  if (slot < 0) {
+    DEBUG("bundle_storage: Could not persist bundle, only kept in RAM.\n");
+    return ERROR;
+  }
+  node->store_slot = slot;
+  return OK;
+}
+
+static int restore_bundle(gnrc_pktsnip_t *pkt, uint32_t previous_endpoint_num, int slot)
+{
+  struct actual_bundle *bundle = create_bundle();
+  if (bundle == NULL) {
+    return ERROR;
+  }
+  if (bundle_decode_pkt(bundle, pkt) < 0) {
+    DEBUG("bundle_storage: Could not decode stored bundle.\n");
+    delete_bundle(bundle);
+    return ERROR;
+  }
+  bundle->previous_endpoint_num = previous_endpoint_num;
+  container_of(bundle, struct bundle_list, current_bundle)->store_slot = slot;
+
+  /* copies still travelling in the network are dropped, own bundles keep their sequence numbers */
+  add_bundle_to_processed_bundle_list(bundle);
+  if (bundle->primary_block.src_num == strtoul(get_src_num(), NULL, 10)) {
+    bundle_skip_sequence_num(bundle->primary_block.creation_timestamp[1]);
+  }
+  return OK;
+}
+
 uint8_t get_next_block_number(void)
 {
     return next_block_number++;
@@ -126,49 +416,38 @@ uint8_t get_next_block_number(void)
 
 struct bundle_list* get_previous_bundle_in_list(struct actual_bundle* bundle)
 {
-    struct bundle_list* temp = head_of_store;
-    if(is_same_bundle(&(temp->current_bundle), bundle)){
+    struct bundle_list* node = container_of(bundle, struct bundle_list, current_bundle);
+    if(node == head_of_store){
       return NULL;
     }
-    while(temp->next != NULL){
-      if (is_same_bundle(&temp->next->current_bundle, bundle)){
-        break;
-      }
-      temp = temp->next;
-    }
-    return temp;
+    return node->prev;
 }
 
 struct bundle_list* find_bundle_in_list ( struct actual_bundle* bundle)
 {
-    struct bundle_list* temp = head_of_store;
-    while(temp != NULL){
-      if(is_same_bundle(&temp->current_bundle, bundle)){
-        break;
+    unsigned i = index_slot_of(bundle);
+    while(bundle_index[i] != NULL){
+      if(is_same_bundle(&bundle_index[i]->current_bundle, bundle)){
+        return bundle_index[i];
       }
-      temp = temp->next;
+      i = (i + 1) % BUNDLE_INDEX_SIZE;
     }
-    return temp;
+    return NULL;
 }
 
 struct actual_bundle *get_bundle_from_list(uint32_t creation_timestamp0, uint32_t creation_timestamp1, uint32_t src_num) 
 {
-  struct bundle_list *temp = NULL;
-  bool found = false;
-  LL_FOREACH(head_of_store, temp) {
-    if (temp->current_bundle.primary_block.creation_timestamp[0] == creation_timestamp0 
-        && temp->current_bundle.primary_block.creation_timestamp[1] == creation_timestamp1
-        && temp->current_bundle.primary_block.src_num == src_num) {
-      found = true;
-      break;
+  unsigned i = index_hash(src_num, creation_timestamp0, creation_timestamp1);
+  while (bundle_index[i] != NULL) {
+    struct actual_bundle *temp = &bundle_index[i]->current_bundle;
+    if (temp->primary_block.creation_timestamp[0] == creation_timestamp0 
+        && temp->primary_block.creation_timestamp[1] == creation_timestamp1
+        && temp->primary_block.src_num == src_num) {
+      return temp;
     }
+    i = (i + 1) % BUNDLE_INDEX_SIZE;
   }
-  if (found) {
-    return &temp->current_bundle;
-  }
-  else {
-    return NULL;
-  }
+  return NULL;
 }
 
 void print_bundle_storage(void)
@@ -176,7 +455,7 @@ void print_bundle_storage(void)
   DEBUG("bundle_storage: Printing bundle storage list.\n");
   struct bundle_list* temp = head_of_store;
   while(temp!=NULL){
-    DEBUG("(%ld, %lu)->", temp->unique_id, temp->current_bundle.local_creation_time);
+    DEBUG("(%" PRIu32 ", %" PRIu32 ")->", temp->unique_id, temp->current_bundle.local_creation_time);
     temp = temp->next;
   }
   DEBUG("NULL.\n");
@@ -190,74 +469,171 @@ struct bundle_list *get_bundle_list(void)
 
 struct bundle_list *find_oldest_bundle_to_purge(void) 
 {
-  struct bundle_list *temp, *oldest_bundle = NULL;
-  uint32_t oldest_time = UINT32_MAX;
-  LL_FOREACH(head_of_store, temp) {
-    if (temp->current_bundle.local_creation_time < oldest_time) {
-      oldest_time = temp->current_bundle.local_creation_time;
-      oldest_bundle = temp;
+  if (active_bundles == 0) {
+    return NULL;
+  }
+  return purge_heap[0];
+}
+
+bool bundle_storage_purge_for(struct actual_bundle *bundle)
+{
+  struct bundle_list *node = container_of(bundle, struct bundle_list, current_bundle);
+
+  if (purge_pid != KERNEL_PID_UNDEF && thread_getpid() != purge_pid) {
+    DEBUG("bundle_storage: Not purging outside of thread %d.\n", purge_pid);
+    return false;
+  }
+  /* the priority of a bundle being decoded is not in the heap yet */
+  heap_sift_down(node->heap_pos, active_bundles);
+  heap_sift_up(node->heap_pos);
+  struct bundle_list *oldest_bundle = find_oldest_bundle_to_purge();
+  if (oldest_bundle == node || bundle_get_priority(&oldest_bundle->current_bundle) > bundle_get_priority(bundle)) {
+    return false;
+  }
+  DEBUG("bundle_storage: Block pool is full, deleting oldest bundle of priority %u.\n",
+        bundle_get_priority(&oldest_bundle->current_bundle));
+  return delete_bundle(&oldest_bundle->current_bundle);
+}
+
+void bundle_storage_set_purge_pid(kernel_pid_t pid)
+{
+  purge_pid = pid;
+}
+
+bool bundle_storage_admit(uint8_t priority)
+{
+  uint16_t limit;
+
+  /* always stored, get_space_for_bundle() purges the root of the heap if full */
+  if (priority >= BUNDLE_PRIORITY_EXPEDITED) {
+    return true;
+  }
+  if (priority == BUNDLE_PRIORITY_BULK) {
+    limit = BUNDLE_STORAGE_BULK_LIMIT;
+  }
+  else {
+    limit = BUNDLE_STORAGE_NORMAL_LIMIT;
+  }
+  if (active_bundles < limit) {
+    return true;
+  }
+  if (active_bundles == 0) {
+    return false;
+  }
+  /* room can only be made by purging a bundle of lower priority */
+  return priority > bundle_get_priority(&purge_heap[0]->current_bundle);
+}
+
+bool bundle_storage_has_room(uint16_t num, uint8_t priority)
+{
+  uint16_t room = MAX_BUNDLES - BUNDLE_STORAGE_DISCOVERY_SLOTS - (active_bundles - discovery_bundles);
+  struct bundle_list *temp;
+
+  DL_FOREACH(head_of_store, temp) {
+    if (room >= num) {
+      break;
+    }
+    if (bundle_get_priority(&temp->current_bundle) <= priority &&
+        get_retention_constraint(&temp->current_bundle) == NO_RETENTION_CONSTRAINT) {
+      room++;
     }
   }
-  return oldest_bundle;
+  return room >= num;
 }
 
-uint8_t get_current_active_bundles(void) 
+uint16_t get_current_active_bundles(void) 
 {
   return active_bundles;
 }
 
 bool is_redundant_bundle(struct actual_bundle *bundle) 
 {
-  struct bundle_list *temp;
-  int i = 0;
-  LL_FOREACH(head_of_store, temp) {
-    if (is_same_bundle(bundle, &temp->current_bundle)) {
-      i++;
+  struct bundle_list *node = container_of(bundle, struct bundle_list, current_bundle);
+  unsigned i = index_slot_of(bundle);
+  while (bundle_index[i] != NULL) {
+    if (bundle_index[i] != node && is_same_bundle(bundle, &bundle_index[i]->current_bundle)) {
+      return true;
     }
-  }
-  if (i > 1) {
-    return true;
+    i = (i + 1) % BUNDLE_INDEX_SIZE;
   }
   return false;
 }
 
+static void processed_bundles_init(void)
+{
+  for (int i = 0; i < 2; i++) {
+    memset(processed_bits[i], 0, PROCESSED_BUNDLES_BLOOM_BYTES);
+    bloom_init(&processed_filter[i], PROCESSED_BUNDLES_BLOOM_BITS, processed_bits[i],
+               processed_hashes, PROCESSED_BUNDLES_FP_EXP);
+  }
+  processed_current = 0;
+  processed_count = 0;
+  processed_rotated_at = xtimer_now_usec();
+}
+
+static void processed_bundles_age(void)
+{
+  if (processed_count < PROCESSED_BUNDLES_CAPACITY &&
+      xtimer_now_usec() - processed_rotated_at < PROCESSED_BUNDLES_AGING_USEC) {
+    return;
+  }
+  DEBUG("bundle_storage: Rotating processed bundle filters after %u bundles.\n", processed_count);
+  processed_current ^= 1;
+  memset(processed_bits[processed_current], 0, PROCESSED_BUNDLES_BLOOM_BYTES);
+  processed_count = 0;
+  processed_rotated_at = xtimer_now_usec();
+}
+
+void add_bundle_id_to_processed_bundle_list(const struct bundle_id *id)
+{
+  processed_bundles_age();
+  bloom_add(&processed_filter[processed_current], (const uint8_t *)id, sizeof(*id));
+  processed_count++;
+}
+
 int add_bundle_to_processed_bundle_list(struct actual_bundle *bundle)
 {
-  if (num_processed_list == MAX_PROCESSED_BUNDLES) {
-    delete_oldest();
-  }
-  struct processed_bundle_list *new_processed = malloc(sizeof(struct processed_bundle_list));
-  new_processed->src_num = bundle->primary_block.src_num;
-  new_processed->creation_timestamp[0] = bundle->primary_block.creation_timestamp[0];
-  new_processed->creation_timestamp[1] = bundle->primary_block.creation_timestamp[1];
-  new_processed->fragment_offset = bundle->primary_block.fragment_offset;
-  new_processed->total_application_data_length = bundle->primary_block.total_application_data_length;
-  LL_APPEND(head_processed_list_ptr, new_processed);
-  num_processed_list++;
+  struct bundle_id id;
+  bundle_get_id(bundle, &id);
+  add_bundle_id_to_processed_bundle_list(&id);
   return OK;
 }
 
-bool verify_bundle_processed(struct actual_bundle *bundle)
+bool verify_bundle_id_processed(const struct bundle_id *id)
 {
-  struct processed_bundle_list *temp;
-  LL_FOREACH(head_processed_list_ptr, temp) {
-    if(bundle->primary_block.src_num == temp->src_num) {
-      if (bundle->primary_block.creation_timestamp[0] == temp->creation_timestamp[0]
-          && bundle->primary_block.creation_timestamp[1] == temp->creation_timestamp[1]) {
-        if (bundle->primary_block.fragment_offset == temp->fragment_offset 
-          && bundle->primary_block.total_application_data_length == temp->total_application_data_length) {
-          return true;
-        }
-      }
-    }
+  processed_bundles_age();
+  return bloom_check(&processed_filter[0], (const uint8_t *)id, sizeof(*id)) ||
+         bloom_check(&processed_filter[1], (const uint8_t *)id, sizeof(*id));
+}
+
+int bundle_storage_summary(uint8_t *bits, size_t len)
+{
+  if (len < PROCESSED_BUNDLES_BLOOM_BYTES) {
+    return ERROR;
   }
-  return false;
+  processed_bundles_age();
+  for (unsigned i = 0; i < PROCESSED_BUNDLES_BLOOM_BYTES; i++) {
+    bits[i] = processed_bits[0][i] | processed_bits[1][i];
+  }
+  return PROCESSED_BUNDLES_BLOOM_BYTES;
+}
+
+bool bundle_storage_summary_check(const uint8_t *bits, size_t len, const struct bundle_id *id)
+{
+  bloom_t summary;
+
+  /* a summary of another filter size cannot be checked, everything counts as missing */
+  if (len != PROCESSED_BUNDLES_BLOOM_BYTES) {
+    return false;
+  }
+  /* only read by bloom_check */
+  bloom_init(&summary, PROCESSED_BUNDLES_BLOOM_BITS, (uint8_t *)bits, processed_hashes, PROCESSED_BUNDLES_FP_EXP);
+  return bloom_check(&summary, (const uint8_t *)id, sizeof(*id));
 }
 
-/* Can simply delete the head of the list since it contains the oldest added element,
-  therefore, no need to keep track of time and thus saving space*/
-static void delete_oldest(void) 
+bool verify_bundle_processed(struct actual_bundle *bundle)
 {
-  LL_DELETE(head_processed_list_ptr, head_processed_list_ptr);
-  num_processed_list--;
-}
\ No newline at end of file
+  struct bundle_id id;
+  bundle_get_id(bundle, &id);
+  return verify_bundle_id_processed(&id);
+}
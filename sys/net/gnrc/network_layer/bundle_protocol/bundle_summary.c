@@ -0,0 +1,67 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Summary vector frames implementation
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include "nanocbor/nanocbor.h"
+
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/bundle_summary.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Array head, type, request and the head of the bits */
+#define SUMMARY_FRAME_OVERHEAD 6
+
+bool bundle_summary_is_frame(const uint8_t *buf, size_t len)
+{
+  return len >= 2 && buf[0] == 0x83 && buf[1] == BUNDLE_SUMMARY_FRAME_TYPE;
+}
+
+int bundle_summary_encode(uint8_t *buf, size_t len, bool request)
+{
+  nanocbor_encoder_t enc;
+
+  if (len < SUMMARY_FRAME_OVERHEAD) {
+    return ERROR;
+  }
+  nanocbor_encoder_init(&enc, buf, len);
+  nanocbor_fmt_array(&enc, 3);
+  nanocbor_fmt_uint(&enc, BUNDLE_SUMMARY_FRAME_TYPE);
+  nanocbor_fmt_bool(&enc, request);
+
+  /* written in place behind the longest head it may need */
+  int bits_len = bundle_storage_summary(buf + SUMMARY_FRAME_OVERHEAD, len - SUMMARY_FRAME_OVERHEAD);
+  if (bits_len < 0) {
+    DEBUG("bundle_summary: Summary vector does not fit into %u bytes, sending it empty.\n", (unsigned)len);
+    bits_len = 0;
+  }
+  nanocbor_fmt_bstr(&enc, bits_len);
+  memmove(buf + nanocbor_encoded_len(&enc), buf + SUMMARY_FRAME_OVERHEAD, bits_len);
+  return nanocbor_encoded_len(&enc) + bits_len;
+}
+
+int bundle_summary_decode(const uint8_t *buf, size_t len, bool *request, const uint8_t **bits, size_t *bits_len)
+{
+  nanocbor_value_t decoder, frame;
+  uint32_t type;
+
+  if (!bundle_summary_is_frame(buf, len)) {
+    return ERROR;
+  }
+  nanocbor_decoder_init(&decoder, buf, len);
+  if (nanocbor_enter_array(&decoder, &frame) < 0 || nanocbor_get_uint32(&frame, &type) < 0 ||
+      nanocbor_get_bool(&frame, request) < 0 || nanocbor_get_bstr(&frame, bits, bits_len) < 0) {
+    DEBUG("bundle_summary: Malformed summary frame.\n");
+    return ERROR;
+  }
+  return OK;
+}
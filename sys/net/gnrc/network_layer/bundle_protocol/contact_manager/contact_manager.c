@@ -9,6 +9,10 @@
  *
  * @}
  */
+#include "evtimer_msg.h"
+#include "hashes.h"
+#include "msg.h"
+#include "mutex.h"
 #include "thread.h"
 #include "kernel_types.h"
 #include "utlist.h"
@@ -18,14 +22,18 @@
 #include "net/gnrc/bundle_protocol/contact_manager.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/routing.h"
 #include "net/gnrc/netif/hdr.h"
 #include "net/gnrc.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 
 #define ENABLE_DEBUG  (0)
 #include "debug.h"
 
+#define CONTACT_MANAGER_MSG_TYPE_EXPIRY (0x02B0)
+
 static kernel_pid_t _pid = KERNEL_PID_UNDEF;
 
 #if ENABLE_DEBUG
@@ -38,11 +46,26 @@ static gnrc_pktsnip_t *_create_netif_hdr(uint8_t *dst_l2addr, unsigned dst_l2add
 static void _receive(struct actual_bundle *bundle);
 static void _send(gnrc_pktsnip_t *pkt);
 static void *_event_loop(void* args);
-static int comparator (struct neighbor_t *neighbor, struct neighbor_t *compare_to_neighbor);
-static void timer_expiry_callback (void *args);
+static void _expiry_schedule(void);
+static void _expire(void);
 
 struct neighbor_t *head_of_neighbors;
 
+/* Filled in by the contact manager thread, entries are only removed in the BP thread */
+static struct neighbor_t neighbors[CONTACT_MANAGER_MAX_NEIGHBORS];
+static struct neighbor_link_t *by_l2addr[CONTACT_MANAGER_NEIGHBOR_BUCKETS];
+static struct neighbor_t *by_endpoint[CONTACT_MANAGER_NEIGHBOR_BUCKETS];
+/*
+ * Held while the lookups and the neighbor list are changed, and while the BP thread looks up links
+ * by l2 address and updates their quality, see neighbor_heard(). The routers walk the neighbor list
+ * without it, which is safe as entries are only removed in the BP thread.
+ */
+static mutex_t links_lock = MUTEX_INIT;
+
+/* One event for the earliest expiry of all neighbors */
+static evtimer_msg_t expiry_timer;
+static evtimer_msg_event_t expiry_event;
+
 kernel_pid_t gnrc_contact_manager_init(void)
 {
   if(_pid > KERNEL_PID_UNDEF){
@@ -74,50 +97,249 @@ static gnrc_pktsnip_t *_create_netif_hdr(uint8_t *dst_l2addr, unsigned dst_l2add
   return pkt;
 }
 
-static void _receive(struct actual_bundle *bundle)
+static uint32_t _now_ms(void)
 {
-  struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(bundle);
+  return xtimer_now_usec64() / US_PER_MS;
+}
 
-  if (payload_block == NULL) {
-    DEBUG("contact_manager: Cannot extract payload block from received packet.\n");
-    return ;
+static unsigned _l2addr_bucket(const uint8_t *addr, size_t addr_len)
+{
+  return djb2_hash(addr, addr_len) & (CONTACT_MANAGER_NEIGHBOR_BUCKETS - 1);
+}
+
+/* Fibonacci hashing, node numbers are often consecutive */
+static unsigned _endpoint_bucket(uint32_t endpoint_num)
+{
+  return ((endpoint_num * 2654435769u) >> 24) & (CONTACT_MANAGER_NEIGHBOR_BUCKETS - 1);
+}
+
+static void _unlink_link(struct neighbor_link_t *link)
+{
+  struct neighbor_link_t **temp;
+
+  mutex_lock(&links_lock);
+  for (temp = &by_l2addr[_l2addr_bucket(link->l2addr, link->l2addr_len)]; *temp != NULL;
+       temp = &(*temp)->l2addr_next) {
+    if (*temp == link) {
+      *temp = link->l2addr_next;
+      break;
+    }
   }
-  update_statistics(DISCOVERY_BUNDLE_RECEIVE);
-  struct neighbor_t *neighbor = (struct neighbor_t*)malloc(sizeof(struct neighbor_t));
+  mutex_unlock(&links_lock);
+}
 
-  if (neighbor == NULL) {
-    DEBUG("contact_manager: Could not allocate memory for new neighbor.\n");
+void contact_manager_remove_neighbor(struct neighbor_t *neighbor)
+{
+  struct neighbor_t **temp;
+
+  for (unsigned i = 0; i < neighbor->num_links; i++) {
+    _unlink_link(&neighbor->links[i]);
+  }
+  mutex_lock(&links_lock);
+  for (temp = &by_endpoint[_endpoint_bucket(neighbor->endpoint_num)]; *temp != NULL;
+       temp = &(*temp)->endpoint_next) {
+    if (*temp == neighbor) {
+      *temp = neighbor->endpoint_next;
+      break;
+    }
+  }
+  LL_DELETE(head_of_neighbors, neighbor);
+  mutex_unlock(&links_lock);
+  /* delivery records of the entry would otherwise apply to the next neighbor using it */
+  routing_notify_neighbor_deletion(neighbor);
+  neighbor->endpoint_num = 0;
+  neighbor->num_links = 0;
+}
+
+/* Waits until the BP thread removed the neighbor, then the entry is not used by it any more */
+static void _remove_neighbor(struct neighbor_t *neighbor)
+{
+  kernel_pid_t bp_pid = gnrc_bp_get_pid();
+  msg_t msg, reply;
+
+  if (bp_pid == KERNEL_PID_UNDEF) {
+    contact_manager_remove_neighbor(neighbor);
     return ;
   }
+  msg.type = GNRC_BP_MSG_TYPE_REMOVE_NEIGHBOR;
+  msg.content.ptr = neighbor;
+  msg_send_receive(&msg, &reply, bp_pid);
+}
 
-  neighbor->endpoint_scheme = bundle->primary_block.endpoint_scheme;
-  if (neighbor->endpoint_scheme == IPN) {
-    neighbor->endpoint_num = bundle->primary_block.src_num;
+/* Takes an unused entry, or the one of the neighbor heard from longest ago */
+static struct neighbor_t *_add_neighbor(void)
+{
+  struct neighbor_t *neighbor = NULL;
+  uint32_t now = _now_ms();
+
+  for (unsigned i = 0; i < CONTACT_MANAGER_MAX_NEIGHBORS; i++) {
+    if (neighbors[i].num_links == 0) {
+      neighbor = &neighbors[i];
+      break;
+    }
+    if (neighbor == NULL || (int32_t)(neighbors[i].expires - now) < (int32_t)(neighbor->expires - now)) {
+      neighbor = &neighbors[i];
+    }
   }
-  else if (neighbor->endpoint_scheme == DTN) {
-    neighbor->eid = bundle->primary_block.src_eid;
+  if (neighbor->num_links != 0) {
+    DEBUG("contact_manager: Neighbor table full, dropping neighbor %" PRIu32 ".\n", neighbor->endpoint_num);
+    _remove_neighbor(neighbor);
   }
+  memset(neighbor, 0, sizeof(*neighbor));
+  return neighbor;
+}
 
-  memcpy(neighbor->l2addr, payload_block->block_data, payload_block->data_len);
-  neighbor->l2addr_len = payload_block->data_len;
-  
-  create_neighbor_expiry_timer(neighbor);
-  xtimer_set(&neighbor->expiry_timer, xtimer_ticks_from_usec(NEIGHBOR_PURGE_TIMER_SECONDS*SECS_TO_MICROSECS).ticks32);
+/* Links a filled in entry into the lookup by endpoint number and the neighbor list */
+static void _link_neighbor(struct neighbor_t *neighbor)
+{
+  unsigned bucket = _endpoint_bucket(neighbor->endpoint_num);
 
-  /* Adding neighbor in front of neighbor list if not present in list*/
-  struct neighbor_t *temp;
-  LL_SEARCH(head_of_neighbors, temp, neighbor, comparator);
-  if(!temp) {
+  mutex_lock(&links_lock);
+  neighbor->endpoint_next = by_endpoint[bucket];
+  by_endpoint[bucket] = neighbor;
+  LL_APPEND(head_of_neighbors, neighbor);
+  mutex_unlock(&links_lock);
+}
+
+/* Adds a link to a neighbor, in place of the one heard over longest ago if it has no room left */
+static struct neighbor_link_t *_add_link(struct neighbor_t *neighbor, kernel_pid_t iface,
+                                         const uint8_t *addr, size_t addr_len)
+{
+  struct neighbor_link_t *link;
+
+  if (neighbor->num_links < CONTACT_MANAGER_MAX_LINKS) {
+    link = &neighbor->links[neighbor->num_links++];
+  }
+  else {
+    link = &neighbor->links[0];
+    for (unsigned i = 1; i < neighbor->num_links; i++) {
+      if ((int32_t)(neighbor->links[i].heard - link->heard) < 0) {
+        link = &neighbor->links[i];
+      }
+    }
+    _unlink_link(link);
+  }
+  memset(link, 0, sizeof(*link));
+  link->iface = iface;
+  memcpy(link->l2addr, addr, addr_len);
+  link->l2addr_len = addr_len;
+  link->neighbor = neighbor;
+
+  unsigned bucket = _l2addr_bucket(addr, addr_len);
+  mutex_lock(&links_lock);
+  link->l2addr_next = by_l2addr[bucket];
+  by_l2addr[bucket] = link;
+  mutex_unlock(&links_lock);
+  return link;
+}
+
+static struct neighbor_link_t *_find_link(kernel_pid_t iface, const uint8_t *addr, size_t addr_len)
+{
+  struct neighbor_link_t *temp = by_l2addr[_l2addr_bucket(addr, addr_len)];
+  while (temp != NULL && (temp->iface != iface || temp->l2addr_len != addr_len ||
+                          memcmp(temp->l2addr, addr, addr_len) != 0)) {
+    temp = temp->l2addr_next;
+  }
+  return temp;
+}
+
+/* Called with links_lock held */
+static void _link_heard(struct neighbor_link_t *link, const gnrc_netif_hdr_t *hdr)
+{
+  if (link->heard == 0) {
+    link->lqi = hdr->lqi;
+    link->rssi = hdr->rssi;
+  }
+  else {
+    link->lqi = (3 * link->lqi + hdr->lqi) / 4;
+    link->rssi = (3 * link->rssi + hdr->rssi) / 4;
+  }
+  link->heard = _now_ms();
+  /* 0 marks a link not heard over yet */
+  if (link->heard == 0) {
+    link->heard = 1;
+  }
+}
+
+static void _receive(struct actual_bundle *bundle)
+{
+  struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(bundle);
+  /* the bundle holds the received packet, netif header included */
+  gnrc_pktsnip_t *netif_snip = (bundle->pkt != NULL) ? gnrc_pktsnip_search_type(bundle->pkt, GNRC_NETTYPE_NETIF) : NULL;
+
+  if (netif_snip == NULL) {
+    DEBUG("contact_manager: No interface for received discovery bundle.\n");
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
+    return ;
+  }
+  if (payload_block == NULL || payload_block->data_len == 0 ||
+      payload_block->data_len > GNRC_IPV6_NIB_L2ADDR_MAX_LEN) {
+    DEBUG("contact_manager: Cannot extract l2 address from received discovery bundle.\n");
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
+    return ;
+  }
+  update_statistics(DISCOVERY_BUNDLE_RECEIVE);
+
+  const gnrc_netif_hdr_t *hdr = netif_snip->data;
+  uint8_t endpoint_scheme = bundle->primary_block.endpoint_scheme;
+  uint32_t endpoint_num = (endpoint_scheme == IPN) ? bundle->primary_block.src_num : 0;
+  struct neighbor_link_t *link = _find_link(hdr->if_pid, payload_block->block_data, payload_block->data_len);
+  struct neighbor_t *neighbor = (link != NULL) ? link->neighbor : NULL;
+
+  /* a node that came back with another endpoint is a new neighbor */
+  if (neighbor != NULL && (neighbor->endpoint_scheme != endpoint_scheme || neighbor->endpoint_num != endpoint_num)) {
+    _remove_neighbor(neighbor);
+    neighbor = NULL;
+    link = NULL;
+  }
+  /* the same node heard on another interface */
+  if (neighbor == NULL && endpoint_scheme == IPN) {
+    neighbor = get_neighbor_from_endpoint_num(endpoint_num);
+  }
+  bool is_new = (neighbor == NULL);
+
+  if (is_new) {
+    neighbor = _add_neighbor();
+    neighbor->endpoint_scheme = endpoint_scheme;
+    neighbor->endpoint_num = endpoint_num;
+    if (endpoint_scheme == DTN) {
+      neighbor->eid = bundle->primary_block.src_eid;
+    }
+    _link_neighbor(neighbor);
     DEBUG("contact_manager: Adding neighbor which will expire in %d.\n", NEIGHBOR_PURGE_TIMER_SECONDS);
-    LL_APPEND(head_of_neighbors, neighbor);
-    
-#ifdef MODULE_ROUTING_EPIDEMIC
-    send_bundles_to_new_neighbor(neighbor);
-#endif
+  }
+  if (link == NULL) {
+    DEBUG("contact_manager: Neighbor %" PRIu32 " heard on interface %d.\n", neighbor->endpoint_num, hdr->if_pid);
+    link = _add_link(neighbor, hdr->if_pid, payload_block->block_data, payload_block->data_len);
+  }
+  mutex_lock(&links_lock);
+  _link_heard(link, hdr);
+  mutex_unlock(&links_lock);
+  /* the pending expiry event is earlier and reschedules itself */
+  neighbor->expires = _now_ms() + NEIGHBOR_PURGE_TIMER_SECONDS * MS_PER_SEC;
+  if (is_new) {
+    _expiry_schedule();
+  }
+#ifdef MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE
+  if (is_new) {
+    gnrc_contact_scheduler_trickle_reset();
   }
   else {
-    xtimer_remove(&temp->expiry_timer);
-    xtimer_set(&temp->expiry_timer, xtimer_ticks_from_usec(NEIGHBOR_PURGE_TIMER_SECONDS*SECS_TO_MICROSECS).ticks32);
+    gnrc_contact_scheduler_trickle_consistent();
+  }
+#endif
+
+  struct router *router = get_router();
+  if (router != NULL && router->received_discovery != NULL) {
+    struct bundle_canonical_block_t *routing_block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_ROUTING);
+    router->received_discovery(neighbor, (routing_block != NULL) ? routing_block->block_data : NULL,
+                               (routing_block != NULL) ? routing_block->data_len : 0);
+  }
+  /* Only after the routing data of the neighbor is known */
+  if (is_new && router != NULL) {
+    send_summary_vector(neighbor);
   }
   set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
   delete_bundle(bundle);
@@ -176,6 +398,7 @@ static void *_event_loop(void *args)
   msg_init_queue(msg_q, GNRC_CONTACT_MANAGER_MSG_QUEUE_SIZE);
   
   gnrc_netreg_register(GNRC_NETTYPE_CONTACT_MANAGER, &me_reg);
+  evtimer_init_msg(&expiry_timer);
   while(1){
     DEBUG("contact_manager: waiting for incoming message.\n");
     msg_receive(&msg);
@@ -188,6 +411,9 @@ static void *_event_loop(void *args)
           DEBUG("contact_manager: GNRC_NETDEV_MSG_TYPE_RCV received\n");
           _receive(msg.content.ptr);
           break;
+      case CONTACT_MANAGER_MSG_TYPE_EXPIRY:
+          _expire();
+          break;
       default:
         DEBUG("contact_manager: Successfully entered contact manager, yayyyyyy!!\n");
         break;
@@ -196,73 +422,131 @@ static void *_event_loop(void *args)
   return NULL;
 }
 
-static int comparator (struct neighbor_t *neighbor, struct neighbor_t *compare_to_neighbor)
+/* Arms the timer for the earliest expiry of all neighbors */
+static void _expiry_schedule(void)
 {
-  int res = -1;
-  if (neighbor->endpoint_scheme == compare_to_neighbor->endpoint_scheme) {
-    if (neighbor->endpoint_scheme == IPN) {
-      if(neighbor->endpoint_num == compare_to_neighbor->endpoint_num) {
-        if(neighbor-> l2addr_len == compare_to_neighbor->l2addr_len && memcmp(neighbor->l2addr, compare_to_neighbor->l2addr, neighbor->l2addr_len) == 0){
-          return 0;
-        }
-      }
-    }
-    else if (neighbor->endpoint_scheme == DTN ) {
-      if(strcmp((char*)neighbor->eid, (char*)compare_to_neighbor->eid) == 0){
-        if(neighbor-> l2addr_len == compare_to_neighbor->l2addr_len && memcmp(neighbor->l2addr, compare_to_neighbor->l2addr, neighbor->l2addr_len) == 0){
-          return 0;
-        }
-      }
+  struct neighbor_t *temp;
+  uint32_t now = _now_ms();
+  int32_t delay = INT32_MAX;
+
+  LL_FOREACH(head_of_neighbors, temp) {
+    int32_t left = temp->expires - now;
+    delay = (left < delay) ? left : delay;
+  }
+  evtimer_del(&expiry_timer, &expiry_event.event);
+  if (delay == INT32_MAX) {
+    return ;
+  }
+  expiry_event.event.offset = (delay > 0) ? (uint32_t)delay : 0;
+  expiry_event.msg.type = CONTACT_MANAGER_MSG_TYPE_EXPIRY;
+  evtimer_add_msg(&expiry_timer, &expiry_event, sched_active_pid);
+}
+
+/* Purges the neighbors not heard from within NEIGHBOR_PURGE_TIMER_SECONDS */
+static void _expire(void)
+{
+  struct neighbor_t *temp, *next;
+  uint32_t now = _now_ms();
+
+  LL_FOREACH_SAFE(head_of_neighbors, temp, next) {
+    if ((int32_t)(temp->expires - now) <= 0) {
+      DEBUG("contact_manager: Neighbor %" PRIu32 " expired.\n", temp->endpoint_num);
+      _remove_neighbor(temp);
     }
   }
-  return res;
+  _expiry_schedule();
 }
 
 struct neighbor_t *get_neighbor_from_endpoint_num(uint32_t endpoint_num) {
-  struct neighbor_t * temp = NULL;
-  LL_SEARCH_SCALAR(head_of_neighbors, temp, endpoint_num, endpoint_num);
+  struct neighbor_t *temp = by_endpoint[_endpoint_bucket(endpoint_num)];
+  while (temp != NULL && temp->endpoint_num != endpoint_num) {
+    temp = temp->endpoint_next;
+  }
   return temp;
 }
 
-struct neighbor_t *get_neighbor_from_l2addr(uint8_t *addr) {
-  bool found = false;
-  struct neighbor_t *temp = NULL;
-  LL_FOREACH(head_of_neighbors, temp) {
-    if(memcmp(temp->l2addr, addr, temp->l2addr_len) == 0) {
-      found = true;
-      break;
-    }
+/* Neighbor with the l2 address on any interface */
+struct neighbor_t *get_neighbor_from_l2addr(const uint8_t *addr, size_t addr_len) {
+  struct neighbor_link_t *temp;
+  struct neighbor_t *neighbor;
+
+  mutex_lock(&links_lock);
+  temp = by_l2addr[_l2addr_bucket(addr, addr_len)];
+  while (temp != NULL && (temp->l2addr_len != addr_len || memcmp(temp->l2addr, addr, addr_len) != 0)) {
+    temp = temp->l2addr_next;
   }
-  if (found){
-    return temp;
+  neighbor = (temp != NULL) ? temp->neighbor : NULL;
+  mutex_unlock(&links_lock);
+  return neighbor;
+}
+
+/* Runs in the BP thread, the lookup and the link quality update hold links_lock against the contact manager */
+struct neighbor_t *neighbor_heard(gnrc_pktsnip_t *pkt) {
+  gnrc_pktsnip_t *netif_snip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_NETIF);
+  gnrc_netif_hdr_t *hdr;
+  struct neighbor_link_t *link;
+  struct neighbor_t *neighbor = NULL;
+
+  if (netif_snip == NULL) {
+    return NULL;
   }
-  else {
+  hdr = netif_snip->data;
+  if (hdr->src_l2addr_len == 0) {
     return NULL;
   }
+  mutex_lock(&links_lock);
+  link = _find_link(hdr->if_pid, gnrc_netif_hdr_get_src_addr(hdr), hdr->src_l2addr_len);
+  if (link != NULL) {
+    _link_heard(link, hdr);
+    neighbor = link->neighbor;
+  }
+  mutex_unlock(&links_lock);
+  return neighbor;
 }
 
-struct neighbor_t *get_neighbor_list(void) {
-  return head_of_neighbors;
+/* Whether link a is the better one to send over */
+static bool _better_link(const struct neighbor_link_t *a, const struct neighbor_link_t *b, uint32_t now)
+{
+  bool a_fresh = (now - a->heard) < NEIGHBOR_PURGE_TIMER_SECONDS * MS_PER_SEC;
+  bool b_fresh = (now - b->heard) < NEIGHBOR_PURGE_TIMER_SECONDS * MS_PER_SEC;
+
+  if (a_fresh != b_fresh) {
+    return a_fresh;
+  }
+  if (a->lqi != b->lqi) {
+    return a->lqi > b->lqi;
+  }
+  return a->rssi > b->rssi;
 }
 
-void create_neighbor_expiry_timer(struct neighbor_t *neighbor) {
-  neighbor->expiry_timer.callback = &timer_expiry_callback;
-  neighbor->expiry_timer.arg = neighbor;
-  neighbor->expiry_timer.next = NULL;
+int get_neighbor_links(struct neighbor_t *neighbor, struct neighbor_link_t **links) {
+  uint32_t now = _now_ms();
+  int num = 0;
+
+  mutex_lock(&links_lock);
+  /* insertion sort, a neighbor has a link per interface at most */
+  for (unsigned i = 0; i < neighbor->num_links; i++) {
+    struct neighbor_link_t *link = &neighbor->links[i];
+    int j = num++;
+    while (j > 0 && _better_link(link, links[j - 1], now)) {
+      links[j] = links[j - 1];
+      j--;
+    }
+    links[j] = link;
+  }
+  mutex_unlock(&links_lock);
+  return num;
 }
 
-static void timer_expiry_callback (void *args) {
-  ((struct neighbor_t*)args)->endpoint_num = 0;
-  ((struct neighbor_t*)args)->l2addr_len = 0;
-  LL_DELETE(head_of_neighbors, ((struct neighbor_t*)args));
+struct neighbor_t *get_neighbor_list(void) {
+  return head_of_neighbors;
 }
 
+/* A neighbor is the same on all of its links, so only its endpoint is compared */
 bool is_same_neighbor(struct neighbor_t *neighbor, struct neighbor_t *compare_to_neighbor) {
   if (neighbor->endpoint_scheme == IPN && compare_to_neighbor->endpoint_scheme == IPN) { 
     if (neighbor->endpoint_num == compare_to_neighbor->endpoint_num) {
-      if (neighbor-> l2addr_len == compare_to_neighbor->l2addr_len && memcmp(neighbor->l2addr, compare_to_neighbor->l2addr, neighbor->l2addr_len) == 0) {
-        return true;
-      }
+      return true;
     }
   }
   return false;
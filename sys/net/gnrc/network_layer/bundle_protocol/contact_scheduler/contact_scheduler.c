@@ -0,0 +1,107 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Discovery packets of the contact schedulers
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include "net/gnrc/bundle_protocol/contact_scheduler.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/agent.h"
+#include "net/gnrc/bundle_protocol/config.h"
+#include "net/gnrc/bundle_protocol/routing.h"
+#include "net/gnrc/pkt.h"
+#include "net/gnrc/netif/internal.h"
+#include "net/gnrc.h"
+#include "net/gnrc/netif/hdr.h"
+
+#define ENABLE_DEBUG  (0)
+#include "debug.h"
+#include "od.h"
+
+#define DISCOVERY_ROUTING_BLOCK_OVERHEAD 10
+
+/* Neighbors reach this node on an interface at the address it has there */
+static int _send_discovery(gnrc_netif_t *netif)
+{
+  gnrc_pktsnip_t *discovery_packet;
+  uint8_t payload_data[GNRC_NETIF_L2ADDR_MAXLEN];
+  size_t data_len = netif->l2addr_len;
+  uint64_t payload_flag;
+
+  memcpy(payload_data, netif->l2addr, data_len);
+  if (calculate_canonical_flag(&payload_flag, false) < 0) {
+    DEBUG("contact_scheduler: Error making discovery payload flag.\n");
+    return ERROR;
+  }
+
+  struct actual_bundle *bundle = create_discovery_bundle();
+  if (bundle == NULL) {
+    DEBUG("contact_scheduler: Could not obtain space for bundle.\n");
+    return ERROR;
+  }
+  set_retention_constraint(bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
+  fill_bundle(bundle, 7, IPN, BROADCAST_EID, NULL, 1, NOCRC, CONTACT_MANAGER_SERVICE_NUM);
+  bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, payload_flag, payload_data, NOCRC, data_len);
+
+  /* Routing data fills what is left of a link frame, after the header of its block */
+  struct router *router = get_router();
+  size_t used = bundle_encoded_len(bundle) + DISCOVERY_ROUTING_BLOCK_OVERHEAD;
+  if (router != NULL && router->discovery_data != NULL && used < GNRC_BP_LINK_MTU) {
+    uint8_t routing_data[BLOCK_DATA_BUF_SIZE];
+    size_t room = GNRC_BP_LINK_MTU - used;
+    int routing_len = router->discovery_data(routing_data, (room < sizeof(routing_data)) ? room : sizeof(routing_data));
+    if (routing_len > 0) {
+      bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_ROUTING, payload_flag, routing_data, NOCRC, routing_len);
+    }
+  }
+
+  discovery_packet = bundle_encode_pkt(bundle, GNRC_NETTYPE_CONTACT_MANAGER);
+  if (discovery_packet == NULL) {
+    DEBUG("contact_scheduler: Unable to encode discovery bundle into packet buffer.\n");
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
+    return ERROR;
+  }
+
+  gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, NULL, 0);
+  if (netif_hdr == NULL) {
+    DEBUG("contact_scheduler: Unable to allocate netif header.\n");
+    gnrc_pktbuf_release(discovery_packet);
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
+    return ERROR;
+  }
+  gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
+  LL_PREPEND(discovery_packet, netif_hdr);
+  set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+  delete_bundle(bundle);
+  if(!gnrc_netapi_dispatch_send(GNRC_NETTYPE_CONTACT_MANAGER, GNRC_NETREG_DEMUX_CTX_ALL, discovery_packet)) {
+    DEBUG("contact_scheduler: Unable to find BP thread.\n");
+    gnrc_pktbuf_release(discovery_packet);
+    return ERROR;
+  }
+  return 0;
+}
+
+int send(int data)
+{
+  (void) data; // Not used, will remove later
+  gnrc_netif_t *netif = NULL;
+  int res = ERROR;
+
+  while ((netif = gnrc_netif_iter(netif)) != NULL) {
+    if (netif->l2addr_len == 0) {
+      continue;
+    }
+    if (_send_discovery(netif) == 0) {
+      res = 0;
+    }
+  }
+  return res;
+}
@@ -0,0 +1,115 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Trickle scheduler for discovery management in bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include "msg.h"
+#include "thread.h"
+#include "kernel_types.h"
+#include "trickle.h"
+
+#include "net/gnrc/bundle_protocol/contact_scheduler_trickle.h"
+
+#define ENABLE_DEBUG  (0)
+#include "debug.h"
+
+#define DISCOVERY_SEND_DATA 1
+
+#define CONTACT_TRICKLE_MSG_TYPE_INTERVAL (0x02A0)
+#define CONTACT_TRICKLE_MSG_TYPE_RESET (0x02A1)
+#define CONTACT_TRICKLE_MSG_TYPE_CONSISTENT (0x02A2)
+
+#if ENABLE_DEBUG
+static char _stack[GNRC_CONTACT_MANAGER_STACK_SIZE + THREAD_EXTRA_STACKSIZE_PRINTF];
+#else
+static char _stack[GNRC_CONTACT_MANAGER_STACK_SIZE];
+#endif
+
+static kernel_pid_t _pid = KERNEL_PID_UNDEF;
+/* Only touched by the scheduler thread, other threads send it messages */
+static trickle_t trickle;
+
+static void *contact_scheduler(void *args);
+
+kernel_pid_t gnrc_contact_scheduler_trickle_init(void)
+{
+  if(_pid > KERNEL_PID_UNDEF){
+    return _pid;
+  }
+
+  _pid = thread_create(_stack, sizeof(_stack), GNRC_CONTACT_SCHEDULER_PRIO, THREAD_CREATE_STACKTEST, contact_scheduler, NULL, "contact_scheduler");
+
+  return _pid;
+}
+
+static void _notify(uint16_t type)
+{
+  msg_t msg = { .type = type };
+
+  if (_pid <= KERNEL_PID_UNDEF) {
+    return ;
+  }
+  /* a full queue already holds an event that is handled soon */
+  if (msg_try_send(&msg, _pid) < 1) {
+    DEBUG("contact_scheduler: Dropped trickle event 0x%04x.\n", type);
+  }
+}
+
+void gnrc_contact_scheduler_trickle_reset(void)
+{
+  _notify(CONTACT_TRICKLE_MSG_TYPE_RESET);
+}
+
+void gnrc_contact_scheduler_trickle_consistent(void)
+{
+  _notify(CONTACT_TRICKLE_MSG_TYPE_CONSISTENT);
+}
+
+static void _beacon(void *args)
+{
+  (void) args;
+  if(send(DISCOVERY_SEND_DATA) < 0) {
+    DEBUG("contact_scheduler: Couldn't send discovery packet.\n");
+  }
+}
+
+static void *contact_scheduler(void *args)
+{
+  msg_t msg, msg_q[GNRC_CONTACT_MANAGER_MSG_QUEUE_SIZE];
+  (void) args;
+
+  msg_init_queue(msg_q, GNRC_CONTACT_MANAGER_MSG_QUEUE_SIZE);
+  trickle.callback.func = _beacon;
+  trickle.callback.args = NULL;
+  trickle_start(sched_active_pid, &trickle, CONTACT_TRICKLE_MSG_TYPE_INTERVAL, CONTACT_TRICKLE_IMIN_MS,
+                CONTACT_TRICKLE_DOUBLINGS, CONTACT_TRICKLE_K);
+  while(1){
+    msg_receive(&msg);
+    switch(msg.type){
+      case CONTACT_TRICKLE_MSG_TYPE_INTERVAL:
+        trickle_callback(&trickle);
+        DEBUG("contact_scheduler: Next interval of %lu ms.\n", (unsigned long)trickle.I);
+        break;
+      case CONTACT_TRICKLE_MSG_TYPE_RESET:
+        /* already at the minimum interval, RFC 6206 section 4.2 */
+        if (trickle.I > trickle.Imin) {
+          DEBUG("contact_scheduler: Resetting trickle interval.\n");
+          trickle_reset_timer(&trickle);
+        }
+        break;
+      case CONTACT_TRICKLE_MSG_TYPE_CONSISTENT:
+        trickle_increment_counter(&trickle);
+        break;
+      default:
+        DEBUG("contact_scheduler: Unknown message type 0x%04x.\n", msg.type);
+        break;
+    }
+  }
+  return NULL;
+}
@@ -9,8 +9,12 @@
  *
  * @}
  */
-#include <math.h>
+#include <inttypes.h>
+
+#include "evtimer_msg.h"
+#include "fmt.h"
 #include "kernel_types.h"
+#include "random.h"
 #include "thread.h"
 #include "utlist.h"
 
@@ -20,7 +24,11 @@
 #include "net/gnrc/pktbuf.h"
 #include "net/gnrc/bundle_protocol/config.h"
 #include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_ack.h"
+#include "net/gnrc/bundle_protocol/bundle_fragment.h"
 #include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/bundle_summary.h"
+#include "net/gnrc/bundle_protocol/metrics.h"
 #include "net/gnrc/bundle_protocol/routing.h"
 
 #define ENABLE_DEBUG    (0)
@@ -28,9 +36,24 @@
 
 #include "od.h"
 
-static kernel_pid_t _pid = KERNEL_PID_UNDEF;
+/* Statistics are printed from the BP thread, not from the timer interrupt */
+#define GNRC_BP_MSG_TYPE_STATS (0x0290)
+#define GNRC_BP_MSG_TYPE_RETX (0x0291)
+#define GNRC_BP_MSG_TYPE_ACK (0x0292)
 
-int iface = 0;
+/* retx_count of bundles acked by a neighbor, they are not retransmitted any more */
+#define RETX_DONE (0xFF)
+
+static kernel_pid_t _pid = KERNEL_PID_UNDEF;
+static xtimer_t net_stats_timer;
+static msg_t net_stats_msg = { .type = GNRC_BP_MSG_TYPE_STATS };
+/* One event for the earliest retransmission deadline of all stored bundles */
+static evtimer_msg_t retx_timer;
+static evtimer_msg_event_t retx_event;
+/* Sends the acks collected since the first one was queued */
+static xtimer_t ack_timer;
+static msg_t ack_msg = { .type = GNRC_BP_MSG_TYPE_ACK };
+static bool ack_pending = false;
 
 
 #if ENABLE_DEBUG
@@ -42,10 +65,19 @@ static char _stack[GNRC_BP_STACK_SIZE];
 static void _receive(gnrc_pktsnip_t *pkt);
 static void _send(struct actual_bundle *bundle);
 static void _send_packet(gnrc_pktsnip_t *pkt);
+static bool _send_to_neighbor(gnrc_pktsnip_t *pkt, struct neighbor_t *neighbor);
 static void *_event_loop(void *args);
-static void retransmit_timer_callback(void *args);
-static int calculate_size_of_num(uint32_t num);
-static void net_stats_callback(void *args);
+static int _transmit(struct actual_bundle *bundle, int stat);
+static void _sent(struct actual_bundle *bundle, struct neighbor_t **receivers, int num);
+static void _retx_arm(struct actual_bundle *bundle);
+static void _retx_schedule(void);
+static void _retx_run(void);
+static void _ack_flush(void);
+static void _ack_range(void *arg, uint32_t src_num, uint32_t creation_timestamp0, uint32_t start, uint32_t count);
+static void _send_summary(struct neighbor_t *neighbor, bool request);
+static void _send_missing_bundles(struct neighbor_t *neighbor, const uint8_t *summary, size_t summary_len);
+static uint32_t _bundle_age(struct actual_bundle *bundle);
+static void _deliver_payload(struct actual_bundle *bundle, struct registration_status *application);
 
 kernel_pid_t gnrc_bp_init(void)
 {
@@ -85,49 +117,21 @@ int gnrc_bp_dispatch(gnrc_nettype_t type, uint32_t demux_ctx, struct actual_bund
   return ERROR;
 }
 
-void deliver_bundle(void *ptr, struct registration_status *application) {
+void deliver_bundle(gnrc_pktsnip_t *payload, struct registration_status *application) {
   update_statistics(BUNDLE_DELIVERY);
   msg_t msg;
-  msg.content.ptr = ptr;
-  msg_try_send(&msg, application->pid);
-}
-
-bool check_lifetime_expiry(struct actual_bundle *bundle) {
-  struct bundle_canonical_block_t *bundle_age_block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
-
-  if (bundle_age_block != NULL) {
-    if (bundle->primary_block.lifetime < strtoul((char*)bundle_age_block->block_data, NULL, bundle_age_block->data_len)) {
-      set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
-      delete_bundle(bundle);
-      return true;
-    }
-    else {
-      return false;
-    }
-  }
-  else {
-    return false;
+  msg.type = GNRC_NETAPI_MSG_TYPE_RCV;
+  msg.content.ptr = payload;
+  if (msg_try_send(&msg, application->pid) < 1) {
+    DEBUG("convergence_layer: Application did not take payload, dropping it.\n");
+    gnrc_pktbuf_release(payload);
   }
 }
 
-int process_bundle_before_forwarding(struct actual_bundle *bundle) {
-
-  /*Processing bundle and updating its bundle age block*/
-  struct bundle_canonical_block_t *bundle_age_block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
-
-  if (bundle_age_block != NULL) {
-    if (increment_bundle_age(bundle_age_block, bundle) < 0) {
-      DEBUG("convergence_layer: Error updating bundle age block.\n");
-      return ERROR;
-    }
-  }
-  return OK;
-}
-
-bool is_packet_ack(gnrc_pktsnip_t *pkt) {
-  char temp[ACK_IDENTIFIER_SIZE];
-  strncpy(temp, pkt->data, ACK_IDENTIFIER_SIZE);
-  if (strstr(temp, "ack") != NULL) {
+bool check_lifetime_expiry(struct actual_bundle *bundle) {
+  if (is_expired_bundle(bundle)) {
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
     return true;
   }
   return false;
@@ -135,53 +139,94 @@ bool is_packet_ack(gnrc_pktsnip_t *pkt) {
 
 static void _receive(gnrc_pktsnip_t *pkt) 
 {
-  struct router *cur_router;
-
-  cur_router = get_router();
-
   if(pkt->data == NULL) {
     DEBUG("convergence_layer: No data in packet, dropping it.\n");
     gnrc_pktbuf_release(pkt);
     return ;
   }
 
-  if (is_packet_ack(pkt)) {
+  if (bundle_ack_is_frame(pkt->data, pkt->size)) {
     update_statistics(ACK_RECEIVE);
-    uint8_t *temp_addr;
-    int src_addr_len;
-    char *creation_timestamp0, *creation_timestamp1;
-    uint32_t src_num;
-
-    src_addr_len = gnrc_netif_hdr_get_srcaddr(pkt, &temp_addr);
-    uint8_t src_addr[src_addr_len];
-    strncpy((char*)src_addr, (char*)temp_addr, src_addr_len);
-
-    struct neighbor_t *neighbor = get_neighbor_from_l2addr(src_addr);
+    struct neighbor_t *neighbor = neighbor_heard(pkt);
 
     if (neighbor == NULL) {
       DEBUG("convergence_layer: Could not find neighbor from whom data is received.\n");
+      gnrc_pktbuf_release(pkt);
       return ;
     }
 
-    strtok(pkt->data, "_");
-    creation_timestamp0 = strtok(NULL, "_");
-    creation_timestamp1 = strtok(NULL, "_");
-    src_num = strtoul(strtok(NULL, "_"), NULL, 10);
-    
-    cur_router->received_ack(neighbor, atoi(creation_timestamp0), atoi(creation_timestamp1), src_num);
-
+    if (bundle_ack_decode(pkt->data, pkt->size, _ack_range, neighbor) < 0) {
+      DEBUG("convergence_layer: Dropping malformed ack.\n");
+    }
+    gnrc_pktbuf_release(pkt);
+  }
+  else if (bundle_summary_is_frame(pkt->data, pkt->size)) {
+    update_statistics(SUMMARY_RECEIVE);
+    struct neighbor_t *neighbor = neighbor_heard(pkt);
+    const uint8_t *summary;
+    size_t summary_len;
+    bool request;
+
+    /* a neighbor not discovered yet gets the summary of this node once it is */
+    if (neighbor == NULL) {
+      DEBUG("convergence_layer: Summary vector from unknown neighbor, dropping it.\n");
+    }
+    else if (bundle_summary_decode(pkt->data, pkt->size, &request, &summary, &summary_len) < 0) {
+      DEBUG("convergence_layer: Dropping malformed summary vector.\n");
+    }
+    else {
+      _send_missing_bundles(neighbor, summary, summary_len);
+      if (request) {
+        _send_summary(neighbor, false);
+      }
+    }
     gnrc_pktbuf_release(pkt);
-    
   }
   else {
     update_statistics(BUNDLE_RECEIVE);
-    struct actual_bundle *bundle = create_bundle();
+
+    /* Dropping bundles processed before without claiming a storage slot */
+    struct bundle_id id;
+    bool peeked = bundle_peek_id(pkt->data, pkt->size, &id) == OK;
+    if (peeked && verify_bundle_id_processed(&id)) {
+      DEBUG("convergence_layer: Processed this bundle before, discarding bundle.\n");
+      send_non_bundle_ack(&id, pkt);
+      gnrc_pktbuf_release(pkt);
+      return ;
+    }
+
+    /* Same for bundles over their hop limit, acked so that the previous node stops retransmitting them */
+    uint32_t hop_limit, hop_count;
+    if (peeked && bundle_peek_hop_count(pkt->data, pkt->size, &hop_limit, &hop_count) == OK &&
+        hop_count >= hop_limit) {
+      DEBUG("convergence_layer: Hop limit of received bundle exceeded, discarding bundle.\n");
+      send_non_bundle_ack(&id, pkt);
+      add_bundle_id_to_processed_bundle_list(&id);
+      gnrc_pktbuf_release(pkt);
+      return ;
+    }
+
+    /* discovery beacons have slots of their own and never purge a bundle */
+    uint32_t service_num;
+    bool discovery = bundle_peek_service(pkt->data, pkt->size, &service_num) == OK &&
+                     service_num == (uint32_t)atoi(CONTACT_MANAGER_SERVICE_NUM);
+
+    /* Not acked, so that the sender keeps the bundle for another contact */
+    int priority = bundle_peek_priority(pkt->data, pkt->size);
+    if (!discovery && priority >= 0 && !bundle_storage_admit(priority)) {
+      DEBUG("convergence_layer: Storage too full for a bundle of priority %d, refusing it.\n", priority);
+      update_statistics(BUNDLE_REFUSE);
+      gnrc_pktbuf_release(pkt);
+      return ;
+    }
+
+    struct actual_bundle *bundle = discovery ? create_discovery_bundle() : create_bundle();
     if (bundle == NULL) {
       DEBUG("convergence_layer: Could not allocate space for this new bundle.\n");
       gnrc_pktbuf_release(pkt);
       return ;
     }
-    int res = bundle_decode(bundle, pkt->data, pkt->size);
+    int res = bundle_decode_pkt(bundle, pkt);
     if (res == ERROR) {
       DEBUG("convergence_layer: Packet received not for bundle protocol.\n");
       gnrc_pktbuf_release(pkt);
@@ -200,19 +245,31 @@ static void _receive(gnrc_pktsnip_t *pkt)
       return ;
     }
 
-    if (is_redundant_bundle(bundle) || verify_bundle_processed(bundle)) {
+    bundle_get_id(bundle, &id);
+    if (is_redundant_bundle(bundle)) {
       DEBUG("convergence_layer: Received this bundle before, discarding bundle");
       if (bundle->primary_block.service_num  != (uint32_t)atoi(CONTACT_MANAGER_SERVICE_NUM)){
-        send_non_bundle_ack(bundle, pkt);
+        send_non_bundle_ack(&id, pkt);
       }
       gnrc_pktbuf_release(pkt);
       set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
       delete_bundle(bundle);
       return ;
     }
+    if (bundle_count_hop(bundle) < 0) {
+      DEBUG("convergence_layer: Hop limit of received bundle exceeded, discarding bundle.\n");
+      send_non_bundle_ack(&id, pkt);
+      add_bundle_id_to_processed_bundle_list(&id);
+      gnrc_pktbuf_release(pkt);
+      set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+      delete_bundle(bundle);
+      return ;
+    }
 
 #ifdef MODULE_GNRC_CONTACT_MANAGER
     if (bundle->primary_block.service_num  == (uint32_t)atoi(CONTACT_MANAGER_SERVICE_NUM)) {
+      /* released by the contact manager thread */
+      set_retention_constraint(bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
       if (!gnrc_bp_dispatch(GNRC_NETTYPE_CONTACT_MANAGER, GNRC_NETREG_DEMUX_CTX_ALL, bundle, GNRC_NETAPI_MSG_TYPE_RCV)) {
         DEBUG("convergence_layer: no contact_manager thread found\n");
         set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
@@ -225,14 +282,7 @@ static void _receive(gnrc_pktsnip_t *pkt)
     }
 #endif
     else {
-
-      uint8_t *temp_addr;
-      int src_addr_len;
-      src_addr_len = gnrc_netif_hdr_get_srcaddr(pkt, &temp_addr);
-
-      uint8_t src_addr[src_addr_len];
-      strncpy((char*)src_addr, (char*)temp_addr, src_addr_len);
-      struct neighbor_t *previous_neighbor = get_neighbor_from_l2addr(src_addr);
+      struct neighbor_t *previous_neighbor = neighbor_heard(pkt);
 
       if (previous_neighbor == NULL) {
         DEBUG("convergence_layer: Could not find previous neighbor for this received bundle.\n");
@@ -246,7 +296,8 @@ static void _receive(gnrc_pktsnip_t *pkt)
       }
 
       /*Sending acknowledgement for received bundle*/
-      send_non_bundle_ack(bundle, pkt);
+      send_non_bundle_ack(&id, pkt);
+      add_bundle_id_to_processed_bundle_list(&id);
 
       gnrc_pktbuf_release(pkt);
 
@@ -255,53 +306,51 @@ static void _receive(gnrc_pktsnip_t *pkt)
         set_retention_constraint(bundle, SEND_ACK_PENDING_RETENTION_CONSTRAINT);
         bool delivered = true;
         struct registration_status *application = get_registration(bundle->primary_block.service_num);
-        if (application->status == REGISTRATION_ACTIVE) {
-          deliver_bundle((void *)(bundle_get_payload_block(bundle)->block_data), application);
+        if (application != NULL && application->status == REGISTRATION_ACTIVE) {
+          _deliver_payload(bundle, application);
           delivered = true;
         }
         else {
           DEBUG("convergence_layer: Couldn't deliver bundle to application.\n");
           delivered = false;
+          bundle_storage_persist(bundle);
         }
         set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
         if (delivered) {
           DEBUG("convergence_layer: Bundle delivered to application layer, deleting from here.\n");
-          add_bundle_to_processed_bundle_list(bundle);
           delete_bundle(bundle);
         }
       } /*Bundle not for this node, forward received bundle*/
       else {
         struct router *cur_router = get_router();
-        nanocbor_encoder_t enc;
-        gnrc_netif_t *netif = NULL;
-        struct neighbor_t *temp;
+        struct neighbor_t *neighbors_to_send[ROUTING_MAX_RECEIVERS];
         bool sent = false;
 
         set_retention_constraint(bundle, FORWARD_PENDING_RETENTION_CONSTRAINT);
+        /* In custody of this node from here on, written as received before being modified */
+        bundle_storage_persist(bundle);
+#ifdef MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE
+        /* look for contacts quickly while there is something to forward */
+        gnrc_contact_scheduler_trickle_reset();
+#endif
 
-        netif = gnrc_netif_get_by_pid(iface);
-
-        struct neighbor_t *neighbors_to_send = cur_router->route_receivers(bundle->primary_block.dst_num);
-        if (neighbors_to_send == NULL) {
+        int num_neighbors = cur_router->route_receivers(bundle, neighbors_to_send, ROUTING_MAX_RECEIVERS);
+        if (num_neighbors == 0) {
           DEBUG("convergence_layer: Could not find neighbors to send bundle to.\n");
+          set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+          _retx_arm(bundle);
           return ;
         }
-
-        if(process_bundle_before_forwarding(bundle) < 0) {
-          return ;
+        if (cur_router->prepare_send != NULL) {
+          cur_router->prepare_send(bundle, neighbors_to_send, num_neighbors);
         }
-        nanocbor_encoder_init(&enc, NULL, 0);
-        bundle_encode(bundle, &enc);
-        size_t required_size = nanocbor_encoded_len(&enc);
-        uint8_t *buf = malloc(required_size);
-        nanocbor_encoder_init(&enc, buf, required_size);
-        bundle_encode(bundle, &enc);
-
-        gnrc_pktsnip_t *forward_pkt = gnrc_pktbuf_add(NULL, buf, (int)required_size, GNRC_NETTYPE_BP);
+
+        /* carries the age at the time it is sent, the stored age is kept */
+        gnrc_pktsnip_t *forward_pkt = bundle_wire_pkt(bundle);
         if (forward_pkt == NULL) {
-          DEBUG("convergence_layer: unable to copy data to packet buffer.\n");
-          gnrc_pktbuf_release(forward_pkt);
-          free(buf);
+          DEBUG("convergence_layer: unable to encode bundle into packet buffer.\n");
+          set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+          _retx_arm(bundle);
           return ;
         }
 
@@ -309,23 +358,23 @@ static void _receive(gnrc_pktsnip_t *pkt)
           Handling not sending to previous node here since the solution would require more malloc
           and space is problem on these low power nodes
         */
-        LL_FOREACH(neighbors_to_send, temp) {
-          if (temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num && memcmp(temp->l2addr, previous_neighbor->l2addr, temp->l2addr_len) != 0) {
-            sent = true;
-            if (netif != NULL) {
-              gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, temp->l2addr, temp->l2addr_len);
-              gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
-              LL_PREPEND(forward_pkt, netif_hdr);
-            }
-            if (netif->pid != 0) {
-              gnrc_netapi_send(netif->pid, forward_pkt);
+        int num_sent = 0;
+        for (int i = 0; i < num_neighbors; i++) {
+          struct neighbor_t *temp = neighbors_to_send[i];
+          if (temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num
+              && temp != previous_neighbor) {
+            if (_send_to_neighbor(forward_pkt, temp)) {
+              neighbors_to_send[num_sent++] = temp;
+              sent = true;
             }
           }
         }
+        _sent(bundle, neighbors_to_send, num_sent);
+        gnrc_pktbuf_release(forward_pkt);
         set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+        _retx_arm(bundle);
         if(!sent) {
-          DEBUG("convergence_layer: bundle not sent, deleting from encoded buffer.\n");
-          free(buf);
+          DEBUG("convergence_layer: bundle not sent to any neighbor.\n");
         }
       }
     }
@@ -335,104 +384,142 @@ static void _receive(gnrc_pktsnip_t *pkt)
 
 static void _send(struct actual_bundle *bundle)
 {
+  /* retained by the agent while it was in the message queue */
+  set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
   uint8_t registration_status = get_registration_status(bundle->primary_block.service_num);
   if (registration_status == REGISTRATION_ACTIVE) {
-    set_retention_constraint(bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
-    struct router *cur_router = get_router();
-    struct neighbor_t *temp;
-    struct bundle_canonical_block_t *bundle_age_block;
-    struct neighbor_t *neighbor_list_to_send;
-    uint32_t original_bundle_age = 0;
+#ifdef MODULE_GNRC_CONTACT_SCHEDULER_TRICKLE
+    gnrc_contact_scheduler_trickle_reset();
+#endif
+    if (_transmit(bundle, BUNDLE_SEND) >= 0) {
+      _retx_arm(bundle);
+    }
+    return ;
+  }
+  else if (registration_status == REGISTRATION_PASSIVE){
+    DEBUG("convergence_layer: Application not active to send bundles.\n");
+    return ;
+  }
+  else {
+    DEBUG("convergence_layer: Application not registered .\n");
+    return;
+  }
+}
 
-    gnrc_netif_t *netif = NULL;
-    nanocbor_encoder_t enc;
+/* Tells the router which of the receivers it prepared the bundle for it was sent to */
+static void _sent(struct actual_bundle *bundle, struct neighbor_t **receivers, int num)
+{
+  struct router *cur_router = get_router();
 
-    netif = gnrc_netif_get_by_pid(iface);
+  if (cur_router->sent != NULL) {
+    cur_router->sent(bundle, receivers, num);
+  }
+}
 
-    neighbor_list_to_send = cur_router->route_receivers(bundle->primary_block.dst_num);
-    if (neighbor_list_to_send == NULL) {
-      DEBUG("convergence_layer: Could not find neighbors to send bundle to.\n");
-      return ;
-    }
+/*
+  Sends a stored bundle to the neighbors chosen by the router that have not acked it yet, counting
+  every transmission as stat. Returns the number of neighbors it was sent to, which is 0 if it
+  could not be encoded for now, or ERROR if the bundle was deleted as expired.
+*/
+static int _transmit(struct actual_bundle *bundle, int stat)
+{
+  struct router *cur_router = get_router();
+  struct neighbor_t *neighbor_list_to_send[ROUTING_MAX_RECEIVERS];
+  int sent = 0;
 
-    bundle_age_block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
-    if(bundle_age_block != NULL) {
-      original_bundle_age = atoi((char*)bundle_age_block->block_data);
-      if(increment_bundle_age(bundle_age_block, bundle) < 0) {
-        DEBUG("convergence_layer: Bundle expired.\n");
-        set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
-        delete_bundle(bundle);
-        return;
-      }
-    }
-    nanocbor_encoder_init(&enc, NULL, 0);
-    bundle_encode(bundle, &enc);
-    size_t required_size = nanocbor_encoded_len(&enc);
-    uint8_t *buf = malloc(required_size);
-    nanocbor_encoder_init(&enc, buf, required_size);
-    bundle_encode(bundle, &enc);
+  int num_neighbors = cur_router->route_receivers(bundle, neighbor_list_to_send, ROUTING_MAX_RECEIVERS);
+  if (num_neighbors == 0) {
+    DEBUG("convergence_layer: Could not find neighbors to send bundle to.\n");
+    return 0;
+  }
+  if (cur_router->prepare_send != NULL) {
+    cur_router->prepare_send(bundle, neighbor_list_to_send, num_neighbors);
+  }
 
-    gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, buf, (int)required_size, GNRC_NETTYPE_BP);
-    if (pkt == NULL) {
-      DEBUG("convergence_layer: unable to copy data to discovery packet buffer.\n");
-      gnrc_pktbuf_release(pkt);
-      free(buf);
-      return ;
-    }
+  if (is_expired_bundle(bundle)) {
+    DEBUG("convergence_layer: Bundle expired.\n");
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(bundle);
+    return ERROR;
+  }
 
-    LL_FOREACH(neighbor_list_to_send, temp) {
-      struct delivered_bundle_list *ack_list, *temp_ack_list;
-      ack_list = cur_router->get_delivered_bundle_list();
-      /*
-        Sending bundle for the first time from this node
-      */
-      if (ack_list == NULL && temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num) {
-        if (netif != NULL) {
-          gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, temp->l2addr, temp->l2addr_len);
-          gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
-          LL_PREPEND(pkt, netif_hdr);
-        }
-        if (netif->pid != 0) {
-          gnrc_netapi_send(netif->pid, pkt);
-          update_statistics(BUNDLE_SEND);
-        }
-      } 
-      else {
-        bool found = false;
-        LL_FOREACH(ack_list, temp_ack_list) {
-          if ((is_same_bundle(bundle, temp_ack_list->bundle) && is_same_neighbor(temp, temp_ack_list->neighbor))) {
-            DEBUG("convergence_layer: Already delivered bundle with creation time %lu to %lu, breaking out of loop of ack_list.\n", bundle->local_creation_time, temp->endpoint_num);
-            found = true;
-            break;
-          }
+  set_retention_constraint(bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
+  gnrc_pktsnip_t *pkt = bundle_wire_pkt(bundle);
+  if (pkt == NULL) {
+    DEBUG("convergence_layer: unable to encode bundle into packet buffer.\n");
+    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+    /* retransmitted once the packet buffer has room again */
+    return 0;
+  }
+
+  bundle->last_send_time = xtimer_now_usec();
+  for (int i = 0; i < num_neighbors; i++) {
+    struct neighbor_t *temp = neighbor_list_to_send[i];
+    struct delivered_bundle_list *ack_list, *temp_ack_list;
+    ack_list = cur_router->get_delivered_bundle_list();
+    /*
+      Sending bundle for the first time from this node
+    */
+    if (ack_list == NULL && temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num) {
+      if (_send_to_neighbor(pkt, temp)) {
+        update_statistics(stat);
+        neighbor_list_to_send[sent++] = temp;
+      }
+    }
+    else {
+      bool found = false;
+      LL_FOREACH(ack_list, temp_ack_list) {
+        if ((is_same_bundle(bundle, temp_ack_list->bundle) && is_same_neighbor(temp, temp_ack_list->neighbor))) {
+          DEBUG("convergence_layer: Already delivered bundle with creation time %" PRIu32 " to %" PRIu32 ", breaking out of loop of ack_list.\n", bundle->local_creation_time, temp->endpoint_num);
+          found = true;
+          break;
         }
-        if (!found && temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num) {
-          if (netif != NULL) {
-            gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, temp->l2addr, temp->l2addr_len);
-            gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
-            LL_PREPEND(pkt, netif_hdr);
-          }
-          if (netif->pid != 0) {
-            gnrc_netapi_send(netif->pid, pkt);
-            update_statistics(BUNDLE_SEND);
-          }
+      }
+      if (!found && temp->endpoint_scheme == IPN && temp->endpoint_num != bundle->previous_endpoint_num) {
+        if (_send_to_neighbor(pkt, temp)) {
+          update_statistics(stat);
+          neighbor_list_to_send[sent++] = temp;
         }
       }
     }
-    if (reset_bundle_age(bundle_age_block, original_bundle_age) < 0) {
-      DEBUG("convergence_layer: Error resetting bundle age to original.\n");
-    }
-    set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
-    return ;
-  }
-  else if (registration_status == REGISTRATION_PASSIVE){
-    DEBUG("convergence_layer: Application not active to send bundles.\n");
-    return ;
   }
-  else {
-    DEBUG("convergence_layer: Application not registered .\n");
-    return;
+  /* the neighbors sent to were moved to the front */
+  _sent(bundle, neighbor_list_to_send, sent);
+  gnrc_pktbuf_release(pkt);
+  set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+  return sent;
+}
+
+/*
+  Sends an encoded bundle to one neighbor over the best of its links, or the next best one if the
+  interface does not take it. The encoded bundle is shared between all neighbors it is sent to, so
+  every transmission holds its own reference and the caller releases its reference once done.
+*/
+static bool _send_to_neighbor(gnrc_pktsnip_t *pkt, struct neighbor_t *neighbor)
+{
+  struct neighbor_link_t *links[CONTACT_MANAGER_MAX_LINKS];
+  int num_links = get_neighbor_links(neighbor, links);
+
+  for (int i = 0; i < num_links; i++) {
+    gnrc_netif_t *netif = gnrc_netif_get_by_pid(links[i]->iface);
+    if (netif == NULL) {
+      continue;
+    }
+    gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, links[i]->l2addr, links[i]->l2addr_len);
+    if (netif_hdr == NULL) {
+      DEBUG("convergence_layer: unable to allocate netif header.\n");
+      return false;
+    }
+    gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
+    gnrc_pktbuf_hold(pkt, 1);
+    netif_hdr->next = pkt;
+    if (gnrc_netapi_send(netif->pid, netif_hdr) >= 1) {
+      return true;
+    }
+    DEBUG("convergence_layer: unable to send bundle to interface %d, trying the next link.\n", netif->pid);
+    gnrc_pktbuf_release(netif_hdr);
   }
+  return false;
 }
 
 static void _send_packet(gnrc_pktsnip_t *pkt)
@@ -450,7 +537,6 @@ static void _send_packet(gnrc_pktsnip_t *pkt)
 static void *_event_loop(void *args)
 {
   msg_t msg, msg_q[GNRC_BP_MSG_QUEUE_SIZE];
-  xtimer_t *timer = malloc(sizeof(xtimer_t));
 
   gnrc_netreg_entry_t me_reg = GNRC_NETREG_ENTRY_INIT_PID(GNRC_NETREG_DEMUX_CTX_ALL, sched_active_pid);
   (void)args;
@@ -458,32 +544,49 @@ static void *_event_loop(void *args)
   msg_init_queue(msg_q, GNRC_BP_MSG_QUEUE_SIZE);
 
   gnrc_netreg_register(GNRC_NETTYPE_BP, &me_reg);
+  /* other threads adding block data fail instead of purging bundles */
+  bundle_storage_set_purge_pid(sched_active_pid);
 
-  timer->callback = &retransmit_timer_callback;
-  timer->arg = timer;
-  xtimer_set(timer, xtimer_ticks_from_usec(RETRANSMIT_TIMER_SECONDS).ticks32);
-
-  xtimer_t *net_stats_timer = malloc(sizeof(xtimer_t));
-  net_stats_timer->callback = &net_stats_callback;
-  net_stats_timer->arg = net_stats_timer;
-  xtimer_set(net_stats_timer, xtimer_ticks_from_usec(NET_STATS_SECONDS).ticks32);
+  evtimer_init_msg(&retx_timer);
+  xtimer_set_msg(&net_stats_timer, NET_STATS_SECONDS, &net_stats_msg, _pid);
 
   while(1){
     DEBUG("convergence_layer: waiting for incoming message.\n");
     msg_receive(&msg);
+    bp_metrics_record(BP_METRICS_HIST_QUEUE_DEPTH, msg_avail());
     switch(msg.type){
       case GNRC_NETAPI_MSG_TYPE_SND:
           DEBUG("convergence_layer: GNRC_NETDEV_MSG_TYPE_SND received\n");
-          if(strcmp(thread_get(msg.sender_pid)->name, "contact_manager") == 0) {
+#ifdef MODULE_GNRC_CONTACT_MANAGER
+          /* returns the pid of the running contact manager thread */
+          if (msg.sender_pid == gnrc_contact_manager_init()) {
             _send_packet(msg.content.ptr);
             break;
           }
+#endif
           _send(msg.content.ptr);
           break;
       case GNRC_NETAPI_MSG_TYPE_RCV:
           DEBUG("convergence_layer: GNRC_NETDEV_MSG_TYPE_RCV received\n");
           _receive(msg.content.ptr);
           break;
+      case GNRC_BP_MSG_TYPE_RETX:
+          _retx_run();
+          break;
+      case GNRC_BP_MSG_TYPE_ACK:
+          _ack_flush();
+          break;
+#ifdef MODULE_GNRC_CONTACT_MANAGER
+      case GNRC_BP_MSG_TYPE_REMOVE_NEIGHBOR:
+          /* no neighbor is held between two messages */
+          contact_manager_remove_neighbor(msg.content.ptr);
+          msg_reply(&msg, &msg);
+          break;
+#endif
+      case GNRC_BP_MSG_TYPE_STATS:
+          print_network_statistics();
+          xtimer_set_msg(&net_stats_timer, NET_STATS_SECONDS, &net_stats_msg, _pid);
+          break;
       default:
         DEBUG("convergence_layer: Successfully entered bp, yayyyyyy!!\n");
         break;
@@ -493,147 +596,307 @@ static void *_event_loop(void *args)
 }
 
 
-static void net_stats_callback(void *args) {
-  print_network_statistics();
-  xtimer_set(args, xtimer_ticks_from_usec(NET_STATS_SECONDS).ticks32);
+static uint32_t _now_ms(void)
+{
+  return xtimer_now_usec64() / US_PER_MS;
 }
 
-static void retransmit_timer_callback(void *args) {
-  struct bundle_list *bundle_storage_list = get_bundle_list(), *temp;
-  uint8_t active_bundles = get_current_active_bundles(), i = 0;
-  temp = bundle_storage_list;
-  while (temp != NULL && i < active_bundles && get_retention_constraint(&temp->current_bundle) == NO_RETENTION_CONSTRAINT 
-          && temp->current_bundle.primary_block.dst_num != strtoul(get_src_num(), NULL, 10) 
-          && temp->current_bundle.primary_block.service_num != strtoul(CONTACT_MANAGER_SERVICE_NUM, NULL, 10) ) {
+/* Sets the next retransmission deadline of a bundle with exponential backoff and jitter */
+static void _retx_backoff(struct actual_bundle *bundle)
+{
+  if (bundle->retx_count >= GNRC_BP_RETX_LIMIT) {
+    bundle->retx_deadline = 0;
+    return ;
+  }
+  uint32_t backoff = GNRC_BP_RETX_MAX_MS;
+  if (bundle->retx_count < 31 && ((uint64_t)GNRC_BP_RETX_BASE_MS << bundle->retx_count) < GNRC_BP_RETX_MAX_MS) {
+    backoff = GNRC_BP_RETX_BASE_MS << bundle->retx_count;
+  }
+  uint32_t spread = (uint64_t)backoff * GNRC_BP_RETX_JITTER_PERCENT / 100;
+  backoff = backoff - spread + random_uint32_range(0, 2 * spread + 1);
 
-    if(!gnrc_bp_dispatch(GNRC_NETTYPE_BP, GNRC_NETREG_DEMUX_CTX_ALL, &temp->current_bundle, GNRC_NETAPI_MSG_TYPE_SND)) {
-      printf("convergence_layer: Unable to find BP thread.\n");
-      return ;
-    } 
-    /*update statistics if bundle successfully dispatched for retransmission to BP thread
-     *This is although ignoring the case where the bundle transmission is stopped due to lifetime expiry
-     *or any other reason
-     */
-    else {
-      update_statistics(BUNDLE_RETRANSMIT);
+  bundle->retx_deadline = _now_ms() + backoff;
+  /* 0 marks no scheduled retransmission */
+  if (bundle->retx_deadline == 0) {
+    bundle->retx_deadline = 1;
+  }
+}
+
+static void _retx_arm(struct actual_bundle *bundle)
+{
+  _retx_backoff(bundle);
+  _retx_schedule();
+}
+
+/* Arms the timer for the earliest retransmission deadline of all stored bundles */
+static void _retx_schedule(void)
+{
+  struct bundle_list *temp;
+  uint32_t now = _now_ms();
+  int32_t delay = INT32_MAX;
+
+  LL_FOREACH(get_bundle_list(), temp) {
+    if (temp->current_bundle.retx_deadline != 0) {
+      int32_t left = temp->current_bundle.retx_deadline - now;
+      delay = (left < delay) ? left : delay;
     }
-    temp = temp->next;
-    i++;
   }
-  xtimer_set(args, xtimer_ticks_from_usec(RETRANSMIT_TIMER_SECONDS).ticks32);
+  /* a pending wakeup that already fired is handled like any other */
+  evtimer_del(&retx_timer, &retx_event.event);
+  if (delay == INT32_MAX) {
+    return ;
+  }
+  retx_event.event.offset = (delay > 0) ? (uint32_t)delay : 0;
+  retx_event.msg.type = GNRC_BP_MSG_TYPE_RETX;
+  evtimer_add_msg(&retx_timer, &retx_event, _pid);
 }
 
-void send_bundles_to_new_neighbor(struct neighbor_t *neighbor) {
-    struct bundle_list *bundle_store_list, *temp_bundle;
-    struct delivered_bundle_list *ack_list, *temp_ack_list;
-    uint8_t active_bundles = get_current_active_bundles(), i = 0;
+/*
+  Retransmits all bundles due now or within the batch window, higher priority classes first. Runs
+  in the BP thread.
+*/
+static void _retx_run(void)
+{
+  struct bundle_list *temp, *next;
+  uint32_t now = _now_ms();
+
+  for (int priority = BUNDLE_PRIORITY_CLASSES - 1; priority >= 0; priority--) {
+    LL_FOREACH_SAFE(get_bundle_list(), temp, next) {
+      struct actual_bundle *bundle = &temp->current_bundle;
+      if (bundle_get_priority(bundle) != priority || bundle->retx_deadline == 0 ||
+          (int32_t)(bundle->retx_deadline - now) > (int32_t)GNRC_BP_RETX_BATCH_MS) {
+        continue;
+      }
+      if (get_retention_constraint(bundle) != NO_RETENTION_CONSTRAINT) {
+        /* busy right now, tried again with the next batch */
+        bundle->retx_deadline = now + GNRC_BP_RETX_BATCH_MS + 1;
+        continue;
+      }
+      bundle->retx_deadline = 0;
+      bundle->retx_count++;
+      /* only left unscheduled if the bundle was deleted as expired */
+      if (_transmit(bundle, BUNDLE_RETRANSMIT) >= 0) {
+        DEBUG("convergence_layer: Retransmitted bundle, attempt %u.\n", bundle->retx_count);
+        _retx_backoff(bundle);
+      }
+    }
+  }
+  _retx_schedule();
+}
 
-    ack_list = get_router()->get_delivered_bundle_list();
+/* Whether the router hands the bundle to the neighbor */
+static bool _routes_to(struct actual_bundle *bundle, struct neighbor_t *neighbor)
+{
+  struct neighbor_t *receivers[ROUTING_MAX_RECEIVERS];
+  int num = get_router()->route_receivers(bundle, receivers, ROUTING_MAX_RECEIVERS);
 
-    bundle_store_list = get_bundle_list();
-    temp_bundle = bundle_store_list;
-    while(temp_bundle != NULL && i < active_bundles) {
-      if(temp_bundle->current_bundle.primary_block.dst_num != (uint32_t)atoi(BROADCAST_EID)) {
+  for (int i = 0; i < num; i++) {
+    if (receivers[i] == neighbor) {
+      return true;
+    }
+  }
+  return false;
+}
 
-        /*
-          Checking if the bundle was already delivered to this neighbor earlier
-        */
-        LL_FOREACH(ack_list, temp_ack_list){
-          if ((is_same_bundle(&temp_bundle->current_bundle, temp_ack_list->bundle) && is_same_neighbor(neighbor, temp_ack_list->neighbor))){
-            DEBUG("convergence_layer: Already delivered bundle with creation time %lu to %lu.\n", temp_bundle->current_bundle.local_creation_time, neighbor->endpoint_num);
-            continue;
-          } 
-        }
-        gnrc_netif_t *netif = NULL;
-        nanocbor_encoder_t enc;
-        uint32_t original_bundle_age = 0;
-
-        netif = gnrc_netif_get_by_pid(iface);
-
-        struct bundle_canonical_block_t *bundle_age_block = get_block_by_type(&temp_bundle->current_bundle, BUNDLE_BLOCK_TYPE_BUNDLE_AGE);
-        if(bundle_age_block != NULL) {
-          original_bundle_age = atoi((char*)bundle_age_block->block_data);
-          if(increment_bundle_age(bundle_age_block, &temp_bundle->current_bundle) < 0) {
-            DEBUG("convergence_layer: Cannot send this bundle to the new neighbor, it has expired.\n");
-            struct bundle_list *next_bundle = temp_bundle->next;
-            set_retention_constraint(&temp_bundle->current_bundle, NO_RETENTION_CONSTRAINT);
-            delete_bundle(&temp_bundle->current_bundle);
-            temp_bundle = next_bundle;
-            continue;
-          }
-        }
+/* Whether the neighbor acked the bundle before */
+static bool _delivered_to(struct actual_bundle *bundle, struct neighbor_t *neighbor)
+{
+  struct delivered_bundle_list *temp;
 
-        nanocbor_encoder_init(&enc, NULL, 0);
-        bundle_encode(&temp_bundle->current_bundle, &enc);
-        size_t required_size = nanocbor_encoded_len(&enc);
-        uint8_t *buf = malloc(required_size);
-        nanocbor_encoder_init(&enc, buf, required_size);
-        bundle_encode(&temp_bundle->current_bundle, &enc);
-
-        gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, buf, (int)required_size, GNRC_NETTYPE_BP);
-        if (pkt == NULL) {
-          DEBUG("convergence_layer: unable to copy data to packet buffer.\n");
-          gnrc_pktbuf_release(pkt);
-          free(buf);
-          return ;
-        }
-        
-       if (netif != NULL) {
-            gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, neighbor->l2addr, neighbor->l2addr_len);
-            gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
-            LL_PREPEND(pkt, netif_hdr);
-        }
-        if (netif->pid != 0) {
-          DEBUG("convergence_layer: Sending stored packet to process with pid %d.\n", netif->pid);
-          gnrc_netapi_send(netif->pid, pkt);
-          update_statistics(BUNDLE_SEND);
-        }
-        /*Will reset bundle age to original so that the bundle's age can be correctly identified
-          when updating the bundle age the next time when sending to someone else.
-          Also, cannot do this by simply updating the local creation time since that is used for 
-          bundle purging to identify the oldest bundle*/
-        if (original_bundle_age != 0) {
-          if (reset_bundle_age(bundle_age_block, original_bundle_age) < 0) {
-            DEBUG("convergence_layer: Error resetting bundle age to original.\n");
-          }
-        }
-      }
-      temp_bundle = temp_bundle->next;
-      i++;
+  LL_FOREACH(get_router()->get_delivered_bundle_list(), temp) {
+    if (is_same_bundle(bundle, temp->bundle) && is_same_neighbor(neighbor, temp->neighbor)) {
+      return true;
     }
-    return ;
+  }
+  return false;
 }
 
-void send_non_bundle_ack(struct actual_bundle *bundle, gnrc_pktsnip_t *pkt) {
-  DEBUG("convergence_layer: Sending non bundle acknowledgement.\n");
-  gnrc_netif_t *netif = NULL;
-  gnrc_pktsnip_t *ack_payload;
-  uint8_t *temp_addr;
-  uint8_t src_addr_len;
-  
-  char data[MAX_ACK_SIZE];
+/* Sends the summary vector of this node to a neighbor, asking for its summary in return if request is set */
+static void _send_summary(struct neighbor_t *neighbor, bool request)
+{
+  uint8_t data[GNRC_BP_LINK_MTU];
+  int len = bundle_summary_encode(data, sizeof(data), request);
 
-  netif = gnrc_netif_get_by_pid(iface);
+  if (len < 0) {
+    DEBUG("convergence_layer: Cannot send summary vector.\n");
+    return ;
+  }
+  gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, data, len, GNRC_NETTYPE_UNDEF);
+  if (pkt == NULL) {
+    DEBUG("convergence_layer: unable to allocate summary vector.\n");
+    return ;
+  }
+  if (_send_to_neighbor(pkt, neighbor)) {
+    update_statistics(SUMMARY_SEND);
+  }
+  gnrc_pktbuf_release(pkt);
+}
 
-  sprintf(data, "ack_%lu_%lu_%lu", bundle->primary_block.creation_timestamp[0], bundle->primary_block.creation_timestamp[1], bundle->primary_block.src_num);
+void send_summary_vector(struct neighbor_t *neighbor) {
+  _send_summary(neighbor, true);
+}
 
-  ack_payload = gnrc_pktbuf_add(NULL, data, strlen(data), GNRC_NETTYPE_UNDEF);
+/*
+  Sends the stored bundles routed to a neighbor that are not in its summary vector and that it did
+  not ack before, by priority class and within a class those destined to the neighbor first.
+*/
+static void _send_missing_bundles(struct neighbor_t *neighbor, const uint8_t *summary, size_t summary_len)
+{
+  struct bundle_list *temp_bundle, *next_bundle;
+  unsigned sent = 0, skipped = 0;
 
-  //TODO: Change the src_num to the node from which the packet has just been received
-  src_addr_len = gnrc_netif_hdr_get_srcaddr(pkt, &temp_addr);
+  if (get_router() == NULL) {
+    DEBUG("convergence_layer: No router to send stored bundles with.\n");
+    return ;
+  }
+  for (int pass = 0; pass < 2 * BUNDLE_PRIORITY_CLASSES; pass++) {
+    uint8_t priority = BUNDLE_PRIORITY_CLASSES - 1 - pass / 2;
+
+    LL_FOREACH_SAFE(get_bundle_list(), temp_bundle, next_bundle) {
+      struct actual_bundle *bundle = &temp_bundle->current_bundle;
+      struct bundle_id id;
+
+      if (bundle_get_priority(bundle) != priority ||
+          (bundle->primary_block.dst_num == neighbor->endpoint_num) != (pass % 2 == 0) ||
+          bundle->primary_block.dst_num == (uint32_t)atoi(BROADCAST_EID) ||
+          get_retention_constraint(bundle) != NO_RETENTION_CONSTRAINT) {
+        continue;
+      }
+      bundle_get_id(bundle, &id);
+      if (bundle_storage_summary_check(summary, summary_len, &id) || _delivered_to(bundle, neighbor)) {
+        DEBUG("convergence_layer: Neighbor %" PRIu32 " has bundle with creation time %" PRIu32 " already.\n", neighbor->endpoint_num, bundle->local_creation_time);
+        skipped++;
+        continue;
+      }
+      if (!_routes_to(bundle, neighbor)) {
+        continue;
+      }
 
-  if (netif != NULL) {
-      gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, temp_addr, src_addr_len);
+      if (is_expired_bundle(bundle)) {
+        DEBUG("convergence_layer: Cannot send this bundle to the new neighbor, it has expired.\n");
+        delete_bundle(bundle);
+        continue;
+      }
+      if (get_router()->prepare_send != NULL) {
+        get_router()->prepare_send(bundle, &neighbor, 1);
+      }
+      gnrc_pktsnip_t *pkt = bundle_wire_pkt(bundle);
+      if (pkt == NULL) {
+        DEBUG("convergence_layer: unable to encode bundle into packet buffer.\n");
+        return ;
+      }
+      if (_send_to_neighbor(pkt, neighbor)) {
+        bundle->last_send_time = xtimer_now_usec();
+        update_statistics(BUNDLE_SEND);
+        _sent(bundle, &neighbor, 1);
+        sent++;
+      }
+      else {
+        _sent(bundle, &neighbor, 0);
+      }
+      gnrc_pktbuf_release(pkt);
+    }
+  }
+  DEBUG("convergence_layer: Sent %u bundles to %" PRIu32 ", %u it had already.\n", sent, neighbor->endpoint_num, skipped);
+}
+
+/*
+  Queues an ack for a received bundle to the neighbor it came from, over the interface it came in
+  on. Acks are sent in batches.
+*/
+void send_non_bundle_ack(const struct bundle_id *id, gnrc_pktsnip_t *pkt) {
+  DEBUG("convergence_layer: Queueing non bundle acknowledgement.\n");
+  gnrc_pktsnip_t *netif_snip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_NETIF);
+  gnrc_netif_hdr_t *hdr = (netif_snip != NULL) ? netif_snip->data : NULL;
+  int free_entries;
+
+  if (hdr == NULL || hdr->src_l2addr_len == 0) {
+    DEBUG("convergence_layer: No source address to send the ack to.\n");
+    return ;
+  }
 
-      gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
-      LL_PREPEND(ack_payload, netif_hdr);
+  uint8_t *src_addr = gnrc_netif_hdr_get_src_addr(hdr);
+  free_entries = bundle_ack_queue(id, src_addr, hdr->src_l2addr_len, hdr->if_pid);
+  if (free_entries == ERROR) {
+    _ack_flush();
+    free_entries = bundle_ack_queue(id, src_addr, hdr->src_l2addr_len, hdr->if_pid);
   }
-  if (netif->pid != 0) {
-    gnrc_netapi_send(netif->pid, ack_payload);
+  if (free_entries == 0) {
+    _ack_flush();
+  }
+  else if (free_entries > 0 && !ack_pending) {
+    ack_pending = true;
+    xtimer_set_msg(&ack_timer, GNRC_BP_ACK_DELAY_MS * US_PER_MS, &ack_msg, _pid);
+  }
+}
+
+/* Sends all queued acks, as few frames per neighbor as they fit into */
+static void _ack_flush(void)
+{
+  uint8_t data[GNRC_BP_LINK_MTU], l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+  size_t l2addr_len;
+  kernel_pid_t iface;
+  int len;
+
+  xtimer_remove(&ack_timer);
+  ack_pending = false;
+
+  while ((len = bundle_ack_encode_next(data, sizeof(data), l2addr, &l2addr_len, &iface)) > 0) {
+    gnrc_netif_t *netif = gnrc_netif_get_by_pid(iface);
+    if (netif == NULL) {
+      DEBUG("convergence_layer: No interface to send acks on.\n");
+      continue;
+    }
+    gnrc_pktsnip_t *ack_payload = gnrc_pktbuf_add(NULL, data, len, GNRC_NETTYPE_UNDEF);
+    if (ack_payload == NULL) {
+      DEBUG("convergence_layer: unable to allocate ack.\n");
+      continue;
+    }
+    gnrc_pktsnip_t *netif_hdr = gnrc_netif_hdr_build(NULL, 0, l2addr, l2addr_len);
+    if (netif_hdr == NULL) {
+      DEBUG("convergence_layer: unable to allocate netif header.\n");
+      gnrc_pktbuf_release(ack_payload);
+      continue;
+    }
+    gnrc_netif_hdr_set_netif(netif_hdr->data, netif);
+    LL_PREPEND(ack_payload, netif_hdr);
+    if (gnrc_netapi_send(netif->pid, ack_payload) < 1) {
+      DEBUG("convergence_layer: unable to send ack to interface %d.\n", netif->pid);
+      gnrc_pktbuf_release(ack_payload);
+      continue;
+    }
     update_statistics(ACK_SEND);
   }
 }
 
+/* Handles the stored bundles in a range acked by the neighbor in arg */
+static void _ack_range(void *arg, uint32_t src_num, uint32_t creation_timestamp0, uint32_t start, uint32_t count)
+{
+  struct neighbor_t *neighbor = arg;
+  struct bundle_list *temp, *next;
+
+  /* the range may be longer than the store, so the store is walked instead of the range */
+  LL_FOREACH_SAFE(get_bundle_list(), temp, next) {
+    struct actual_bundle *acked = &temp->current_bundle;
+    if (acked->primary_block.src_num != src_num || acked->primary_block.creation_timestamp[0] != creation_timestamp0 ||
+        acked->primary_block.creation_timestamp[1] - start >= count) {
+      continue;
+    }
+    if (acked->last_send_time != 0) {
+      uint32_t rtt = xtimer_now_usec() - acked->last_send_time;
+      bp_metrics_record(BP_METRICS_HIST_ACK_RTT, rtt);
+      /* smoothed like the TCP round trip time, with a gain of 1/8 */
+      neighbor->srtt = (neighbor->srtt == 0) ? rtt : neighbor->srtt - neighbor->srtt / 8 + rtt / 8;
+      acked->last_send_time = 0;
+    }
+    /* Taken over by a neighbor, only handed to new neighbors from here on */
+    acked->retx_count = RETX_DONE;
+    acked->retx_deadline = 0;
+
+    get_router()->received_ack(neighbor, creation_timestamp0, acked->primary_block.creation_timestamp[1], src_num);
+  }
+}
+
 /* Not used for now but an provides option to send acks in form of bundles.
  * Note: Takes more space than non bundle acks
  */
@@ -641,55 +904,91 @@ void send_ack(struct actual_bundle *bundle) {
   int lifetime = 1;
   struct actual_bundle *ack_bundle;
   uint64_t payload_flag;
-  uint8_t *payload_data;
-  size_t data_len, dst_len, report_len, service_len;
-  dst_len = calculate_size_of_num(bundle->primary_block.src_num);
-  report_len = calculate_size_of_num(bundle->primary_block.report_num);
-  service_len = calculate_size_of_num(bundle->primary_block.service_num);
-
-  char buf_dst[dst_len], buf_report[report_len], buf_service[service_len];
-
-  data_len = 4;
-  payload_data = (uint8_t*)malloc(data_len);
-  payload_data = (uint8_t*)"ack";
+  static uint8_t payload_data[] = "ack";
+  size_t data_len = sizeof(payload_data);
+  /* Digits of the largest uint32_t and the terminating null */
+  char buf_dst[11], buf_report[11], buf_service[11];
 
   if (calculate_canonical_flag(&payload_flag, false) < 0) {
     DEBUG("convergence_layer: Error creating payload flag.\n");
     return;
   }
-  sprintf(buf_dst, "%lu", bundle->primary_block.src_num);
-  sprintf(buf_report, "%lu", bundle->primary_block.report_num);
-  sprintf(buf_service, "%lu", bundle->primary_block.service_num);
+  buf_dst[fmt_u32_dec(buf_dst, bundle->primary_block.src_num)] = '\0';
+  buf_report[fmt_u32_dec(buf_report, bundle->primary_block.report_num)] = '\0';
+  buf_service[fmt_u32_dec(buf_service, bundle->primary_block.service_num)] = '\0';
   ack_bundle = create_bundle();
+  if (ack_bundle == NULL) {
+    DEBUG("convergence_layer: Could not create ack bundle.\n");
+    return;
+  }
   fill_bundle(ack_bundle, 7, IPN, buf_dst, buf_report, lifetime, bundle->primary_block.crc_type, buf_service);
   bundle_add_block(ack_bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, payload_flag, payload_data, NOCRC, data_len);
 
-  if(!gnrc_bp_dispatch(GNRC_NETTYPE_BP, GNRC_NETREG_DEMUX_CTX_ALL, ack_bundle, GNRC_NETAPI_MSG_TYPE_SND)) {
+  /* Owned by the BP thread once queued, stored like any other sent bundle until it expires */
+  set_retention_constraint(ack_bundle, DISPATCH_PENDING_RETENTION_CONSTRAINT);
+  if (gnrc_bp_dispatch(GNRC_NETTYPE_BP, GNRC_NETREG_DEMUX_CTX_ALL, ack_bundle, GNRC_NETAPI_MSG_TYPE_SND) < 1) {
     DEBUG("convergence_layer: Unable to find BP thread.\n");
+    set_retention_constraint(ack_bundle, NO_RETENTION_CONSTRAINT);
+    delete_bundle(ack_bundle);
+  }
+}
+
+/* Time since creation in ms, from the bundle age block and the time held at this node */
+static uint32_t _bundle_age(struct actual_bundle *bundle)
+{
+  uint32_t age;
+
+  bundle_get_age(bundle, &age);
+  return age;
+}
+
+/* Hands the payload to the application, that of fragments once all fragments were received */
+static void _deliver_payload(struct actual_bundle *bundle, struct registration_status *application)
+{
+  bp_metrics_record(BP_METRICS_HIST_LATENCY, _bundle_age(bundle));
+  if (application->sink != NULL) {
+    if (!bundle_is_fragment(bundle)) {
+      struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(bundle);
+      struct bundle_id id;
+      bundle_get_id(bundle, &id);
+      application->sink(application->sink_arg, &id, 0, payload_block->block_data, payload_block->data_len, true);
+    }
+    else {
+      bundle_reassembly_stream(bundle, application->sink, application->sink_arg);
+    }
+    update_statistics(BUNDLE_DELIVERY);
+    return ;
+  }
+  gnrc_pktsnip_t *payload;
+  if (!bundle_is_fragment(bundle)) {
+    /* the block data is freed with the bundle, the application gets a copy */
+    struct bundle_canonical_block_t *payload_block = bundle_get_payload_block(bundle);
+    payload = gnrc_pktbuf_add(NULL, payload_block->block_data, payload_block->data_len, GNRC_NETTYPE_UNDEF);
+    if (payload == NULL) {
+      DEBUG("convergence_layer: No room in packet buffer for payload, dropping it.\n");
+      return ;
+    }
+    deliver_bundle(payload, application);
     return ;
   }
-  delete_bundle(ack_bundle);  
+  if (bundle_reassembly_add(bundle, &payload) == OK) {
+    DEBUG("convergence_layer: Reassembled payload of %u bytes.\n", (unsigned)payload->size);
+    /* released by the application, and by the reassembly once the next payload completes */
+    gnrc_pktbuf_hold(payload, 1);
+    deliver_bundle(payload, application);
+  }
 }
 
 int deliver_bundles_to_application(struct registration_status *application)
 {
-  struct bundle_list *list, *temp;
+  struct bundle_list *list, *temp, *next;
   list = get_bundle_list();
-  LL_FOREACH(list, temp) {
-    if (list->current_bundle.primary_block.dst_num == strtoul(get_src_num(), NULL, 10) && list->current_bundle.primary_block.service_num == application->service_num) {
-      deliver_bundle((void *)(bundle_get_payload_block(&list->current_bundle)->block_data), application);
+  LL_FOREACH_SAFE(list, temp, next) {
+    if (temp->current_bundle.primary_block.dst_num == strtoul(get_src_num(), NULL, 10) && temp->current_bundle.primary_block.service_num == application->service_num) {
+      _deliver_payload(&temp->current_bundle, application);
       set_retention_constraint(&temp->current_bundle, NO_RETENTION_CONSTRAINT);
       delete_bundle(&temp->current_bundle);
     }
   }
   return OK;
 }
-
-static int calculate_size_of_num(uint32_t num) {
-  if(num == 0) {
-    return 0;
-  }
-  int a = ((ceil(log10(num))+1)*sizeof(char)); 
-  return a;
-}
-
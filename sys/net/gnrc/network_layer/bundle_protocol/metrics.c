@@ -0,0 +1,173 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Counters and histograms of the bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "xtimer.h"
+#include "nanocbor/nanocbor.h"
+
+#include "net/gnrc/bundle_protocol/metrics.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+struct bp_metrics_hist {
+  atomic_uint_least32_t count;
+  atomic_uint_least32_t max;
+  atomic_uint_least32_t buckets[BP_METRICS_BUCKETS];
+};
+
+static atomic_uint_least32_t counters[BP_METRICS_COUNTERS];
+static struct bp_metrics_hist hists[BP_METRICS_HISTS];
+
+static const char *counter_names[BP_METRICS_COUNTERS] = {
+  "bundles delivered", "bundles received", "bundles sent", "bundles forwarded",
+  "bundles retransmitted", "ack frames sent", "ack frames received", "discovery received", "discovery sent",
+  "summaries sent", "summaries received", "bundles refused",
+};
+
+static const char *hist_names[BP_METRICS_HISTS] = {
+  "latency ms", "residency ms", "ack rtt us", "store depth", "queue depth",
+};
+
+static unsigned bucket_of(uint32_t value)
+{
+  unsigned bucket = (value == 0) ? 0 : 32 - __builtin_clz(value);
+  return (bucket < BP_METRICS_BUCKETS) ? bucket : BP_METRICS_BUCKETS - 1;
+}
+
+void bp_metrics_count(unsigned counter)
+{
+  if (counter < BP_METRICS_COUNTERS) {
+    atomic_fetch_add_explicit(&counters[counter], 1, memory_order_relaxed);
+  }
+}
+
+uint32_t bp_metrics_get_count(unsigned counter)
+{
+  if (counter >= BP_METRICS_COUNTERS) {
+    return 0;
+  }
+  return atomic_load_explicit(&counters[counter], memory_order_relaxed);
+}
+
+void bp_metrics_record(unsigned hist, uint32_t value)
+{
+  if (hist >= BP_METRICS_HISTS) {
+    return ;
+  }
+  struct bp_metrics_hist *h = &hists[hist];
+  uint_least32_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+
+  atomic_fetch_add_explicit(&h->buckets[bucket_of(value)], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+  while (value > max && !atomic_compare_exchange_weak_explicit(&h->max, &max, value,
+                                                               memory_order_relaxed,
+                                                               memory_order_relaxed)) {}
+}
+
+uint32_t bp_metrics_hist_count(unsigned hist)
+{
+  return (hist < BP_METRICS_HISTS) ? atomic_load_explicit(&hists[hist].count, memory_order_relaxed) : 0;
+}
+
+uint32_t bp_metrics_hist_max(unsigned hist)
+{
+  return (hist < BP_METRICS_HISTS) ? atomic_load_explicit(&hists[hist].max, memory_order_relaxed) : 0;
+}
+
+uint32_t bp_metrics_percentile(unsigned hist, unsigned percent)
+{
+  uint32_t count = bp_metrics_hist_count(hist), max = bp_metrics_hist_max(hist), seen = 0;
+
+  if (count == 0) {
+    return 0;
+  }
+  /* rank of the percentile, rounded up */
+  uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+  for (unsigned i = 0; i < BP_METRICS_BUCKETS - 1; i++) {
+    seen += atomic_load_explicit(&hists[hist].buckets[i], memory_order_relaxed);
+    if (seen >= rank) {
+      uint32_t upper = (i == 0) ? 0 : (uint32_t)((1ULL << i) - 1);
+      return (upper < max) ? upper : max;
+    }
+  }
+  return max;
+}
+
+void bp_metrics_reset(void)
+{
+  for (unsigned i = 0; i < BP_METRICS_COUNTERS; i++) {
+    atomic_store_explicit(&counters[i], 0, memory_order_relaxed);
+  }
+  for (unsigned i = 0; i < BP_METRICS_HISTS; i++) {
+    atomic_store_explicit(&hists[i].count, 0, memory_order_relaxed);
+    atomic_store_explicit(&hists[i].max, 0, memory_order_relaxed);
+    for (unsigned j = 0; j < BP_METRICS_BUCKETS; j++) {
+      atomic_store_explicit(&hists[i].buckets[j], 0, memory_order_relaxed);
+    }
+  }
+}
+
+void bp_metrics_print(void)
+{
+  for (unsigned i = 0; i < BP_METRICS_COUNTERS; i++) {
+    printf("%-22s %" PRIu32 "\n", counter_names[i], bp_metrics_get_count(i));
+  }
+  printf("%-22s %10s %10s %10s %10s %10s\n", "", "count", "p50", "p90", "p99", "max");
+  for (unsigned i = 0; i < BP_METRICS_HISTS; i++) {
+    printf("%-22s %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 "\n",
+           hist_names[i], bp_metrics_hist_count(i), bp_metrics_percentile(i, 50),
+           bp_metrics_percentile(i, 90), bp_metrics_percentile(i, 99), bp_metrics_hist_max(i));
+  }
+}
+
+int bp_metrics_snapshot(uint8_t *buf, size_t len)
+{
+  nanocbor_encoder_t enc;
+
+  nanocbor_encoder_init(&enc, buf, len);
+  nanocbor_fmt_map(&enc, 3);
+  nanocbor_fmt_uint(&enc, BP_METRICS_KEY_TIME);
+  nanocbor_fmt_uint(&enc, xtimer_now_usec64() / US_PER_MS);
+
+  nanocbor_fmt_uint(&enc, BP_METRICS_KEY_COUNTERS);
+  nanocbor_fmt_array(&enc, BP_METRICS_COUNTERS);
+  for (unsigned i = 0; i < BP_METRICS_COUNTERS; i++) {
+    nanocbor_fmt_uint(&enc, bp_metrics_get_count(i));
+  }
+
+  nanocbor_fmt_uint(&enc, BP_METRICS_KEY_HISTS);
+  nanocbor_fmt_array(&enc, BP_METRICS_HISTS);
+  for (unsigned i = 0; i < BP_METRICS_HISTS; i++) {
+    uint32_t buckets[BP_METRICS_BUCKETS];
+    unsigned used = 0;
+
+    for (unsigned j = 0; j < BP_METRICS_BUCKETS; j++) {
+      buckets[j] = atomic_load_explicit(&hists[i].buckets[j], memory_order_relaxed);
+      used = (buckets[j] != 0) ? j + 1 : used;
+    }
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, bp_metrics_hist_count(i));
+    nanocbor_fmt_uint(&enc, bp_metrics_hist_max(i));
+    nanocbor_fmt_array(&enc, used);
+    for (unsigned j = 0; j < used; j++) {
+      nanocbor_fmt_uint(&enc, buckets[j]);
+    }
+  }
+
+  if (buf != NULL && nanocbor_encoded_len(&enc) > len) {
+    DEBUG("bp_metrics: Snapshot of %u bytes does not fit.\n", (unsigned)nanocbor_encoded_len(&enc));
+    return -1;
+  }
+  return nanocbor_encoded_len(&enc);
+}
@@ -1,5 +1,87 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Delivery bookkeeping shared by the routers of bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <inttypes.h>
 #include <stdlib.h>
 
+#include "utlist.h"
+
 #include "net/gnrc/bundle_protocol/routing.h"
 
-struct router* this_router = NULL; 
\ No newline at end of file
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+struct router* this_router = NULL;
+
+static struct delivered_bundle_list *head_ptr = NULL;
+
+void routing_notify_bundle_deletion(struct actual_bundle *bundle) {
+	struct delivered_bundle_list *temp, *next;
+	LL_FOREACH_SAFE(head_ptr, temp, next) {
+		if (is_same_bundle(bundle, temp->bundle)) {
+			LL_DELETE(head_ptr, temp);
+			free(temp);
+		}
+	}
+	DEBUG("routing: updated delivered ack list.\n");
+	print_delivered_bundle_list();
+	return ;
+}
+
+void routing_notify_neighbor_deletion(struct neighbor_t *neighbor) {
+	struct delivered_bundle_list *temp, *next;
+	LL_FOREACH_SAFE(head_ptr, temp, next) {
+		if (temp->neighbor == neighbor) {
+			LL_DELETE(head_ptr, temp);
+			free(temp);
+		}
+	}
+	DEBUG("routing: Dropped deliveries to neighbor %" PRIu32 ".\n", neighbor->endpoint_num);
+}
+
+void routing_received_ack(struct neighbor_t *src_neighbor, uint32_t creation_timestamp0, uint32_t creation_timestamp1, uint32_t src_num) {
+
+	DEBUG("routing: Inside processing received acknowledgement.\n");
+	struct actual_bundle *bundle = get_bundle_from_list(creation_timestamp0, creation_timestamp1, src_num);
+	if (bundle == NULL) {
+		DEBUG("routing: could not find bundle in storage corresponding to which ack received.\n");
+		return ;
+	}
+	if (src_neighbor->endpoint_num == bundle->primary_block.dst_num) {
+		DEBUG("routing: Received ack from final destination, deleting bundle .\n");
+		set_retention_constraint(bundle, NO_RETENTION_CONSTRAINT);
+		delete_bundle(bundle);
+		return ;
+	}
+	struct delivered_bundle_list *list_item = malloc(sizeof(struct delivered_bundle_list));
+	if (list_item == NULL) {
+		DEBUG("routing: could not allocate delivered list entry.\n");
+		return ;
+	}
+	list_item->bundle = bundle;
+	list_item->neighbor = src_neighbor;
+	LL_APPEND(head_ptr, list_item);
+	print_delivered_bundle_list();
+	return;
+}
+
+void print_delivered_bundle_list (void) {
+	struct delivered_bundle_list *temp;
+	DEBUG("routing: ");
+	LL_FOREACH(head_ptr, temp) {
+		DEBUG("(%" PRIu32 ", %" PRIu32 ")->", temp->bundle->local_creation_time, temp->neighbor->endpoint_num);
+	}
+	DEBUG("NULL.\n");
+}
+
+struct delivered_bundle_list *routing_get_delivered_bundle_list(void) {
+	return head_ptr;
+}
@@ -0,0 +1,330 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Contact graph routing for bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "mutex.h"
+#include "utlist.h"
+#include "xtimer.h"
+#include "nanocbor/nanocbor.h"
+#ifdef MODULE_VFS
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "vfs.h"
+#endif
+
+#include "net/gnrc/bundle_protocol/agent.h"
+#include "net/gnrc/bundle_protocol/contact_manager.h"
+#include "net/gnrc/bundle_protocol/routing_cgr.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+#define NO_CONTACT UINT16_MAX
+#define NEVER UINT32_MAX
+
+/* Route to a destination, unused while plan_version differs from that of the plan */
+struct cgr_route {
+	uint32_t dst_num;
+	/* INVALID_EID if the plan has no route */
+	uint32_t next_hop;
+	uint32_t arrival;
+	/* Plan time the first of the contacts of the route ends at */
+	uint32_t valid_until;
+	uint32_t last_used;
+	uint16_t plan_version;
+};
+
+static struct router cgr_router;
+/* Sorted by sending node, so the contacts of a node are adjacent */
+static struct cgr_contact plan[CGR_MAX_CONTACTS];
+static size_t plan_len;
+/* Starts at 1, cache entries of version 0 are never valid */
+static uint16_t plan_version = 1;
+/* Plan time at plan_loaded seconds of uptime */
+static uint32_t plan_offset, plan_loaded;
+static struct cgr_route routes[CGR_ROUTE_CACHE_SIZE];
+static uint32_t route_uses;
+
+/* Dijkstra state per contact, the earliest arrival at its receiving node and the contact before */
+static uint32_t arrival[CGR_MAX_CONTACTS];
+static uint16_t previous[CGR_MAX_CONTACTS];
+static bool done[CGR_MAX_CONTACTS];
+
+/* Bundles are routed by the BP thread and the contact manager, plans may be loaded by any thread */
+static mutex_t lock = MUTEX_INIT;
+
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max);
+
+void routing_cgr_init(void) {
+	DEBUG("routing_cgr: Initializing contact graph routing.\n");
+	cgr_router.route_receivers = _route_receivers;
+	cgr_router.received_ack = routing_received_ack;
+	cgr_router.notify_bundle_deletion = routing_notify_bundle_deletion;
+	cgr_router.get_delivered_bundle_list = routing_get_delivered_bundle_list;
+	this_router = &cgr_router;
+#if defined(MODULE_VFS) && defined(CGR_CONTACT_PLAN_FILE)
+	if (routing_cgr_load_file(CGR_CONTACT_PLAN_FILE) < 0) {
+		DEBUG("routing_cgr: Could not load contact plan %s.\n", CGR_CONTACT_PLAN_FILE);
+	}
+#endif
+}
+
+static uint32_t _uptime(void) {
+	return xtimer_now_usec64() / US_PER_SEC;
+}
+
+static uint32_t _now(void) {
+	return plan_offset + (_uptime() - plan_loaded);
+}
+
+static int _compare_contacts(const void *a, const void *b) {
+	const struct cgr_contact *ca = a, *cb = b;
+	if (ca->from != cb->from) {
+		return (ca->from < cb->from) ? -1 : 1;
+	}
+	return (ca->start < cb->start) ? -1 : (ca->start > cb->start);
+}
+
+/* Index of the first contact sent by node, plan_len if there is none */
+static size_t _first_contact(uint32_t node) {
+	size_t low = 0, high = plan_len;
+	while (low < high) {
+		size_t mid = (low + high) / 2;
+		if (plan[mid].from < node) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/* Starts plan, called with the lock held after plan_len contacts were written to plan */
+static void _plan_changed(uint32_t now) {
+	qsort(plan, plan_len, sizeof(plan[0]), _compare_contacts);
+	plan_offset = now;
+	plan_loaded = _uptime();
+	/* version 0 marks unused cache entries */
+	plan_version = (plan_version == UINT16_MAX) ? 1 : plan_version + 1;
+	DEBUG("routing_cgr: Loaded contact plan %u with %u contacts.\n", plan_version, (unsigned)plan_len);
+}
+
+int routing_cgr_set_plan(const struct cgr_contact *contacts, size_t num, uint32_t now) {
+	if (num > CGR_MAX_CONTACTS) {
+		DEBUG("routing_cgr: Plan of %u contacts does not fit.\n", (unsigned)num);
+		return ERROR;
+	}
+	mutex_lock(&lock);
+	memcpy(plan, contacts, num * sizeof(plan[0]));
+	plan_len = num;
+	_plan_changed(now);
+	mutex_unlock(&lock);
+	return OK;
+}
+
+/* Decodes the contacts of a plan into contacts if not NULL, returns their number or ERROR */
+static int _decode_plan(const uint8_t *buf, size_t len, uint32_t *now, struct cgr_contact *contacts) {
+	nanocbor_value_t decoder, arr, contact;
+	int num = 0;
+
+	nanocbor_decoder_init(&decoder, buf, len);
+	if (nanocbor_enter_array(&decoder, &arr) < 0 || nanocbor_get_uint32(&arr, now) < 0) {
+		return ERROR;
+	}
+	while (!nanocbor_at_end(&arr)) {
+		struct cgr_contact c;
+		if (num == CGR_MAX_CONTACTS) {
+			DEBUG("routing_cgr: Plan has more than %u contacts.\n", CGR_MAX_CONTACTS);
+			return ERROR;
+		}
+		if (nanocbor_enter_array(&arr, &contact) < 0 || nanocbor_get_uint32(&contact, &c.from) < 0 ||
+		    nanocbor_get_uint32(&contact, &c.to) < 0 || nanocbor_get_uint32(&contact, &c.start) < 0 ||
+		    nanocbor_get_uint32(&contact, &c.end) < 0 || nanocbor_get_uint32(&contact, &c.owlt) < 0 ||
+		    c.end <= c.start) {
+			DEBUG("routing_cgr: Malformed contact %d.\n", num);
+			return ERROR;
+		}
+		nanocbor_leave_container(&arr, &contact);
+		if (contacts != NULL) {
+			contacts[num] = c;
+		}
+		num++;
+	}
+	return num;
+}
+
+int routing_cgr_load(const uint8_t *buf, size_t len) {
+	uint32_t now;
+
+	/* validated first so a malformed plan leaves the current one in place */
+	if (_decode_plan(buf, len, &now, NULL) < 0) {
+		return ERROR;
+	}
+	mutex_lock(&lock);
+	plan_len = _decode_plan(buf, len, &now, plan);
+	_plan_changed(now);
+	mutex_unlock(&lock);
+	return OK;
+}
+
+#ifdef MODULE_VFS
+int routing_cgr_load_file(const char *path) {
+	struct stat st;
+	int res = ERROR;
+	int fd = vfs_open(path, O_RDONLY, 0);
+
+	if (fd < 0) {
+		return ERROR;
+	}
+	if (vfs_fstat(fd, &st) == 0 && st.st_size > 0) {
+		uint8_t *buf = malloc(st.st_size);
+		if (buf != NULL) {
+			if (vfs_read(fd, buf, st.st_size) == st.st_size) {
+				res = routing_cgr_load(buf, st.st_size);
+			}
+			free(buf);
+		}
+	}
+	vfs_close(fd);
+	return res;
+}
+#endif
+
+/* Offers the contacts sent by node after it was reached at time t over contact via */
+static void _relax(uint32_t node, uint32_t t, uint16_t via, uint32_t self) {
+	for (size_t i = _first_contact(node); i < plan_len && plan[i].from == node; i++) {
+		if (done[i] || plan[i].end <= t || plan[i].to == self) {
+			continue;
+		}
+		uint32_t a = ((plan[i].start > t) ? plan[i].start : t) + plan[i].owlt;
+		if (a < arrival[i]) {
+			arrival[i] = a;
+			previous[i] = via;
+		}
+	}
+}
+
+/* Earliest arrival route from this node to dst_num at time now, over contacts as graph vertices */
+static void _compute_route(struct cgr_route *route, uint32_t dst_num, uint32_t now) {
+	uint32_t self = strtoul(get_src_num(), NULL, 10);
+	uint16_t last = NO_CONTACT;
+
+	for (size_t i = 0; i < plan_len; i++) {
+		arrival[i] = NEVER;
+		previous[i] = NO_CONTACT;
+		done[i] = false;
+	}
+	_relax(self, now, NO_CONTACT, self);
+	while (true) {
+		uint16_t next = NO_CONTACT;
+		for (size_t i = 0; i < plan_len; i++) {
+			if (!done[i] && arrival[i] != NEVER && (next == NO_CONTACT || arrival[i] < arrival[next])) {
+				next = i;
+			}
+		}
+		if (next == NO_CONTACT) {
+			break;
+		}
+		done[next] = true;
+		/* contacts are settled in order of arrival, so the first one reaching dst_num is best */
+		if (plan[next].to == dst_num) {
+			last = next;
+			break;
+		}
+		_relax(plan[next].to, arrival[next], next, self);
+	}
+
+	route->dst_num = dst_num;
+	route->plan_version = plan_version;
+	if (last == NO_CONTACT) {
+		/* contacts only end until the plan changes */
+		route->next_hop = INVALID_EID;
+		route->arrival = NEVER;
+		route->valid_until = NEVER;
+		return ;
+	}
+	route->arrival = arrival[last];
+	route->valid_until = NEVER;
+	while (true) {
+		route->valid_until = (plan[last].end < route->valid_until) ? plan[last].end : route->valid_until;
+		if (previous[last] == NO_CONTACT) {
+			break;
+		}
+		last = previous[last];
+	}
+	route->next_hop = plan[last].to;
+}
+
+/* Cached route to dst_num, recomputed if stale, called with the lock held */
+static struct cgr_route *_route(uint32_t dst_num) {
+	struct cgr_route *route = NULL, *oldest = &routes[0];
+	uint32_t now = _now();
+
+	for (unsigned i = 0; i < CGR_ROUTE_CACHE_SIZE; i++) {
+		if (routes[i].plan_version == plan_version && routes[i].dst_num == dst_num) {
+			route = &routes[i];
+			break;
+		}
+		if (routes[i].plan_version != plan_version ||
+		    (oldest->plan_version == plan_version && routes[i].last_used < oldest->last_used)) {
+			oldest = &routes[i];
+		}
+	}
+	if (route == NULL || now >= route->valid_until) {
+		route = (route != NULL) ? route : oldest;
+		_compute_route(route, dst_num, now);
+		DEBUG("routing_cgr: Route to %" PRIu32 " over %" PRIu32 " arrives at %" PRIu32 ".\n", dst_num, route->next_hop, route->arrival);
+	}
+	route->last_used = ++route_uses;
+	return route;
+}
+
+uint32_t routing_cgr_next_hop(uint32_t endpoint_num) {
+	mutex_lock(&lock);
+	uint32_t next_hop = _route(endpoint_num)->next_hop;
+	mutex_unlock(&lock);
+	return next_hop;
+}
+
+/* Hands a bundle to its destination if in contact, otherwise to the first hop of its route */
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max) {
+	struct neighbor_t *temp;
+	uint32_t next_hop = bundle->primary_block.dst_num;
+
+	LL_SEARCH_SCALAR(get_neighbor_list(), temp, endpoint_num, next_hop);
+	if (temp == NULL) {
+		next_hop = routing_cgr_next_hop(bundle->primary_block.dst_num);
+		LL_SEARCH_SCALAR(get_neighbor_list(), temp, endpoint_num, next_hop);
+	}
+	if (temp == NULL || max == 0) {
+		DEBUG("routing_cgr: Next hop %" PRIu32 " not in contact.\n", next_hop);
+		return 0;
+	}
+	receivers[0] = temp;
+	return 1;
+}
+
+void routing_cgr_print(void) {
+	mutex_lock(&lock);
+	printf("contact plan %u: %u contacts, now %lu\n", plan_version, (unsigned)plan_len, (unsigned long)_now());
+	for (unsigned i = 0; i < CGR_ROUTE_CACHE_SIZE; i++) {
+		if (routes[i].plan_version == plan_version && routes[i].next_hop != INVALID_EID) {
+			printf("%10lu via %10lu arrival %10lu\n", (unsigned long)routes[i].dst_num,
+			       (unsigned long)routes[i].next_hop, (unsigned long)routes[i].arrival);
+		}
+	}
+	mutex_unlock(&lock);
+}
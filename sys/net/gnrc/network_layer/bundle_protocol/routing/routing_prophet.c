@@ -0,0 +1,284 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       PRoPHET routing for bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mutex.h"
+#include "utlist.h"
+#include "xtimer.h"
+#include "nanocbor/nanocbor.h"
+
+#include "net/gnrc/bundle_protocol/agent.h"
+#include "net/gnrc/bundle_protocol/contact_manager.h"
+#include "net/gnrc/bundle_protocol/routing_prophet.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+/* Delivery predictability for a node, unused while p is 0 */
+struct prophet_entry {
+	uint32_t endpoint_num;
+	uint16_t p;
+};
+
+/* Predictabilities last received from a neighbor, unused while updated is 0 */
+struct prophet_vector {
+	uint32_t endpoint_num;
+	uint32_t updated;
+	uint8_t len;
+	struct prophet_entry entries[PROPHET_VECTOR_SIZE];
+};
+
+static struct router prophet_router;
+static struct prophet_entry table[PROPHET_TABLE_SIZE];
+/* Time of the last discovery bundle of every node in table, in seconds */
+static uint32_t last_encounter[PROPHET_TABLE_SIZE];
+static struct prophet_vector vectors[PROPHET_NEIGHBOR_VECTORS];
+static uint32_t last_aging;
+/* Discovery bundles are handled by the contact manager, bundles are routed by the BP thread */
+static mutex_t lock = MUTEX_INIT;
+
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max);
+static int _discovery_data(uint8_t *buf, size_t len);
+static void _received_discovery(struct neighbor_t *neighbor, const uint8_t *data, size_t len);
+
+void routing_prophet_init(void) {
+	DEBUG("routing_prophet: Initializing PRoPHET routing.\n");
+	prophet_router.route_receivers = _route_receivers;
+	prophet_router.received_ack = routing_received_ack;
+	prophet_router.notify_bundle_deletion = routing_notify_bundle_deletion;
+	prophet_router.get_delivered_bundle_list = routing_get_delivered_bundle_list;
+	prophet_router.discovery_data = _discovery_data;
+	prophet_router.received_discovery = _received_discovery;
+	last_aging = xtimer_now_usec64() / US_PER_SEC;
+	this_router = &prophet_router;
+}
+
+static uint32_t _now(void) {
+	return xtimer_now_usec64() / US_PER_SEC;
+}
+
+static uint16_t _mul(uint16_t a, uint16_t b) {
+	return ((uint32_t)a * b) / PROPHET_P_MAX;
+}
+
+/* Ages all predictabilities by gamma for every time unit passed since they were aged last */
+static void _age(uint32_t now) {
+	uint32_t units = (now - last_aging) / PROPHET_AGING_SECONDS;
+	uint16_t factor = PROPHET_P_MAX;
+
+	if (units == 0) {
+		return ;
+	}
+	last_aging += units * PROPHET_AGING_SECONDS;
+	while (units-- > 0 && factor > 0) {
+		factor = _mul(factor, PROPHET_GAMMA);
+	}
+	for (unsigned i = 0; i < PROPHET_TABLE_SIZE; i++) {
+		table[i].p = _mul(table[i].p, factor);
+	}
+}
+
+static struct prophet_entry *_find(uint32_t endpoint_num) {
+	for (unsigned i = 0; i < PROPHET_TABLE_SIZE; i++) {
+		if (table[i].p != 0 && table[i].endpoint_num == endpoint_num) {
+			return &table[i];
+		}
+	}
+	return NULL;
+}
+
+/* Raises the predictability for endpoint_num to p, replacing the lowest one if the table is full */
+static struct prophet_entry *_raise(uint32_t endpoint_num, uint16_t p) {
+	struct prophet_entry *entry = _find(endpoint_num);
+
+	if (entry == NULL) {
+		entry = &table[0];
+		for (unsigned i = 1; i < PROPHET_TABLE_SIZE && entry->p != 0; i++) {
+			entry = (table[i].p < entry->p) ? &table[i] : entry;
+		}
+		if (entry->p >= p) {
+			return NULL;
+		}
+		entry->endpoint_num = endpoint_num;
+		entry->p = 0;
+		last_encounter[entry - table] = 0;
+	}
+	entry->p = (p > entry->p) ? p : entry->p;
+	return entry;
+}
+
+static struct prophet_vector *_get_vector(uint32_t endpoint_num) {
+	for (unsigned i = 0; i < PROPHET_NEIGHBOR_VECTORS; i++) {
+		if (vectors[i].updated != 0 && vectors[i].endpoint_num == endpoint_num) {
+			return &vectors[i];
+		}
+	}
+	return NULL;
+}
+
+static uint16_t _vector_p(struct prophet_vector *vector, uint32_t endpoint_num) {
+	for (unsigned i = 0; vector != NULL && i < vector->len; i++) {
+		if (vector->entries[i].endpoint_num == endpoint_num) {
+			return vector->entries[i].p;
+		}
+	}
+	return 0;
+}
+
+uint16_t routing_prophet_get_predictability(uint32_t endpoint_num) {
+	mutex_lock(&lock);
+	_age(_now());
+	struct prophet_entry *entry = _find(endpoint_num);
+	uint16_t p = (entry != NULL) ? entry->p : 0;
+	mutex_unlock(&lock);
+	return p;
+}
+
+/* Hands a bundle to its destination if in contact, otherwise to the neighbors more likely to meet it */
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max) {
+	struct neighbor_t *temp;
+	uint32_t dst_num = bundle->primary_block.dst_num;
+	int num = 0;
+
+	LL_SEARCH_SCALAR(get_neighbor_list(), temp, endpoint_num, dst_num);
+	if (temp != NULL) {
+		if (max > 0) {
+			receivers[num++] = temp;
+		}
+		return num;
+	}
+
+	mutex_lock(&lock);
+	_age(_now());
+	struct prophet_entry *own = _find(dst_num);
+	uint16_t own_p = (own != NULL) ? own->p : 0;
+	LL_FOREACH(get_neighbor_list(), temp) {
+		if (num == max) {
+			break;
+		}
+		if (_vector_p(_get_vector(temp->endpoint_num), dst_num) > own_p) {
+			receivers[num++] = temp;
+		}
+	}
+	mutex_unlock(&lock);
+	DEBUG("routing_prophet: %d neighbors more likely to deliver to %" PRIu32 ".\n", num, dst_num);
+	return num;
+}
+
+/* Encodes the highest predictabilities of this node that fit into len bytes */
+static int _discovery_data(uint8_t *buf, size_t len) {
+	struct prophet_entry *highest[PROPHET_VECTOR_SIZE];
+	/* array header and the largest endpoint number and predictability */
+	size_t max = (len > 1) ? (len - 1) / 8 : 0;
+	unsigned num = 0;
+	nanocbor_encoder_t enc;
+
+	max = (max < PROPHET_VECTOR_SIZE) ? max : PROPHET_VECTOR_SIZE;
+	mutex_lock(&lock);
+	_age(_now());
+	for (unsigned i = 0; i < PROPHET_TABLE_SIZE; i++) {
+		if (table[i].p == 0) {
+			continue;
+		}
+		unsigned j = (num < max) ? num++ : num;
+		while (j > 0 && highest[j - 1]->p < table[i].p) {
+			if (j < max) {
+				highest[j] = highest[j - 1];
+			}
+			j--;
+		}
+		if (j < max) {
+			highest[j] = &table[i];
+		}
+	}
+	nanocbor_encoder_init(&enc, buf, len);
+	nanocbor_fmt_array(&enc, 2 * num);
+	for (unsigned i = 0; i < num; i++) {
+		nanocbor_fmt_uint(&enc, highest[i]->endpoint_num);
+		nanocbor_fmt_uint(&enc, highest[i]->p);
+	}
+	mutex_unlock(&lock);
+	return (num > 0) ? (int)nanocbor_encoded_len(&enc) : 0;
+}
+
+static void _received_discovery(struct neighbor_t *neighbor, const uint8_t *data, size_t len) {
+	uint32_t now = _now(), self = strtoul(get_src_num(), NULL, 10);
+	nanocbor_value_t decoder, arr;
+
+	mutex_lock(&lock);
+	_age(now);
+
+	/* An encounter unless the neighbor was in contact all along */
+	struct prophet_entry *entry = _find(neighbor->endpoint_num);
+	if (entry == NULL || now - last_encounter[entry - table] > NEIGHBOR_PURGE_TIMER_SECONDS) {
+		uint16_t p = (entry != NULL) ? entry->p : 0;
+		entry = _raise(neighbor->endpoint_num, p + _mul(PROPHET_P_MAX - p, PROPHET_P_ENCOUNTER));
+	}
+	if (entry == NULL) {
+		mutex_unlock(&lock);
+		return ;
+	}
+	last_encounter[entry - table] = now;
+	uint16_t p_neighbor = entry->p;
+
+	if (data == NULL) {
+		mutex_unlock(&lock);
+		return ;
+	}
+	/* replacing the vector received longest ago */
+	struct prophet_vector *vector = _get_vector(neighbor->endpoint_num);
+	if (vector == NULL) {
+		vector = &vectors[0];
+		for (unsigned i = 1; i < PROPHET_NEIGHBOR_VECTORS; i++) {
+			vector = (vectors[i].updated < vector->updated) ? &vectors[i] : vector;
+		}
+	}
+	vector->endpoint_num = neighbor->endpoint_num;
+	vector->updated = (now != 0) ? now : 1;
+	vector->len = 0;
+
+	nanocbor_decoder_init(&decoder, data, len);
+	if (nanocbor_enter_array(&decoder, &arr) < 0) {
+		DEBUG("routing_prophet: Malformed predictabilities from %" PRIu32 ".\n", neighbor->endpoint_num);
+		mutex_unlock(&lock);
+		return ;
+	}
+	while (!nanocbor_at_end(&arr) && vector->len < PROPHET_VECTOR_SIZE) {
+		uint32_t endpoint_num, p;
+		if (nanocbor_get_uint32(&arr, &endpoint_num) < 0 || nanocbor_get_uint32(&arr, &p) < 0 || p > PROPHET_P_MAX) {
+			DEBUG("routing_prophet: Malformed predictability from %" PRIu32 ".\n", neighbor->endpoint_num);
+			break;
+		}
+		vector->entries[vector->len].endpoint_num = endpoint_num;
+		vector->entries[vector->len].p = p;
+		vector->len++;
+
+		/* transitivity, this node reaches endpoint_num through the neighbor */
+		if (endpoint_num != self && endpoint_num != neighbor->endpoint_num) {
+			_raise(endpoint_num, _mul(_mul(p_neighbor, p), PROPHET_BETA));
+		}
+	}
+	mutex_unlock(&lock);
+}
+
+void routing_prophet_print(void) {
+	mutex_lock(&lock);
+	_age(_now());
+	for (unsigned i = 0; i < PROPHET_TABLE_SIZE; i++) {
+		if (table[i].p != 0) {
+			printf("%10lu %5u\n", (unsigned long)table[i].endpoint_num, table[i].p);
+		}
+	}
+	mutex_unlock(&lock);
+}
@@ -0,0 +1,227 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Binary spray and wait routing for bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "utlist.h"
+#include "nanocbor/nanocbor.h"
+
+#include "net/gnrc/bundle_protocol/agent.h"
+#include "net/gnrc/bundle_protocol/contact_manager.h"
+#include "net/gnrc/bundle_protocol/routing_spray_and_wait.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+/* Copies handed to a receiver of a bundle, bundle is NULL for a free entry */
+struct handoff {
+	struct actual_bundle *bundle;
+	uint32_t endpoint_num;
+	uint16_t copies;
+};
+
+static struct router spray_router;
+static struct handoff handoffs[SPRAY_AND_WAIT_HANDOFFS];
+static unsigned next_handoff;
+/* Split written by _prepare_send, only taken from the copies of the bundle by _sent */
+static struct actual_bundle *pending_bundle;
+static uint16_t pending_copies;
+
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max);
+static void _prepare_send(struct actual_bundle *bundle, struct neighbor_t **receivers, int num);
+static void _sent(struct actual_bundle *bundle, struct neighbor_t **receivers, int num);
+static void _notify_bundle_deletion(struct actual_bundle *bundle);
+
+void routing_spray_and_wait_init(void) {
+	DEBUG("routing_spray_and_wait: Initializing spray and wait routing.\n");
+	spray_router.route_receivers = _route_receivers;
+	spray_router.received_ack = routing_received_ack;
+	spray_router.notify_bundle_deletion = _notify_bundle_deletion;
+	spray_router.get_delivered_bundle_list = routing_get_delivered_bundle_list;
+	spray_router.prepare_send = _prepare_send;
+	spray_router.sent = _sent;
+	memset(handoffs, 0, sizeof(handoffs));
+	next_handoff = 0;
+	pending_bundle = NULL;
+	this_router = &spray_router;
+}
+
+uint16_t routing_spray_and_wait_copies(struct actual_bundle *bundle) {
+	if (bundle->copies != 0) {
+		return bundle->copies;
+	}
+	struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_COPY_COUNT);
+	uint32_t copies = 0;
+
+	if (block != NULL) {
+		nanocbor_value_t decoder;
+		nanocbor_decoder_init(&decoder, block->block_data, block->data_len);
+		if (nanocbor_get_uint32(&decoder, &copies) < 0) {
+			DEBUG("routing_spray_and_wait: Malformed copy count block.\n");
+			copies = 0;
+		}
+	}
+	else if (bundle->primary_block.src_num == strtoul(get_src_num(), NULL, 10)) {
+		copies = SPRAY_AND_WAIT_COPIES;
+	}
+	/* bundles routed by other routers to this node are only delivered directly */
+	bundle->copies = (copies == 0) ? 1 : ((copies > UINT16_MAX) ? UINT16_MAX : copies);
+	return bundle->copies;
+}
+
+static struct handoff *_find_handoff(struct actual_bundle *bundle, uint32_t endpoint_num) {
+	for (unsigned i = 0; i < SPRAY_AND_WAIT_HANDOFFS; i++) {
+		if (handoffs[i].bundle == bundle && handoffs[i].endpoint_num == endpoint_num) {
+			return &handoffs[i];
+		}
+	}
+	return NULL;
+}
+
+static void _notify_bundle_deletion(struct actual_bundle *bundle) {
+	for (unsigned i = 0; i < SPRAY_AND_WAIT_HANDOFFS; i++) {
+		if (handoffs[i].bundle == bundle) {
+			handoffs[i].bundle = NULL;
+		}
+	}
+	if (pending_bundle == bundle) {
+		pending_bundle = NULL;
+	}
+	routing_notify_bundle_deletion(bundle);
+}
+
+static bool _delivered(struct actual_bundle *bundle, struct neighbor_t *neighbor) {
+	struct delivered_bundle_list *temp;
+	LL_FOREACH(routing_get_delivered_bundle_list(), temp) {
+		if (is_same_bundle(bundle, temp->bundle) && is_same_neighbor(neighbor, temp->neighbor)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Hands a bundle to its destination if in contact, otherwise copies to neighbors that have none */
+static int _route_receivers(struct actual_bundle *bundle, struct neighbor_t **receivers, int max) {
+	struct neighbor_t *temp;
+	uint16_t copies;
+	int num = 0, handoffs_new = 0;
+
+	LL_SEARCH_SCALAR(get_neighbor_list(), temp, endpoint_num, bundle->primary_block.dst_num);
+	if (temp != NULL) {
+		if (max > 0) {
+			receivers[num++] = temp;
+		}
+		return num;
+	}
+
+	copies = routing_spray_and_wait_copies(bundle);
+	LL_FOREACH(get_neighbor_list(), temp) {
+		if (num == max) {
+			break;
+		}
+		if (temp->endpoint_num == bundle->previous_endpoint_num || _delivered(bundle, temp)) {
+			continue;
+		}
+		/* receivers handed copies before are retransmitted to without taking more */
+		if (_find_handoff(bundle, temp->endpoint_num) == NULL) {
+			/* every receiver gets at least one copy and this node keeps one */
+			if (handoffs_new + 1 >= copies) {
+				continue;
+			}
+			handoffs_new++;
+		}
+		receivers[num++] = temp;
+	}
+	DEBUG("routing_spray_and_wait: %d neighbors for a bundle with %u copies.\n", num, copies);
+	return num;
+}
+
+/* Writes the copies handed to each new receiver into the copy count block, _sent takes them off */
+static void _prepare_send(struct actual_bundle *bundle, struct neighbor_t **receivers, int num) {
+	uint16_t copies = routing_spray_and_wait_copies(bundle);
+	uint8_t data[CBOR_HEAD_MAX_LEN];
+	nanocbor_encoder_t enc;
+	uint16_t handed = UINT16_MAX;
+	int handoffs_new = 0;
+
+	pending_bundle = NULL;
+	for (int i = 0; i < num; i++) {
+		if (receivers[i]->endpoint_num == bundle->primary_block.dst_num) {
+			continue;
+		}
+		struct handoff *found = _find_handoff(bundle, receivers[i]->endpoint_num);
+		if (found == NULL) {
+			handoffs_new++;
+		}
+		else if (found->copies < handed) {
+			handed = found->copies;
+		}
+	}
+	/* the destination does not hand out copies */
+	if (handoffs_new == 0 && handed == UINT16_MAX) {
+		return ;
+	}
+	/*
+	 * Split evenly between this node and the new receivers, which halves them for a single one.
+	 * The block is the same for all receivers, so receivers retransmitted to are never sent more
+	 * copies than they were handed before.
+	 */
+	if (handoffs_new > 0 && copies / (handoffs_new + 1) < handed) {
+		handed = copies / (handoffs_new + 1);
+	}
+
+	nanocbor_encoder_init(&enc, data, sizeof(data));
+	nanocbor_fmt_uint(&enc, handed);
+	size_t len = nanocbor_encoded_len(&enc);
+
+	/* called while the convergence layer walks the bundle list, so no other bundle may be purged for the block */
+	struct bundle_canonical_block_t *block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_COPY_COUNT);
+	if (block == NULL) {
+		uint64_t flags;
+		/* added empty, which takes no chunk of the block pool */
+		if (calculate_canonical_flag(&flags, false) < 0 ||
+		    bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_COPY_COUNT, flags, NULL, bundle->primary_block.crc_type, 0) < 0) {
+			DEBUG("routing_spray_and_wait: Could not add copy count block, receivers only deliver directly.\n");
+			return ;
+		}
+		block = get_block_by_type(bundle, BUNDLE_BLOCK_TYPE_COPY_COUNT);
+	}
+	if (bundle_block_set_data_nopurge(bundle, block, data, len) < 0) {
+		/* an empty block hands no copies, receivers only deliver directly */
+		DEBUG("routing_spray_and_wait: Could not write copy count block.\n");
+		return ;
+	}
+	pending_bundle = bundle;
+	pending_copies = handed;
+	DEBUG("routing_spray_and_wait: Handing %u copies to each of %d new neighbors.\n", handed, handoffs_new);
+}
+
+/* Takes the copies off the bundle that were handed to new receivers it was sent to */
+static void _sent(struct actual_bundle *bundle, struct neighbor_t **receivers, int num) {
+	if (pending_bundle != bundle) {
+		return ;
+	}
+	pending_bundle = NULL;
+	for (int i = 0; i < num; i++) {
+		uint32_t endpoint_num = receivers[i]->endpoint_num;
+		if (endpoint_num == bundle->primary_block.dst_num || _find_handoff(bundle, endpoint_num) != NULL ||
+		    bundle->copies <= pending_copies) {
+			continue;
+		}
+		bundle->copies -= pending_copies;
+		handoffs[next_handoff].bundle = bundle;
+		handoffs[next_handoff].endpoint_num = endpoint_num;
+		handoffs[next_handoff].copies = pending_copies;
+		next_handoff = (next_handoff + 1) % SPRAY_AND_WAIT_HANDOFFS;
+	}
+	DEBUG("routing_spray_and_wait: Keeping %u copies.\n", bundle->copies);
+}
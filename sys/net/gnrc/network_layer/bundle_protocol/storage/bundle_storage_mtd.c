@@ -0,0 +1,549 @@
+/**
+ * @ingroup     Bundle protocol
+ * @{
+ *
+ * @file
+ * @brief       Log structured bundle storage backend on a raw MTD device
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+#include <stddef.h>
+#include <string.h>
+
+#include "checksum/crc32c.h"
+#include "mutex.h"
+#include "thread.h"
+#include "thread_flags.h"
+
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/bundle_storage_mtd.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+#define RECORD_COMMIT     (0x42505243UL)  /* "BPRC" */
+#define RECORD_APPEND     (1)
+#define RECORD_TOMBSTONE  (2)
+/* Marks a region as complete, written first into a new store and last by a compaction */
+#define RECORD_SEAL       (3)
+
+#define RECORD_SIZE(len)  ((sizeof(struct storage_record) + (len) + 3) & ~3UL)
+#define COPY_CHUNK_SIZE   (64)
+#define WORKER_FLAG       (1u << 0)
+
+/*
+ * Record header, followed by len bytes of data. It is programmed in order: the length word, the
+ * rest of the header and the data, the commit word last. Replay skips records without a valid
+ * length word or commit word, so appending simply continues after a record torn by a reset.
+ */
+struct storage_record {
+  uint16_t len;
+  uint16_t len_inv;
+  uint32_t commit;
+  uint8_t type;
+  uint8_t reserved[3];
+  /* previous endpoint of append records, sequence number of seal records */
+  uint32_t aux;
+  struct bundle_id id;
+  /* CRC32C from type up to here and over the data */
+  uint32_t crc;
+};
+
+struct storage_entry {
+  struct bundle_id id;
+  uint32_t addr;
+  uint32_t previous_endpoint_num;
+  uint16_t len;
+  uint8_t region;
+  bool used;
+};
+
+static int _store(struct actual_bundle *bundle, const uint8_t *data, size_t len);
+static void _remove(int slot);
+static int _restore(bundle_storage_restore_cb_t cb);
+
+static struct bundle_storage_backend mtd_backend = {
+  .store = _store,
+  .remove = _remove,
+  .restore = _restore,
+};
+
+static mtd_dev_t *mtd;
+static mutex_t lock = MUTEX_INIT;
+static kernel_pid_t worker_pid = KERNEL_PID_UNDEF;
+static char worker_stack[BUNDLE_STORAGE_MTD_STACK_SIZE];
+
+/* RAM index of the stored bundles */
+static struct storage_entry entries[MAX_BUNDLES];
+
+static uint32_t sector_size;
+static uint32_t region_size;
+/* Region holding the sealed log, replayed first */
+static uint8_t active_region;
+static uint32_t sequence;
+/* Appends go to the other region while compacting */
+static uint8_t append_region;
+static uint32_t append_off;
+static bool compacting;
+/* Erased sectors of the region not active, it can be compacted into once all are */
+static uint16_t spare_erased;
+
+static uint32_t region_addr(uint8_t region)
+{
+  return (BUNDLE_STORAGE_MTD_FIRST_SECTOR + region * BUNDLE_STORAGE_MTD_REGION_SECTORS) * sector_size;
+}
+
+static int program(uint32_t addr, const void *buf, uint32_t len)
+{
+  const uint8_t *pos = buf;
+  while (len > 0) {
+    uint32_t chunk = mtd->page_size - (addr % mtd->page_size);
+    if (chunk > len) {
+      chunk = len;
+    }
+    if (mtd_write(mtd, pos, addr, chunk) < 0) {
+      DEBUG("bundle_storage_mtd: Write of %lu bytes at 0x%lx failed.\n", (unsigned long)chunk, (unsigned long)addr);
+      return ERROR;
+    }
+    addr += chunk;
+    pos += chunk;
+    len -= chunk;
+  }
+  return OK;
+}
+
+static uint32_t header_crc(const struct storage_record *rec)
+{
+  return crc32c_calc(&rec->type, offsetof(struct storage_record, crc) - offsetof(struct storage_record, type));
+}
+
+static bool verify_record(uint32_t addr, const struct storage_record *rec)
+{
+  uint8_t buf[COPY_CHUNK_SIZE];
+  uint32_t crc = header_crc(rec);
+  for (uint32_t off = 0; off < rec->len; off += sizeof(buf)) {
+    uint32_t chunk = (rec->len - off < sizeof(buf)) ? rec->len - off : sizeof(buf);
+    if (mtd_read(mtd, buf, addr + sizeof(*rec) + off, chunk) < 0) {
+      return false;
+    }
+    crc = crc32c_update(crc, buf, chunk);
+  }
+  return crc == rec->crc;
+}
+
+/* Reserves a slot for one seal record at the end of every region */
+static bool fits(uint32_t size)
+{
+  return append_off + size + RECORD_SIZE(0) <= region_size;
+}
+
+/*
+ * Appends rec followed by its data, taken from data or, if that is NULL, copied from the record at
+ * src_addr. The space is used up even if programming fails.
+ */
+static int append(struct storage_record *rec, const uint8_t *data, uint32_t src_addr, uint32_t *addr)
+{
+  uint32_t base = region_addr(append_region) + append_off;
+  if (append_off + RECORD_SIZE(rec->len) > region_size) {
+    return ERROR;
+  }
+  append_off += RECORD_SIZE(rec->len);
+
+  rec->len_inv = ~rec->len;
+  rec->commit = RECORD_COMMIT;
+  if (program(base, rec, offsetof(struct storage_record, commit)) < 0 ||
+      program(base + offsetof(struct storage_record, type), &rec->type,
+              sizeof(*rec) - offsetof(struct storage_record, type)) < 0) {
+    return ERROR;
+  }
+  if (data != NULL) {
+    if (program(base + sizeof(*rec), data, rec->len) < 0) {
+      return ERROR;
+    }
+  }
+  else {
+    uint8_t buf[COPY_CHUNK_SIZE];
+    for (uint32_t off = 0; off < rec->len; off += sizeof(buf)) {
+      uint32_t chunk = (rec->len - off < sizeof(buf)) ? rec->len - off : sizeof(buf);
+      if (mtd_read(mtd, buf, src_addr + sizeof(*rec) + off, chunk) < 0 ||
+          program(base + sizeof(*rec) + off, buf, chunk) < 0) {
+        return ERROR;
+      }
+    }
+  }
+  if (program(base + offsetof(struct storage_record, commit), &rec->commit, sizeof(rec->commit)) < 0) {
+    return ERROR;
+  }
+  if (addr != NULL) {
+    *addr = base;
+  }
+  return OK;
+}
+
+static int append_seal(void)
+{
+  struct storage_record rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.type = RECORD_SEAL;
+  rec.aux = sequence;
+  rec.crc = header_crc(&rec);
+  return append(&rec, NULL, 0, NULL);
+}
+
+static int append_tombstone(const struct bundle_id *id)
+{
+  struct storage_record rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.type = RECORD_TOMBSTONE;
+  rec.id = *id;
+  rec.crc = header_crc(&rec);
+  return append(&rec, NULL, 0, NULL);
+}
+
+static struct storage_entry *find_entry(const struct bundle_id *id)
+{
+  for (int i = 0; i < MAX_BUNDLES; i++) {
+    if (entries[i].used && memcmp(&entries[i].id, id, sizeof(*id)) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+static struct storage_entry *free_entry(void)
+{
+  for (int i = 0; i < MAX_BUNDLES; i++) {
+    if (!entries[i].used) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+static void apply_record(uint8_t region, uint32_t addr, const struct storage_record *rec)
+{
+  struct storage_entry *entry = find_entry(&rec->id);
+  if (rec->type == RECORD_TOMBSTONE) {
+    if (entry != NULL) {
+      entry->used = false;
+    }
+  }
+  else if (rec->type == RECORD_APPEND) {
+    if (entry == NULL && (entry = free_entry()) == NULL) {
+      DEBUG("bundle_storage_mtd: More stored bundles than MAX_BUNDLES, dropping one.\n");
+      return;
+    }
+    entry->id = rec->id;
+    entry->addr = addr;
+    entry->previous_endpoint_num = rec->aux;
+    entry->len = rec->len;
+    entry->region = region;
+    entry->used = true;
+  }
+}
+
+/*
+ * Walks the log of region, applying its records to the index if apply is set. Returns the offset
+ * after the last record written, reports the sequence number of the latest seal found.
+ */
+static uint32_t scan_region(uint8_t region, bool apply, bool *sealed, uint32_t *seal_sequence)
+{
+  uint32_t off = 0, base = region_addr(region);
+  struct storage_record rec;
+
+  *sealed = false;
+  while (off + sizeof(rec) <= region_size) {
+    if (mtd_read(mtd, &rec, base + off, sizeof(rec)) < 0) {
+      return region_size;
+    }
+    if (rec.len == 0xFFFF && rec.len_inv == 0xFFFF) {
+      break;
+    }
+    if ((uint16_t)(rec.len ^ rec.len_inv) != 0xFFFF) {
+      /* torn length word, nothing after it was programmed */
+      off += 4;
+      continue;
+    }
+    if (off + RECORD_SIZE(rec.len) > region_size) {
+      return region_size;
+    }
+    if (rec.commit == RECORD_COMMIT && verify_record(base + off, &rec)) {
+      if (rec.type == RECORD_SEAL) {
+        *sealed = true;
+        *seal_sequence = rec.aux;
+      }
+      if (apply) {
+        apply_record(region, base + off, &rec);
+      }
+    }
+    off += RECORD_SIZE(rec.len);
+  }
+  return off;
+}
+
+static void start_compaction(void)
+{
+  DEBUG("bundle_storage_mtd: Compacting region %u into region %u.\n", active_region, !active_region);
+  compacting = true;
+  append_region = !active_region;
+  append_off = 0;
+}
+
+/*
+ * One step of the background work: erasing one sector of the spare region, copying one live
+ * record or sealing the compacted region. Returns false once there is nothing left to do.
+ */
+static bool work_step(void)
+{
+  if (spare_erased < BUNDLE_STORAGE_MTD_REGION_SECTORS) {
+    if (mtd_erase(mtd, region_addr(!active_region) + spare_erased * sector_size, sector_size) < 0) {
+      DEBUG("bundle_storage_mtd: Erasing sector %u failed.\n", spare_erased);
+    }
+    spare_erased++;
+    return true;
+  }
+  if (!compacting) {
+    return false;
+  }
+  for (int i = 0; i < MAX_BUNDLES; i++) {
+    if (!entries[i].used || entries[i].region != active_region) {
+      continue;
+    }
+    struct storage_record rec;
+    uint32_t addr;
+    if (mtd_read(mtd, &rec, entries[i].addr, sizeof(rec)) < 0 ||
+        append(&rec, NULL, entries[i].addr, &addr) < 0) {
+      DEBUG("bundle_storage_mtd: Could not move stored bundle, dropping it.\n");
+      entries[i].used = false;
+      return true;
+    }
+    entries[i].addr = addr;
+    entries[i].region = append_region;
+    return true;
+  }
+  sequence++;
+  append_seal();
+  active_region = append_region;
+  compacting = false;
+  /* the old region is erased by the next steps */
+  spare_erased = 0;
+  DEBUG("bundle_storage_mtd: Compaction done, %lu bytes in use.\n", (unsigned long)append_off);
+  return true;
+}
+
+static void wake_worker(void)
+{
+  if (worker_pid != KERNEL_PID_UNDEF) {
+    thread_flags_set((thread_t *)thread_get(worker_pid), WORKER_FLAG);
+  }
+}
+
+static void maybe_start_compaction(void)
+{
+  if (!compacting && spare_erased == BUNDLE_STORAGE_MTD_REGION_SECTORS &&
+      append_off >= region_size / 100 * BUNDLE_STORAGE_MTD_COMPACT_PERCENT) {
+    start_compaction();
+    wake_worker();
+  }
+}
+
+/*
+ * Makes room for size bytes without waiting for the worker: finishes a running compaction and
+ * compacts once more if that is not enough.
+ */
+static int reserve(uint32_t size)
+{
+  for (int i = 0; i < 2 && !fits(size); i++) {
+    if (!compacting) {
+      while (spare_erased < BUNDLE_STORAGE_MTD_REGION_SECTORS) {
+        work_step();
+      }
+      start_compaction();
+    }
+    while (compacting) {
+      work_step();
+    }
+  }
+  /* the old region still has to be erased */
+  wake_worker();
+  return fits(size) ? OK : ERROR;
+}
+
+static void *worker(void *args)
+{
+  (void)args;
+  while (1) {
+    thread_flags_wait_any(WORKER_FLAG);
+    bool more = true;
+    while (more) {
+      mutex_lock(&lock);
+      more = work_step();
+      mutex_unlock(&lock);
+    }
+  }
+  return NULL;
+}
+
+static int _store(struct actual_bundle *bundle, const uint8_t *data, size_t len)
+{
+  struct storage_record rec;
+  struct storage_entry *entry;
+  int res = ERROR;
+
+  if (len > UINT16_MAX - 1) {
+    return ERROR;
+  }
+  memset(&rec, 0, sizeof(rec));
+  rec.type = RECORD_APPEND;
+  rec.len = len;
+  rec.aux = bundle->previous_endpoint_num;
+  bundle_get_id(bundle, &rec.id);
+  rec.crc = crc32c_update(header_crc(&rec), data, len);
+
+  mutex_lock(&lock);
+  if ((entry = free_entry()) == NULL || reserve(RECORD_SIZE(len)) < 0) {
+    DEBUG("bundle_storage_mtd: No space left for a bundle of %u bytes.\n", (unsigned)len);
+    goto out;
+  }
+  if (append(&rec, data, 0, &entry->addr) < 0) {
+    goto out;
+  }
+  entry->id = rec.id;
+  entry->previous_endpoint_num = rec.aux;
+  entry->len = len;
+  entry->region = append_region;
+  entry->used = true;
+  res = entry - entries;
+  maybe_start_compaction();
+out:
+  mutex_unlock(&lock);
+  return res;
+}
+
+static void _remove(int slot)
+{
+  mutex_lock(&lock);
+  struct storage_entry *entry = &entries[slot];
+  if (entry->used) {
+    entry->used = false;
+    /* if room could only be made by compacting without this bundle, no tombstone is needed */
+    if (reserve(RECORD_SIZE(0)) == OK) {
+      append_tombstone(&entry->id);
+    }
+    maybe_start_compaction();
+  }
+  mutex_unlock(&lock);
+}
+
+static int _restore(bundle_storage_restore_cb_t cb)
+{
+  int restored = 0;
+  for (int i = 0; i < MAX_BUNDLES; i++) {
+    mutex_lock(&lock);
+    if (!entries[i].used) {
+      mutex_unlock(&lock);
+      continue;
+    }
+    gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(NULL, NULL, entries[i].len, GNRC_NETTYPE_BP);
+    if (pkt == NULL) {
+      DEBUG("bundle_storage_mtd: No packet buffer space to restore bundle.\n");
+      mutex_unlock(&lock);
+      break;
+    }
+    int res = mtd_read(mtd, pkt->data, entries[i].addr + sizeof(struct storage_record), entries[i].len);
+    uint32_t previous_endpoint_num = entries[i].previous_endpoint_num;
+    mutex_unlock(&lock);
+
+    /* cb may delete other bundles and thereby call _remove */
+    if (res < 0 || cb(pkt, previous_endpoint_num, i) != OK) {
+      DEBUG("bundle_storage_mtd: Could not restore stored bundle, removing it.\n");
+      _remove(i);
+    }
+    else {
+      restored++;
+    }
+    gnrc_pktbuf_release(pkt);
+  }
+  return restored;
+}
+
+int bundle_storage_mtd_init(mtd_dev_t *dev)
+{
+  bool sealed[2];
+  uint32_t seal_sequence[2] = {0, 0}, end[2];
+
+  if (mtd_init(dev) < 0) {
+    DEBUG("bundle_storage_mtd: Could not initialize MTD device.\n");
+    return ERROR;
+  }
+  if (dev->sector_count < BUNDLE_STORAGE_MTD_FIRST_SECTOR + 2 * BUNDLE_STORAGE_MTD_REGION_SECTORS) {
+    DEBUG("bundle_storage_mtd: MTD device too small for two regions.\n");
+    return ERROR;
+  }
+
+  mutex_lock(&lock);
+  mtd = dev;
+  sector_size = dev->pages_per_sector * dev->page_size;
+  region_size = BUNDLE_STORAGE_MTD_REGION_SECTORS * sector_size;
+  memset(entries, 0, sizeof(entries));
+  compacting = false;
+
+  for (uint8_t i = 0; i < 2; i++) {
+    end[i] = scan_region(i, false, &sealed[i], &seal_sequence[i]);
+  }
+  if (!sealed[0] && !sealed[1]) {
+    DEBUG("bundle_storage_mtd: No stored bundles found, starting a new store.\n");
+    if (mtd_erase(mtd, region_addr(0), region_size) < 0) {
+      DEBUG("bundle_storage_mtd: Erasing region 0 failed.\n");
+    }
+    sequence = 0;
+    active_region = append_region = 0;
+    append_off = 0;
+    append_seal();
+    spare_erased = 0;
+  }
+  else {
+    if (sealed[0] && sealed[1]) {
+      active_region = (int32_t)(seal_sequence[1] - seal_sequence[0]) > 0;
+    }
+    else {
+      active_region = sealed[1];
+    }
+    uint8_t spare = !active_region;
+    sequence = seal_sequence[active_region];
+    scan_region(active_region, true, &sealed[active_region], &seal_sequence[active_region]);
+    if (!sealed[spare] && end[spare] > 0) {
+      /* interrupted compaction, its copies and later records go on top of the old log */
+      DEBUG("bundle_storage_mtd: Resuming interrupted compaction.\n");
+      scan_region(spare, true, &sealed[spare], &seal_sequence[spare]);
+      compacting = true;
+      append_region = spare;
+      append_off = end[spare];
+      spare_erased = BUNDLE_STORAGE_MTD_REGION_SECTORS;
+    }
+    else {
+      append_region = active_region;
+      append_off = end[active_region];
+      spare_erased = 0;
+    }
+  }
+  mutex_unlock(&lock);
+
+  if (worker_pid == KERNEL_PID_UNDEF) {
+    worker_pid = thread_create(worker_stack, sizeof(worker_stack), BUNDLE_STORAGE_MTD_PRIO,
+                               THREAD_CREATE_STACKTEST, worker, NULL, "bp_storage_mtd");
+  }
+  this_storage_backend = &mtd_backend;
+  wake_worker();
+  return OK;
+}
+
+void bundle_storage_mtd_sync(void)
+{
+  mutex_lock(&lock);
+  while (work_step()) {}
+  mutex_unlock(&lock);
+}
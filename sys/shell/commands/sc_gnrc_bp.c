@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ * @brief   Shell command for the bundle protocol metrics
+ *
+ * @author  Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "net/gnrc/bundle_protocol/bundle_block_pool.h"
+#include "net/gnrc/bundle_protocol/metrics.h"
+#ifdef MODULE_GNRC_CONTACT_MANAGER
+#include "net/gnrc/bundle_protocol/contact_manager.h"
+#endif
+#ifdef MODULE_ROUTING_PROPHET
+#include "net/gnrc/bundle_protocol/routing_prophet.h"
+#endif
+#ifdef MODULE_ROUTING_CGR
+#include "net/gnrc/bundle_protocol/routing_cgr.h"
+#endif
+
+/* large enough for the snapshot with all buckets in use */
+#define SNAPSHOT_SIZE   (32 + BP_METRICS_COUNTERS * 5 + \
+                         BP_METRICS_HISTS * (14 + BP_METRICS_BUCKETS * 5))
+
+static void _print_snapshot(void)
+{
+    static uint8_t buf[SNAPSHOT_SIZE];
+    int len = bp_metrics_snapshot(buf, sizeof(buf));
+
+    if (len < 0) {
+        puts("error: snapshot does not fit");
+        return;
+    }
+    for (int i = 0; i < len; i++) {
+        printf("%02x", buf[i]);
+    }
+    puts("");
+}
+
+int _gnrc_bp_metrics(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        bp_metrics_reset();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "cbor") == 0) {
+        _print_snapshot();
+        return 0;
+    }
+    if (argc > 1) {
+        printf("usage: %s [reset|cbor]\n", argv[0]);
+        return 1;
+    }
+    bp_metrics_print();
+    bundle_block_pool_print();
+#ifdef MODULE_GNRC_CONTACT_MANAGER
+    for (struct neighbor_t *n = get_neighbor_list(); n != NULL; n = n->next) {
+        printf("neighbor %" PRIu32 " srtt %" PRIu32 " us\n", n->endpoint_num,
+               n->srtt);
+    }
+#endif
+#ifdef MODULE_ROUTING_PROPHET
+    puts("delivery predictabilities:");
+    routing_prophet_print();
+#endif
+#ifdef MODULE_ROUTING_CGR
+    routing_cgr_print();
+#endif
+    return 0;
+}
+
+/** @} */
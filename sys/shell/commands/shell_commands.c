@@ -118,6 +118,10 @@ extern int _gnrc_6ctx(int argc, char **argv);
 extern int _gnrc_6lo_frag_stats(int argc, char **argv);
 #endif
 
+#ifdef MODULE_GNRC_BP
+extern int _gnrc_bp_metrics(int argc, char **argv);
+#endif
+
 #ifdef MODULE_CCN_LITE_UTILS
 extern int _ccnl_open(int argc, char **argv);
 extern int _ccnl_content(int argc, char **argv);
@@ -239,6 +243,9 @@ const shell_command_t _shell_command_list[] = {
 #ifdef MODULE_GNRC_SIXLOWPAN_FRAG_STATS
     {"6lo_frag", "6LoWPAN fragment statistics", _gnrc_6lo_frag_stats },
 #endif
+#ifdef MODULE_GNRC_BP
+    {"bpstats", "bundle protocol counters, latency histograms and memory use ('bpstats [reset|cbor]')", _gnrc_bp_metrics },
+#endif
 #ifdef MODULE_SAUL_REG
     {"saul", "interact with sensors and actuators using SAUL", _saul },
 #endif
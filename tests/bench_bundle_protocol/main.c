@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure runtime of bundle encoding, decoding and storage
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include "benchmark.h"
+#include "kernel_defines.h"
+#include "checksum/crc16_ccitt.h"
+#include "checksum/crc32c.h"
+
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS          (1000UL)
+#endif
+
+#define TEST_DST_NUM        "2"
+#define TEST_REPORT_NUM     "1"
+#define TEST_SERVICE_NUM    "1"
+#define TEST_LIFETIME       (86400)
+
+/* room for the largest bundle, a full payload block plus the primary block */
+#define BUF_SIZE            (BLOCK_DATA_BUF_SIZE + 128U)
+
+/*
+ * BENCHMARK_FUNC, additionally printing the measurement as a CSV record
+ * "csv,<name>,<param>,<runs>,<total us>,<bytes>" for tracking results
+ */
+#define BENCH(name, param, bytes, func)                                     \
+    {                                                                       \
+        unsigned _benchmark_irqstate = irq_disable();                       \
+        uint32_t _benchmark_time = xtimer_now_usec();                       \
+        for (unsigned long i = 0; i < BENCH_RUNS; i++) {                    \
+            func;                                                           \
+        }                                                                   \
+        _benchmark_time = (xtimer_now_usec() - _benchmark_time);            \
+        irq_restore(_benchmark_irqstate);                                   \
+        benchmark_print_time(_benchmark_time, BENCH_RUNS, name);            \
+        printf("csv,%s,%u,%lu,%" PRIu32 ",%u\n", name, (unsigned)(param),   \
+               BENCH_RUNS, _benchmark_time, (unsigned)(bytes));             \
+    }
+
+static const unsigned _payload_sizes[] = { 8, 32, BLOCK_DATA_BUF_SIZE };
+static const uint8_t _crc_types[] = { NOCRC, CRC_16, CRC_32 };
+static const char *_crc_names[] = { "nocrc", "crc16", "crc32" };
+
+static uint8_t _payload[BLOCK_DATA_BUF_SIZE];
+static uint8_t _buf[BUF_SIZE];
+static volatile uint32_t _sink;
+
+static struct actual_bundle *_create(unsigned payload_size, uint8_t crc_type)
+{
+    struct actual_bundle *bundle = create_bundle();
+    uint64_t payload_flag;
+
+    if (bundle == NULL) {
+        return NULL;
+    }
+    calculate_canonical_flag(&payload_flag, false);
+    if (fill_bundle(bundle, 7, IPN, TEST_DST_NUM, TEST_REPORT_NUM,
+                    TEST_LIFETIME, crc_type, TEST_SERVICE_NUM) < 0 ||
+        bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, payload_flag,
+                         _payload, crc_type, payload_size) < 0) {
+        delete_bundle(bundle);
+        return NULL;
+    }
+    return bundle;
+}
+
+static size_t _encode(struct actual_bundle *bundle)
+{
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, _buf, sizeof(_buf));
+    bundle_encode(bundle, &enc);
+    return nanocbor_encoded_len(&enc);
+}
+
+static int _decode(struct actual_bundle *bundle, size_t len)
+{
+    /* decoding appends the blocks, the previous ones go back to the block pool */
+    bundle_release_blocks(bundle);
+    return bundle_decode(bundle, _buf, len);
+}
+
+static void _clear_storage(void)
+{
+    struct bundle_list *list;
+
+    while ((list = get_bundle_list()) != NULL) {
+        set_retention_constraint(&list->current_bundle, NO_RETENTION_CONSTRAINT);
+        delete_bundle(&list->current_bundle);
+    }
+}
+
+static void _run_codec(unsigned payload_size, unsigned crc)
+{
+    char name[32];
+    struct actual_bundle *bundle = _create(payload_size, _crc_types[crc]);
+    struct actual_bundle *decoded = create_bundle();
+
+    if (bundle == NULL || decoded == NULL) {
+        puts("could not create bundles");
+        return;
+    }
+    size_t len = _encode(bundle);
+    if (_decode(decoded, len) < 0) {
+        puts("could not decode bundle");
+        return;
+    }
+
+    snprintf(name, sizeof(name), "bundle_encode/%s", _crc_names[crc]);
+    BENCH(name, payload_size, len, _sink = _encode(bundle));
+    snprintf(name, sizeof(name), "bundle_decode/%s", _crc_names[crc]);
+    BENCH(name, payload_size, len, _sink = _decode(decoded, len));
+    if (_crc_types[crc] == CRC_16) {
+        BENCH("crc16_ccitt_update", payload_size, len,
+              _sink = crc16_ccitt_update(CRC16_INIT, _buf, len));
+    }
+    else if (_crc_types[crc] == CRC_32) {
+        BENCH("crc32c_calc", payload_size, len, _sink = crc32c_calc(_buf, len));
+    }
+
+    _clear_storage();
+}
+
+static void _run_storage(unsigned depth)
+{
+    struct actual_bundle *bundle = NULL;
+
+    /* bundles already held, the measured ones come on top */
+    for (unsigned i = 0; i < depth; i++) {
+        bundle = _create(8, NOCRC);
+        add_bundle_to_processed_bundle_list(bundle);
+    }
+
+    BENCH("get_space/delete_bundle", depth, sizeof(struct bundle_list),
+          delete_bundle(get_space_for_bundle()));
+    if (bundle != NULL) {
+        BENCH("is_redundant_bundle", depth, sizeof(struct bundle_list),
+              _sink = is_redundant_bundle(bundle));
+        BENCH("get_bundle_from_list", depth, sizeof(struct bundle_list),
+              _sink = (uintptr_t)get_bundle_from_list(bundle->primary_block.creation_timestamp[0],
+                                                      bundle->primary_block.creation_timestamp[1],
+                                                      bundle->primary_block.src_num));
+        BENCH("verify_bundle_processed", depth, PROCESSED_BUNDLES_BLOOM_BYTES,
+              _sink = verify_bundle_processed(bundle));
+    }
+
+    _clear_storage();
+}
+
+int main(void)
+{
+    puts("Runtime of bundle protocol functions\n");
+    puts("csv,name,param,runs,total_us,bytes");
+
+    for (unsigned i = 0; i < sizeof(_payload); i++) {
+        _payload[i] = i;
+    }
+    bundle_storage_init();
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_payload_sizes); i++) {
+        printf("\n%u byte payload:\n", _payload_sizes[i]);
+        for (unsigned crc = 0; crc < ARRAY_SIZE(_crc_types); crc++) {
+            _run_codec(_payload_sizes[i], crc);
+        }
+    }
+
+    /* one slot is left for the bundle taken by get_space_for_bundle(), besides the discovery slots */
+    const unsigned depths[] = { 1, MAX_BUNDLES / 2, MAX_BUNDLES - BUNDLE_STORAGE_DISCOVERY_SLOTS - 1 };
+    for (unsigned i = 0; i < ARRAY_SIZE(depths); i++) {
+        printf("\n%u bundles stored:\n", depths[i]);
+        _run_storage(depths[i]);
+    }
+
+    puts("\n[SUCCESS]");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+# The default timeout is not enough for this test on some of the slower boards
+TIMEOUT = 30
+BENCHMARK_REGEXP = r"\s+{func}:\s+\d+us\s+---\s+\d*\.*\d+us per call\s+---\s+\d+ calls per sec"
+CSV_REGEXP = r"csv,{func},\d+,\d+,\d+,\d+"
+
+
+def expect_bench(child, func):
+    child.expect(BENCHMARK_REGEXP.format(func=func), timeout=TIMEOUT)
+    child.expect(CSV_REGEXP.format(func=func))
+
+
+def testfunc(child):
+    child.expect_exact('Runtime of bundle protocol functions')
+    child.expect_exact('csv,name,param,runs,total_us,bytes')
+    for size in (8, 32, 100):
+        child.expect_exact('{} byte payload:'.format(size))
+        for crc in ('nocrc', 'crc16', 'crc32'):
+            expect_bench(child, 'bundle_encode/' + crc)
+            expect_bench(child, 'bundle_decode/' + crc)
+            if crc == 'crc16':
+                expect_bench(child, 'crc16_ccitt_update')
+            elif crc == 'crc32':
+                expect_bench(child, 'crc32c_calc')
+    for _ in range(3):
+        child.expect(r'\d+ bundles stored:')
+        expect_bench(child, 'get_space/delete_bundle')
+        expect_bench(child, 'is_redundant_bundle')
+        expect_bench(child, 'get_bundle_from_list')
+        expect_bench(child, 'verify_bundle_processed')
+    child.expect_exact('[SUCCESS]')
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure runtime of the CRC implementations used by the
+ *              bundle protocol
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "benchmark.h"
+#include "checksum/crc16_ccitt.h"
+#include "checksum/crc32c.h"
+#include "checksum/ucrc16.h"
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS          (10UL * 1000UL)
+#endif
+
+/* roughly the largest encoded block (BLOCK_DATA_BUF_SIZE plus headers) */
+#define BUF_SIZE            (128U)
+
+static uint8_t _buf[BUF_SIZE];
+static volatile uint32_t _sink;
+
+/* the bit-at-a-time loop the bundle protocol used before */
+static uint32_t _crc32c_bitwise(const uint8_t *buf, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc ^= *buf++;
+        for (unsigned i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static void _run(size_t len)
+{
+    printf("\n%u byte:\n", (unsigned)len);
+    BENCHMARK_FUNC("ucrc16_calc_be()", BENCH_RUNS,
+                   _sink = ucrc16_calc_be(_buf, len, 0x1021, 0xFFFF));
+    BENCHMARK_FUNC("crc16_ccitt_update()", BENCH_RUNS,
+                   _sink = crc16_ccitt_update(0xFFFF, _buf, len));
+    BENCHMARK_FUNC("crc32c bitwise", BENCH_RUNS,
+                   _sink = _crc32c_bitwise(_buf, len));
+    BENCHMARK_FUNC("crc32c_calc()", BENCH_RUNS,
+                   _sink = crc32c_calc(_buf, len));
+}
+
+int main(void)
+{
+    puts("Runtime of CRC functions\n");
+
+    for (unsigned i = 0; i < sizeof(_buf); i++) {
+        _buf[i] = i;
+    }
+
+    _run(8);
+    _run(32);
+    _run(BUF_SIZE);
+
+    puts("\n[SUCCESS]");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+# The default timeout is not enough for this test on some of the slower boards
+TIMEOUT = 30
+BENCHMARK_REGEXP = r"\s+{func}:\s+\d+us\s+---\s+\d*\.*\d+us per call\s+---\s+\d+ calls per sec"
+
+
+def testfunc(child):
+    child.expect_exact('Runtime of CRC functions')
+    for size in (8, 32, 128):
+        child.expect_exact('{} byte:'.format(size))
+        child.expect(BENCHMARK_REGEXP.format(func=r"ucrc16_calc_be\(\)"), timeout=TIMEOUT)
+        child.expect(BENCHMARK_REGEXP.format(func=r"crc16_ccitt_update\(\)"), timeout=TIMEOUT)
+        child.expect(BENCHMARK_REGEXP.format(func="crc32c bitwise"), timeout=TIMEOUT)
+        child.expect(BENCHMARK_REGEXP.format(func=r"crc32c_calc\(\)"), timeout=TIMEOUT)
+    child.expect_exact('[SUCCESS]')
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Node of the multi-node bundle protocol simulation
+ *
+ * Every native instance of this application is one DTN node. The simulation
+ * script sets the node number and injects traffic over the shell, sent and
+ * delivered bundles are reported as "bpsim: tx/rx" lines next to the
+ * periodic "#*#*" statistics of the bundle protocol.
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell.h"
+#include "msg.h"
+#include "thread.h"
+#include "net/gnrc/netif.h"
+#include "net/gnrc/bundle_protocol/agent.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+
+#define MAIN_QUEUE_SIZE     (8)
+
+#define SIM_SERVICE_NUM     (1)
+/* every payload starts with its 32 bit sequence number */
+#define SIM_SEQ_LEN         (4U)
+#define SIM_PAYLOAD_MAX     (BUNDLE_REASSEMBLY_MAX_SIZE)
+
+/* sequence numbers of payloads still being received in fragments */
+typedef struct {
+    uint32_t src_num;
+    uint32_t creation_timestamp[2];
+    uint32_t seq;
+    bool used;
+} sim_pending_t;
+
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+static uint8_t _payload[SIM_PAYLOAD_MAX];
+static sim_pending_t _pending[BUNDLE_REASSEMBLY_SIZE];
+
+static sim_pending_t *_get_pending(const struct bundle_id *id)
+{
+    sim_pending_t *free_entry = NULL;
+
+    for (unsigned i = 0; i < BUNDLE_REASSEMBLY_SIZE; i++) {
+        if (!_pending[i].used) {
+            free_entry = (free_entry == NULL) ? &_pending[i] : free_entry;
+        }
+        else if (_pending[i].src_num == id->src_num &&
+                 _pending[i].creation_timestamp[0] == id->creation_timestamp[0] &&
+                 _pending[i].creation_timestamp[1] == id->creation_timestamp[1]) {
+            return &_pending[i];
+        }
+    }
+    if (free_entry != NULL) {
+        free_entry->src_num = id->src_num;
+        free_entry->creation_timestamp[0] = id->creation_timestamp[0];
+        free_entry->creation_timestamp[1] = id->creation_timestamp[1];
+        free_entry->seq = 0;
+        free_entry->used = true;
+    }
+    return free_entry;
+}
+
+static void _sink(void *arg, const struct bundle_id *id, size_t offset,
+                  const uint8_t *data, size_t len, bool done)
+{
+    sim_pending_t *pending = _get_pending(id);
+    (void)arg;
+
+    if (pending == NULL) {
+        puts("bpsim: no room to track payload");
+        return;
+    }
+    if (offset == 0 && len >= SIM_SEQ_LEN) {
+        pending->seq = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                       ((uint32_t)data[2] << 8) | data[3];
+    }
+    if (done) {
+        size_t total = id->total_application_data_length ?
+                       id->total_application_data_length : offset + len;
+        printf("bpsim: rx %" PRIu32 " %" PRIu32 " %u\n", id->src_num,
+               pending->seq, (unsigned)total);
+        pending->used = false;
+    }
+}
+
+static int _node_cmd(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <node number>\n", argv[0]);
+        return 1;
+    }
+    if (set_src_num(argv[1]) < 0) {
+        puts("error: invalid node number");
+        return 1;
+    }
+    printf("bpsim: node %s\n", get_src_num());
+    return 0;
+}
+
+static int _send_cmd(int argc, char **argv)
+{
+    char dst[MAX_ENDPOINT_SIZE];
+    uint32_t seq;
+    unsigned len;
+
+    if (argc < 4) {
+        printf("usage: %s <dst node> <seq> <len> [prio]\n", argv[0]);
+        return 1;
+    }
+    seq = strtoul(argv[2], NULL, 10);
+    len = atoi(argv[3]);
+    if (len < SIM_SEQ_LEN || len > SIM_PAYLOAD_MAX) {
+        printf("error: len must be between %u and %u\n", SIM_SEQ_LEN,
+               (unsigned)SIM_PAYLOAD_MAX);
+        return 1;
+    }
+    _payload[0] = seq >> 24;
+    _payload[1] = seq >> 16;
+    _payload[2] = seq >> 8;
+    _payload[3] = seq;
+    for (unsigned i = SIM_SEQ_LEN; i < len; i++) {
+        _payload[i] = i;
+    }
+    /* send_bundle() tokenizes the endpoint id in place */
+    snprintf(dst, sizeof(dst), "ipn://%s.%u", argv[1], SIM_SERVICE_NUM);
+    printf("bpsim: tx %s %" PRIu32 " %u\n", argv[1], seq, len);
+    if (send_bundle(_payload, len, dst, "1", NOCRC, DUMMY_PAYLOAD_LIFETIME,
+                    (argc > 4) ? atoi(argv[4]) : BUNDLE_PRIORITY_NORMAL) < 0) {
+        puts("error: could not send bundle");
+        return 1;
+    }
+    return 0;
+}
+
+static int _stats_cmd(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    print_network_statistics();
+    return 0;
+}
+
+static const shell_command_t shell_commands[] = {
+    { "node", "set the node number", _node_cmd },
+    { "send", "send a bundle to a node", _send_cmd },
+    { "stats", "print the bundle protocol statistics", _stats_cmd },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    gnrc_netif_t *netif = gnrc_netif_iter(NULL);
+
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+    puts("Bundle protocol simulation node");
+
+    if (netif == NULL) {
+        puts("error: no network interface");
+        return 1;
+    }
+    bundle_protocol_init();
+    register_application_sink(SIM_SERVICE_NUM, thread_getpid(), _sink, NULL);
+    set_registration_state(SIM_SERVICE_NUM, REGISTRATION_ACTIVE);
+
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+
+    return 0;
+}
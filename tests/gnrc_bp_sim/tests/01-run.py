@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+STATS_REGEXP = r"#\*#\*,\d+(, \d+){8},\d+,\d+,"
+
+
+def testfunc(child):
+    child.expect_exact('Bundle protocol simulation node')
+    child.sendline('node x1')
+    child.expect_exact('error: invalid node number')
+    child.sendline('node 7')
+    child.expect_exact('bpsim: node 7')
+    child.sendline('send 3 1 2')
+    child.expect_exact('error: len must be between')
+    child.sendline('send 3 42 20')
+    child.expect_exact('bpsim: tx 3 42 20')
+    child.sendline('stats')
+    child.expect(STATS_REGEXP)
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
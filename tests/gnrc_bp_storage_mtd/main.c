@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Test application for the persistent bundle storage on MTD
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "shell.h"
+
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/bundle_storage_mtd.h"
+
+#define TEST_DST_NUM        "2"
+#define TEST_REPORT_NUM     "1"
+#define TEST_SERVICE_NUM    "1234"
+#define TEST_LIFETIME       (86400)
+
+static int _add(void)
+{
+    static uint32_t count = 0;
+    uint8_t payload[32];
+    struct actual_bundle *bundle = create_bundle();
+
+    if (bundle == NULL) {
+        puts("error: storage full");
+        return -1;
+    }
+    if (fill_bundle(bundle, 7, IPN, TEST_DST_NUM, TEST_REPORT_NUM, TEST_LIFETIME,
+                    CRC_32, TEST_SERVICE_NUM) < 0) {
+        puts("error: could not fill bundle");
+        delete_bundle(bundle);
+        return -1;
+    }
+    int len = snprintf((char *)payload, sizeof(payload), "bundle %lu", (unsigned long)count++);
+    bundle_add_block(bundle, BUNDLE_BLOCK_TYPE_PAYLOAD, 0, payload, CRC_32, len + 1);
+    if (bundle_storage_persist(bundle) < 0) {
+        puts("error: could not persist bundle");
+        return -1;
+    }
+    return 0;
+}
+
+static int _del(void)
+{
+    struct bundle_list *head = get_bundle_list();
+
+    if (head == NULL) {
+        puts("error: storage empty");
+        return -1;
+    }
+    set_retention_constraint(&head->current_bundle, NO_RETENTION_CONSTRAINT);
+    return delete_bundle(&head->current_bundle) ? 0 : -1;
+}
+
+static void _list(void)
+{
+    struct bundle_list *temp;
+
+    for (temp = get_bundle_list(); temp != NULL; temp = temp->next) {
+        struct actual_bundle *bundle = &temp->current_bundle;
+        printf("ipn:%lu seq %lu: %s\n", (unsigned long)bundle->primary_block.src_num,
+               (unsigned long)bundle->primary_block.creation_timestamp[1],
+               (char *)bundle_get_payload_block(bundle)->block_data);
+    }
+    printf("%u bundles stored\n", get_current_active_bundles());
+}
+
+static int _bpstore(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <add|del|churn|clear|list> [n]\n", argv[0]);
+        return 1;
+    }
+    int n = (argc > 2) ? atoi(argv[2]) : 1;
+
+    if (strcmp(argv[1], "add") == 0) {
+        for (int i = 0; i < n; i++) {
+            if (_add() < 0) {
+                return 1;
+            }
+        }
+    }
+    else if (strcmp(argv[1], "del") == 0) {
+        if (_del() < 0) {
+            return 1;
+        }
+    }
+    else if (strcmp(argv[1], "churn") == 0) {
+        for (int i = 0; i < n; i++) {
+            if (_add() < 0 || _del() < 0) {
+                return 1;
+            }
+        }
+        bundle_storage_mtd_sync();
+    }
+    else if (strcmp(argv[1], "clear") == 0) {
+        while (get_bundle_list() != NULL) {
+            if (_del() < 0) {
+                return 1;
+            }
+        }
+    }
+    else if (strcmp(argv[1], "list") != 0) {
+        printf("error: unknown command %s\n", argv[1]);
+        return 1;
+    }
+    _list();
+    return 0;
+}
+
+static const shell_command_t shell_commands[] = {
+    { "bpstore", "add, delete and list persistent bundles", _bpstore },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    puts("Persistent bundle storage test");
+
+    if (bundle_storage_mtd_init(MTD_0) < 0) {
+        puts("error: could not initialize MTD storage");
+        return 1;
+    }
+    bundle_storage_init();
+    printf("restored %u bundles\n", get_current_active_bundles());
+
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+def reboot(child, count):
+    child.sendline('reboot')
+    child.expect_exact('Persistent bundle storage test')
+    child.expect_exact('restored {} bundles'.format(count))
+
+
+def bpstore(child, cmd, count):
+    child.sendline('bpstore ' + cmd)
+    child.expect_exact('{} bundles stored'.format(count))
+
+
+def testfunc(child):
+    child.expect(r'restored \d+ bundles')
+    bpstore(child, 'clear', 0)
+    bpstore(child, 'add 3', 3)
+    reboot(child, 3)
+    bpstore(child, 'list', 3)
+    bpstore(child, 'del', 2)
+    reboot(child, 2)
+    # enough appends and tombstones to compact the log several times
+    bpstore(child, 'churn 400', 2)
+    bpstore(child, 'add 2', 4)
+    reboot(child, 4)
+    bpstore(child, 'clear', 0)
+    reboot(child, 0)
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
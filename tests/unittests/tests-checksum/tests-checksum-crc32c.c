@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "checksum/crc32c.h"
+
+#include "tests-checksum.h"
+
+static int calc_and_compare_crc_with_update(const unsigned char *buf,
+        size_t len, size_t split, uint32_t expected)
+{
+    uint32_t result = crc32c_calc(buf, split);
+
+    result = crc32c_update(result, buf + split, len - split);
+
+    return result == expected;
+}
+
+static int calc_and_compare_crc(const unsigned char *buf, size_t len,
+        uint32_t expected)
+{
+    uint32_t result = crc32c_calc(buf, len);
+
+    return result == expected;
+}
+
+static void test_checksum_crc32c_sequence_empty(void)
+{
+    unsigned char buf[] = "";
+    uint32_t expect = 0x00000000;
+
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf) - 1, expect));
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf) - 1,
+                (sizeof(buf) - 1) / 2, expect));
+}
+
+static void test_checksum_crc32c_sequence_1a(void)
+{
+    unsigned char buf[] = "A";
+    uint32_t expect = 0xE16DCDEE;
+
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf) - 1, expect));
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf) - 1,
+                (sizeof(buf) - 1) / 2, expect));
+}
+
+static void test_checksum_crc32c_sequence_1to9(void)
+{
+    unsigned char buf[] = "123456789";
+    uint32_t expect = 0xE3069283;
+
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf) - 1, expect));
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf) - 1,
+                (sizeof(buf) - 1) / 2, expect));
+}
+
+static void test_checksum_crc32c_sequence_32zeros(void)
+{
+    unsigned char buf[32];
+    uint32_t expect = 0x8A9136AA;
+
+    memset(buf, 0x00, sizeof(buf));
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf), expect));
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf),
+                sizeof(buf) / 2, expect));
+}
+
+static void test_checksum_crc32c_sequence_32ones(void)
+{
+    unsigned char buf[32];
+    uint32_t expect = 0x62A8AB43;
+
+    memset(buf, 0xFF, sizeof(buf));
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf), expect));
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf),
+                sizeof(buf) / 2, expect));
+}
+
+static void test_checksum_crc32c_sequence_32incrementing(void)
+{
+    unsigned char buf[32];
+    uint32_t expect = 0x46DD794E;
+
+    for (unsigned i = 0; i < sizeof(buf); i++) {
+        buf[i] = i;
+    }
+    TEST_ASSERT(calc_and_compare_crc(buf, sizeof(buf), expect));
+    /* odd split, so the second chunk starts unaligned */
+    TEST_ASSERT(calc_and_compare_crc_with_update(buf, sizeof(buf), 13,
+                expect));
+}
+
+Test *tests_checksum_crc32c_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        /* Reference values according to RFC 3720, appendix B.4 */
+        new_TestFixture(test_checksum_crc32c_sequence_empty),
+        new_TestFixture(test_checksum_crc32c_sequence_1a),
+        new_TestFixture(test_checksum_crc32c_sequence_1to9),
+        new_TestFixture(test_checksum_crc32c_sequence_32zeros),
+        new_TestFixture(test_checksum_crc32c_sequence_32ones),
+        new_TestFixture(test_checksum_crc32c_sequence_32incrementing),
+    };
+
+    EMB_UNIT_TESTCALLER(checksum_crc32c_tests, NULL, NULL, fixtures);
+
+    return (Test *)&checksum_crc32c_tests;
+}
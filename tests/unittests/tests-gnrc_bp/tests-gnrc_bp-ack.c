@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "net/gnrc/bundle_protocol/bundle_ack.h"
+
+#include "tests-gnrc_bp.h"
+
+#define TEST_IFACE      (5)
+#define TEST_MAX_RANGES (8)
+
+struct test_range {
+    uint32_t src_num;
+    uint32_t creation_timestamp0;
+    uint32_t start;
+    uint32_t count;
+};
+
+static const uint8_t l2addr_a[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a };
+static const uint8_t l2addr_b[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b };
+static struct test_range ranges[TEST_MAX_RANGES];
+static unsigned num_ranges;
+static uint8_t frame[64];
+
+static void _range(void *arg, uint32_t src_num, uint32_t creation_timestamp0,
+                   uint32_t start, uint32_t count)
+{
+    (void)arg;
+    if (num_ranges < TEST_MAX_RANGES) {
+        ranges[num_ranges++] = (struct test_range){ src_num, creation_timestamp0, start, count };
+    }
+}
+
+static int _queue(uint32_t src_num, uint32_t time, uint32_t seq, const uint8_t *l2addr)
+{
+    struct bundle_id id;
+
+    memset(&id, 0, sizeof(id));
+    id.src_num = src_num;
+    id.creation_timestamp[0] = time;
+    id.creation_timestamp[1] = seq;
+    return bundle_ack_queue(&id, l2addr, sizeof(l2addr_a), TEST_IFACE);
+}
+
+static int _encode_next(size_t len, uint8_t *l2addr)
+{
+    size_t l2addr_len;
+    kernel_pid_t iface;
+
+    return bundle_ack_encode_next(frame, len, l2addr, &l2addr_len, &iface);
+}
+
+static void set_up(void)
+{
+    uint8_t l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+
+    /* the queue outlives a test */
+    while (_encode_next(sizeof(frame), l2addr) > 0) {}
+    num_ranges = 0;
+}
+
+static void test_gnrc_bp_ack_encode_ranges(void)
+{
+    uint8_t l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+    size_t l2addr_len;
+    kernel_pid_t iface;
+    int len;
+
+    /* queued out of order, sequence numbers 1 to 3 and 5 of one source */
+    _queue(2, 100, 3, l2addr_a);
+    _queue(2, 100, 1, l2addr_a);
+    _queue(2, 100, 5, l2addr_a);
+    _queue(2, 100, 2, l2addr_a);
+    _queue(3, 100, 7, l2addr_a);
+    len = bundle_ack_encode_next(frame, sizeof(frame), l2addr, &l2addr_len, &iface);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(sizeof(l2addr_a), l2addr_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(l2addr, l2addr_a, sizeof(l2addr_a)));
+    TEST_ASSERT_EQUAL_INT(TEST_IFACE, iface);
+    TEST_ASSERT(bundle_ack_is_frame(frame, len));
+
+    TEST_ASSERT_EQUAL_INT(3, bundle_ack_decode(frame, len, _range, NULL));
+    TEST_ASSERT_EQUAL_INT(2, ranges[0].src_num);
+    TEST_ASSERT_EQUAL_INT(100, ranges[0].creation_timestamp0);
+    TEST_ASSERT_EQUAL_INT(1, ranges[0].start);
+    TEST_ASSERT_EQUAL_INT(3, ranges[0].count);
+    TEST_ASSERT_EQUAL_INT(2, ranges[1].src_num);
+    TEST_ASSERT_EQUAL_INT(5, ranges[1].start);
+    TEST_ASSERT_EQUAL_INT(1, ranges[1].count);
+    TEST_ASSERT_EQUAL_INT(3, ranges[2].src_num);
+    TEST_ASSERT_EQUAL_INT(7, ranges[2].start);
+    TEST_ASSERT_EQUAL_INT(1, ranges[2].count);
+    /* all of them went out */
+    TEST_ASSERT_EQUAL_INT(0, _encode_next(sizeof(frame), l2addr));
+}
+
+static void test_gnrc_bp_ack_queue_duplicate(void)
+{
+    int free_entries = _queue(2, 100, 1, l2addr_a);
+
+    TEST_ASSERT_EQUAL_INT(BUNDLE_ACK_QUEUE_SIZE - 1, free_entries);
+    TEST_ASSERT_EQUAL_INT(free_entries, _queue(2, 100, 1, l2addr_a));
+    /* the same bundle acked to another neighbor takes its own entry */
+    TEST_ASSERT_EQUAL_INT(free_entries - 1, _queue(2, 100, 1, l2addr_b));
+}
+
+static void test_gnrc_bp_ack_queue_full(void)
+{
+    for (unsigned i = 0; i < BUNDLE_ACK_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(BUNDLE_ACK_QUEUE_SIZE - 1 - i, _queue(2, 100, i, l2addr_a));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, _queue(2, 100, BUNDLE_ACK_QUEUE_SIZE, l2addr_a));
+}
+
+static void test_gnrc_bp_ack_batch_per_neighbor(void)
+{
+    uint8_t l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+    int len;
+
+    _queue(2, 100, 1, l2addr_a);
+    _queue(2, 100, 2, l2addr_b);
+    _queue(2, 100, 3, l2addr_a);
+
+    len = _encode_next(sizeof(frame), l2addr);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(l2addr, l2addr_a, sizeof(l2addr_a)));
+    TEST_ASSERT_EQUAL_INT(2, bundle_ack_decode(frame, len, _range, NULL));
+
+    num_ranges = 0;
+    len = _encode_next(sizeof(frame), l2addr);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(l2addr, l2addr_b, sizeof(l2addr_b)));
+    TEST_ASSERT_EQUAL_INT(1, bundle_ack_decode(frame, len, _range, NULL));
+    TEST_ASSERT_EQUAL_INT(2, ranges[0].start);
+    TEST_ASSERT_EQUAL_INT(0, _encode_next(sizeof(frame), l2addr));
+}
+
+static void test_gnrc_bp_ack_batch_split(void)
+{
+    uint8_t l2addr[GNRC_NETIF_L2ADDR_MAXLEN];
+    int len;
+
+    /* [0, [2, 100, 1, 1]] takes 8 bytes, both groups do not fit into 10 */
+    _queue(2, 100, 1, l2addr_a);
+    _queue(3, 100, 1, l2addr_a);
+    TEST_ASSERT_EQUAL_INT(-1, _encode_next(6, l2addr));
+
+    len = _encode_next(10, l2addr);
+    TEST_ASSERT_EQUAL_INT(8, len);
+    TEST_ASSERT_EQUAL_INT(1, bundle_ack_decode(frame, len, _range, NULL));
+    TEST_ASSERT_EQUAL_INT(2, ranges[0].src_num);
+    len = _encode_next(10, l2addr);
+    TEST_ASSERT_EQUAL_INT(1, bundle_ack_decode(frame, len, _range, NULL));
+    TEST_ASSERT_EQUAL_INT(3, ranges[1].src_num);
+}
+
+static void test_gnrc_bp_ack_is_frame(void)
+{
+    /* start of an encoded bundle and of an IPHC compressed datagram */
+    static const uint8_t bundle[] = { 0x9f, 0x89, 0x07 };
+    static const uint8_t iphc[] = { 0x7a, 0x33 };
+    static const uint8_t malformed[] = { 0x82, 0x00, 0x82 };
+
+    TEST_ASSERT(!bundle_ack_is_frame(bundle, sizeof(bundle)));
+    TEST_ASSERT(!bundle_ack_is_frame(iphc, sizeof(iphc)));
+    TEST_ASSERT_EQUAL_INT(-1, bundle_ack_decode(bundle, sizeof(bundle), _range, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, bundle_ack_decode(malformed, sizeof(malformed), _range, NULL));
+}
+
+Test *tests_gnrc_bp_ack_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gnrc_bp_ack_encode_ranges),
+        new_TestFixture(test_gnrc_bp_ack_queue_duplicate),
+        new_TestFixture(test_gnrc_bp_ack_queue_full),
+        new_TestFixture(test_gnrc_bp_ack_batch_per_neighbor),
+        new_TestFixture(test_gnrc_bp_ack_batch_split),
+        new_TestFixture(test_gnrc_bp_ack_is_frame),
+    };
+
+    EMB_UNIT_TESTCALLER(gnrc_bp_ack_tests, set_up, NULL, fixtures);
+
+    return (Test *)&gnrc_bp_ack_tests;
+}
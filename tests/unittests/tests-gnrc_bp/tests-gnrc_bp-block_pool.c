@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "net/gnrc/bundle_protocol/bundle_block_pool.h"
+
+#include "tests-gnrc_bp.h"
+
+static void set_up(void)
+{
+    bundle_block_pool_init();
+}
+
+static void test_gnrc_bp_block_pool_alloc_smallest_class(void)
+{
+    uint8_t *small = bundle_block_pool_alloc(1);
+    uint8_t *medium = bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_SMALL_SIZE + 1);
+    uint8_t *large = bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE + 1);
+
+    TEST_ASSERT_EQUAL_INT(BUNDLE_BLOCK_POOL_SMALL_SIZE,
+                          bundle_block_pool_chunk_size(small));
+    TEST_ASSERT_EQUAL_INT(BUNDLE_BLOCK_POOL_MEDIUM_SIZE,
+                          bundle_block_pool_chunk_size(medium));
+    TEST_ASSERT_EQUAL_INT(BLOCK_DATA_BUF_SIZE,
+                          bundle_block_pool_chunk_size(large));
+    /* the largest class still holds a full block */
+    TEST_ASSERT_NOT_NULL(bundle_block_pool_alloc(BLOCK_DATA_BUF_SIZE));
+    TEST_ASSERT_NULL(bundle_block_pool_alloc(BLOCK_DATA_BUF_SIZE + 1));
+}
+
+static void test_gnrc_bp_block_pool_alloc_falls_back(void)
+{
+    struct bundle_block_pool_stats stats;
+    uint8_t *chunk;
+
+    for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_SMALL_NUM; i++) {
+        TEST_ASSERT_NOT_NULL(bundle_block_pool_alloc(1));
+    }
+    chunk = bundle_block_pool_alloc(1);
+    TEST_ASSERT_EQUAL_INT(BUNDLE_BLOCK_POOL_MEDIUM_SIZE,
+                          bundle_block_pool_chunk_size(chunk));
+    bundle_block_pool_stats(0, &stats);
+    TEST_ASSERT_EQUAL_INT(BUNDLE_BLOCK_POOL_SMALL_NUM, stats.used);
+    TEST_ASSERT_EQUAL_INT(1, stats.full);
+}
+
+static void test_gnrc_bp_block_pool_alloc_exhausted(void)
+{
+    struct bundle_block_pool_stats stats;
+    uint8_t *chunk;
+
+    for (unsigned i = 0; i < BUNDLE_BLOCK_POOL_LARGE_NUM; i++) {
+        TEST_ASSERT_NOT_NULL(bundle_block_pool_alloc(BLOCK_DATA_BUF_SIZE));
+    }
+    TEST_ASSERT_NULL(bundle_block_pool_alloc(BLOCK_DATA_BUF_SIZE));
+    /* smaller data still fits into the other classes */
+    chunk = bundle_block_pool_alloc(1);
+    TEST_ASSERT_NOT_NULL(chunk);
+    bundle_block_pool_free(chunk);
+    bundle_block_pool_stats(0, &stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.used);
+    TEST_ASSERT_EQUAL_INT(1, stats.peak);
+}
+
+static void test_gnrc_bp_block_pool_free_reuses_chunk(void)
+{
+    uint8_t *chunk = bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE);
+
+    bundle_block_pool_free(chunk);
+    TEST_ASSERT(bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE) == chunk);
+}
+
+static void test_gnrc_bp_block_pool_foreign_pointer(void)
+{
+    uint8_t buf[BLOCK_DATA_BUF_SIZE];
+    uint8_t *chunk = bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE);
+
+    /* views into a received packet take no chunk */
+    TEST_ASSERT_EQUAL_INT(0, bundle_block_pool_chunk_size(buf));
+    TEST_ASSERT_EQUAL_INT(0, bundle_block_pool_chunk_size(NULL));
+    /* inside a chunk, but not at its start */
+    TEST_ASSERT_EQUAL_INT(0, bundle_block_pool_chunk_size(chunk + 1));
+}
+
+static void test_gnrc_bp_block_pool_free_foreign_pointer(void)
+{
+    struct bundle_block_pool_stats stats;
+    uint8_t buf[BLOCK_DATA_BUF_SIZE];
+    uint8_t *chunk = bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE);
+
+    memset(buf, 0xA5, sizeof(buf));
+    bundle_block_pool_free(buf);
+    bundle_block_pool_free(NULL);
+    bundle_block_pool_free(chunk + 1);
+    bundle_block_pool_stats(1, &stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.used);
+    /* the buffer is left alone instead of ending up in a free list */
+    for (unsigned i = 0; i < sizeof(buf); i++) {
+        TEST_ASSERT_EQUAL_INT(0xA5, buf[i]);
+    }
+    TEST_ASSERT(bundle_block_pool_alloc(BUNDLE_BLOCK_POOL_MEDIUM_SIZE) != chunk);
+}
+
+Test *tests_gnrc_bp_block_pool_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gnrc_bp_block_pool_alloc_smallest_class),
+        new_TestFixture(test_gnrc_bp_block_pool_alloc_falls_back),
+        new_TestFixture(test_gnrc_bp_block_pool_alloc_exhausted),
+        new_TestFixture(test_gnrc_bp_block_pool_free_reuses_chunk),
+        new_TestFixture(test_gnrc_bp_block_pool_foreign_pointer),
+        new_TestFixture(test_gnrc_bp_block_pool_free_foreign_pointer),
+    };
+
+    EMB_UNIT_TESTCALLER(gnrc_bp_block_pool_tests, set_up, NULL, fixtures);
+
+    return (Test *)&gnrc_bp_block_pool_tests;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdint.h>
+
+#include "embUnit/embUnit.h"
+
+#include "nanocbor/nanocbor.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/routing_cgr.h"
+
+#include "tests-gnrc_bp.h"
+
+#define ARRAY_LEN(a)    (sizeof(a) / sizeof((a)[0]))
+
+static void set_up(void)
+{
+    /* routes are computed from node 1 */
+    set_src_num("1");
+}
+
+static void test_gnrc_bp_cgr_earliest_arrival(void)
+{
+    /* over 2 from now on, but 2 reaches 5 only at 100, 3 reaches it at 62 */
+    static const struct cgr_contact plan[] = {
+        { 2, 5, 100, 200, 1 },
+        { 1, 2, 0, 1000, 1 },
+        { 1, 3, 50, 60, 1 },
+        { 3, 5, 60, 70, 2 },
+    };
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(3, routing_cgr_next_hop(5));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(2));
+    TEST_ASSERT_EQUAL_INT(3, routing_cgr_next_hop(3));
+}
+
+static void test_gnrc_bp_cgr_light_time(void)
+{
+    /* all contacts are open, over 3 the one way light time makes the bundle arrive later */
+    static const struct cgr_contact plan[] = {
+        { 1, 2, 0, 1000, 1 },
+        { 2, 4, 0, 1000, 1 },
+        { 1, 3, 0, 1000, 30 },
+        { 3, 4, 0, 1000, 0 },
+    };
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(4));
+}
+
+static void test_gnrc_bp_cgr_multi_hop(void)
+{
+    /* a chain handed on in the order of the contacts, the first hop is the route */
+    static const struct cgr_contact plan[] = {
+        { 4, 5, 300, 400, 0 },
+        { 3, 4, 200, 300, 0 },
+        { 2, 3, 100, 200, 0 },
+        { 1, 2, 0, 100, 0 },
+        /* back to this node, which is never a hop of a route */
+        { 2, 1, 0, 1000, 0 },
+    };
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(5));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(4));
+    TEST_ASSERT_EQUAL_INT(INVALID_EID, routing_cgr_next_hop(1));
+}
+
+static void test_gnrc_bp_cgr_no_route(void)
+{
+    /* 2 reaches 5 only before 1 reaches 2 */
+    static const struct cgr_contact plan[] = {
+        { 1, 2, 100, 200, 0 },
+        { 2, 5, 0, 50, 0 },
+        { 1, 3, 0, 60, 0 },
+    };
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(INVALID_EID, routing_cgr_next_hop(5));
+    TEST_ASSERT_EQUAL_INT(INVALID_EID, routing_cgr_next_hop(9));
+    TEST_ASSERT_EQUAL_INT(3, routing_cgr_next_hop(3));
+
+    /* the same plan loaded later, the contact to 3 is over */
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 500));
+    TEST_ASSERT_EQUAL_INT(INVALID_EID, routing_cgr_next_hop(3));
+}
+
+static void test_gnrc_bp_cgr_load(void)
+{
+    static const struct cgr_contact plan[] = {
+        { 1, 3, 0, 1000, 0 },
+        { 3, 5, 0, 1000, 0 },
+    };
+    uint8_t buf[32];
+    nanocbor_encoder_t enc;
+    size_t len;
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(3, routing_cgr_next_hop(5));
+
+    /* [0, [1, 2, 0, 1000, 0], [2, 5, 0, 1000, 0]], replacing the cached route */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, 0);
+    nanocbor_fmt_array(&enc, 5);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 0);
+    nanocbor_fmt_uint(&enc, 1000);
+    nanocbor_fmt_uint(&enc, 0);
+    nanocbor_fmt_array(&enc, 5);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 5);
+    nanocbor_fmt_uint(&enc, 0);
+    nanocbor_fmt_uint(&enc, 1000);
+    nanocbor_fmt_uint(&enc, 0);
+    len = nanocbor_encoded_len(&enc);
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_load(buf, len));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(5));
+
+    /* a truncated plan leaves the loaded one in place */
+    TEST_ASSERT_EQUAL_INT(ERROR, routing_cgr_load(buf, len - 1));
+    TEST_ASSERT_EQUAL_INT(2, routing_cgr_next_hop(5));
+}
+
+static void test_gnrc_bp_cgr_load_malformed(void)
+{
+    /* [0, [1, 2, 10, 10, 0]], a contact ending when it starts */
+    static const uint8_t empty_contact[] = { 0x82, 0x00, 0x85, 0x01, 0x02, 0x0a, 0x0a, 0x00 };
+    /* [0, [1, 2, 0, 10]], a contact without one way light time */
+    static const uint8_t short_contact[] = { 0x82, 0x00, 0x84, 0x01, 0x02, 0x00, 0x0a };
+    static const struct cgr_contact plan[] = {
+        { 1, 5, 0, 1000, 0 },
+    };
+
+    TEST_ASSERT_EQUAL_INT(OK, routing_cgr_set_plan(plan, ARRAY_LEN(plan), 0));
+    TEST_ASSERT_EQUAL_INT(ERROR, routing_cgr_load(empty_contact, sizeof(empty_contact)));
+    TEST_ASSERT_EQUAL_INT(ERROR, routing_cgr_load(short_contact, sizeof(short_contact)));
+    TEST_ASSERT_EQUAL_INT(5, routing_cgr_next_hop(5));
+}
+
+Test *tests_gnrc_bp_cgr_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gnrc_bp_cgr_earliest_arrival),
+        new_TestFixture(test_gnrc_bp_cgr_light_time),
+        new_TestFixture(test_gnrc_bp_cgr_multi_hop),
+        new_TestFixture(test_gnrc_bp_cgr_no_route),
+        new_TestFixture(test_gnrc_bp_cgr_load),
+        new_TestFixture(test_gnrc_bp_cgr_load_malformed),
+    };
+
+    EMB_UNIT_TESTCALLER(gnrc_bp_cgr_tests, set_up, NULL, fixtures);
+
+    return (Test *)&gnrc_bp_cgr_tests;
+}
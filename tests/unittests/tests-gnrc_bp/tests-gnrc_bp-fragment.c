@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_fragment.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+#include "tests-gnrc_bp.h"
+
+#define TEST_PAYLOAD_LEN    (100)
+/* small enough for a payload of TEST_PAYLOAD_LEN to be fragmented */
+#define TEST_MTU            (60)
+
+/* with room for the fragments running past the end of the payload */
+static uint8_t payload[2 * TEST_PAYLOAD_LEN];
+static uint8_t streamed[TEST_PAYLOAD_LEN];
+static unsigned stream_calls, stream_done;
+
+static int _read(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    memcpy(buf, payload + offset, len);
+    return OK;
+}
+
+static void _write(void *arg, const struct bundle_id *id, size_t offset,
+                   const uint8_t *data, size_t len, bool done)
+{
+    (void)arg;
+    (void)id;
+    memcpy(streamed + offset, data, len);
+    stream_calls++;
+    stream_done += done;
+}
+
+/* Prepared bundle the fragments of one payload are created from */
+static struct actual_bundle *_prepare(void)
+{
+    struct actual_bundle *bundle = create_bundle();
+
+    fill_bundle(bundle, 7, IPN, "2", "1", 100000, NOCRC, "1");
+    bundle_fragment_prepare(bundle, TEST_PAYLOAD_LEN, 0, NOCRC, TEST_MTU);
+    return bundle;
+}
+
+static struct actual_bundle *_fragment(struct actual_bundle *from, size_t offset, size_t len)
+{
+    struct actual_bundle *fragment = create_bundle();
+
+    bundle_fragment_fill(fragment, from, offset, len, _read, NULL);
+    return fragment;
+}
+
+/* Adds the payload range [offset, offset + len) to the reassembly buffer */
+static int _add(struct actual_bundle *from, size_t offset, size_t len, gnrc_pktsnip_t **out)
+{
+    struct actual_bundle *fragment = _fragment(from, offset, len);
+    int res = bundle_reassembly_add(fragment, out);
+
+    delete_bundle(fragment);
+    return res;
+}
+
+static int _stream(struct actual_bundle *from, size_t offset, size_t len)
+{
+    struct actual_bundle *fragment = _fragment(from, offset, len);
+    int res = bundle_reassembly_stream(fragment, _write, NULL);
+
+    delete_bundle(fragment);
+    return res;
+}
+
+static void set_up(void)
+{
+    for (unsigned i = 0; i < sizeof(payload); i++) {
+        payload[i] = i * 7 + 3;
+    }
+    bundle_reassembly_reset();
+    memset(streamed, 0, sizeof(streamed));
+    stream_calls = 0;
+    stream_done = 0;
+}
+
+static void test_gnrc_bp_fragment_prepare(void)
+{
+    struct actual_bundle *bundle = create_bundle();
+    int per_bundle;
+
+    fill_bundle(bundle, 7, IPN, "2", "1", 100000, NOCRC, "1");
+    per_bundle = bundle_fragment_prepare(bundle, TEST_PAYLOAD_LEN, 0, NOCRC, TEST_MTU);
+    TEST_ASSERT(per_bundle > 0 && per_bundle < TEST_PAYLOAD_LEN);
+    TEST_ASSERT(bundle_is_fragment(bundle));
+    TEST_ASSERT_EQUAL_INT(TEST_PAYLOAD_LEN, bundle->primary_block.total_application_data_length);
+    delete_bundle(bundle);
+}
+
+static void test_gnrc_bp_fragment_out_of_order(void)
+{
+    struct actual_bundle *from = _prepare();
+    gnrc_pktsnip_t *out = NULL;
+
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 60, 40, &out));
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 0, 30, &out));
+    TEST_ASSERT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(OK, _add(from, 30, 30, &out));
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(TEST_PAYLOAD_LEN, out->size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out->data, payload, TEST_PAYLOAD_LEN));
+    delete_bundle(from);
+}
+
+static void test_gnrc_bp_fragment_duplicate(void)
+{
+    struct actual_bundle *from = _prepare();
+    gnrc_pktsnip_t *out = NULL;
+
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 0, 50, &out));
+    /* received again, still half of the payload */
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 0, 50, &out));
+    TEST_ASSERT_EQUAL_INT(OK, _add(from, 50, 50, &out));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out->data, payload, TEST_PAYLOAD_LEN));
+    delete_bundle(from);
+}
+
+static void test_gnrc_bp_fragment_overlapping(void)
+{
+    struct actual_bundle *from = _prepare();
+    gnrc_pktsnip_t *out = NULL;
+
+    /* two ranges with a gap, then one overlapping both */
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 10, 10, &out));
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 50, 10, &out));
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 15, 40, &out));
+    /* inside of what was received */
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 20, 20, &out));
+    TEST_ASSERT_EQUAL_INT(0, _add(from, 0, 10, &out));
+    /* overlapping the end of the received range */
+    TEST_ASSERT_EQUAL_INT(OK, _add(from, 40, 60, &out));
+    TEST_ASSERT_EQUAL_INT(TEST_PAYLOAD_LEN, out->size);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out->data, payload, TEST_PAYLOAD_LEN));
+    delete_bundle(from);
+}
+
+static void test_gnrc_bp_fragment_interleaved(void)
+{
+    struct actual_bundle *first = _prepare();
+    struct actual_bundle *second = _prepare();
+    gnrc_pktsnip_t *out = NULL;
+
+    TEST_ASSERT_EQUAL_INT(0, _add(first, 50, 50, &out));
+    TEST_ASSERT_EQUAL_INT(0, _add(second, 0, 50, &out));
+    TEST_ASSERT_EQUAL_INT(OK, _add(second, 50, 50, &out));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out->data, payload, TEST_PAYLOAD_LEN));
+    /* the first payload was kept apart */
+    out = NULL;
+    TEST_ASSERT_EQUAL_INT(OK, _add(first, 0, 50, &out));
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out->data, payload, TEST_PAYLOAD_LEN));
+    delete_bundle(first);
+    delete_bundle(second);
+}
+
+static void test_gnrc_bp_fragment_invalid(void)
+{
+    struct actual_bundle *from = _prepare();
+    gnrc_pktsnip_t *out = NULL;
+
+    /* running past the end of the payload */
+    TEST_ASSERT_EQUAL_INT(ERROR, _add(from, 90, 20, &out));
+    TEST_ASSERT_EQUAL_INT(ERROR, _add(from, TEST_PAYLOAD_LEN, 1, &out));
+    TEST_ASSERT_NULL(out);
+    delete_bundle(from);
+}
+
+static void test_gnrc_bp_fragment_stream_overlapping(void)
+{
+    struct actual_bundle *from = _prepare();
+
+    TEST_ASSERT_EQUAL_INT(0, _stream(from, 70, 30));
+    TEST_ASSERT_EQUAL_INT(0, _stream(from, 0, 40));
+    TEST_ASSERT_EQUAL_INT(0, _stream(from, 20, 40));
+    TEST_ASSERT_EQUAL_INT(0, stream_done);
+    TEST_ASSERT_EQUAL_INT(OK, _stream(from, 50, 30));
+    /* every piece is handed on, overlaps included, and the payload is done once */
+    TEST_ASSERT_EQUAL_INT(4, stream_calls);
+    TEST_ASSERT_EQUAL_INT(1, stream_done);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(streamed, payload, TEST_PAYLOAD_LEN));
+    delete_bundle(from);
+}
+
+Test *tests_gnrc_bp_fragment_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gnrc_bp_fragment_prepare),
+        new_TestFixture(test_gnrc_bp_fragment_out_of_order),
+        new_TestFixture(test_gnrc_bp_fragment_duplicate),
+        new_TestFixture(test_gnrc_bp_fragment_overlapping),
+        new_TestFixture(test_gnrc_bp_fragment_interleaved),
+        new_TestFixture(test_gnrc_bp_fragment_invalid),
+        new_TestFixture(test_gnrc_bp_fragment_stream_overlapping),
+    };
+
+    EMB_UNIT_TESTCALLER(gnrc_bp_fragment_tests, set_up, NULL, fixtures);
+
+    return (Test *)&gnrc_bp_fragment_tests;
+}
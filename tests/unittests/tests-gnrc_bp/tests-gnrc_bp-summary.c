@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "net/gnrc/bundle_protocol/bundle.h"
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+#include "net/gnrc/bundle_protocol/bundle_summary.h"
+
+#include "tests-gnrc_bp.h"
+
+/* room for the frame head in front of the bits */
+static uint8_t frame[PROCESSED_BUNDLES_BLOOM_BYTES + 8];
+
+static void _id(struct bundle_id *id, uint32_t src_num, uint32_t seq)
+{
+    memset(id, 0, sizeof(*id));
+    id->src_num = src_num;
+    id->creation_timestamp[0] = 1000;
+    id->creation_timestamp[1] = seq;
+}
+
+/* processed ids of earlier tests stay, every test uses ids of its own source */
+static void test_gnrc_bp_summary_encode_decode(void)
+{
+    struct bundle_id processed, missing;
+    const uint8_t *bits;
+    size_t bits_len;
+    bool request = false;
+    int len;
+
+    _id(&processed, 12, 1);
+    _id(&missing, 12, 2);
+    add_bundle_id_to_processed_bundle_list(&processed);
+
+    len = bundle_summary_encode(frame, sizeof(frame), true);
+    TEST_ASSERT(len > (int)PROCESSED_BUNDLES_BLOOM_BYTES);
+    TEST_ASSERT(bundle_summary_is_frame(frame, len));
+    TEST_ASSERT_EQUAL_INT(OK, bundle_summary_decode(frame, len, &request, &bits, &bits_len));
+    TEST_ASSERT(request);
+    TEST_ASSERT_EQUAL_INT(PROCESSED_BUNDLES_BLOOM_BYTES, bits_len);
+    TEST_ASSERT(bundle_storage_summary_check(bits, bits_len, &processed));
+    TEST_ASSERT(!bundle_storage_summary_check(bits, bits_len, &missing));
+}
+
+static void test_gnrc_bp_summary_no_request(void)
+{
+    const uint8_t *bits;
+    size_t bits_len;
+    bool request = true;
+    int len;
+
+    len = bundle_summary_encode(frame, sizeof(frame), false);
+    TEST_ASSERT_EQUAL_INT(OK, bundle_summary_decode(frame, len, &request, &bits, &bits_len));
+    TEST_ASSERT(!request);
+}
+
+static void test_gnrc_bp_summary_no_room(void)
+{
+    struct bundle_id processed;
+    const uint8_t *bits;
+    size_t bits_len;
+    bool request;
+    int len;
+
+    _id(&processed, 13, 1);
+    add_bundle_id_to_processed_bundle_list(&processed);
+
+    /* not even the frame head fits */
+    TEST_ASSERT_EQUAL_INT(ERROR, bundle_summary_encode(frame, 5, false));
+    /* sent with empty bits, which hold nothing */
+    len = bundle_summary_encode(frame, PROCESSED_BUNDLES_BLOOM_BYTES, false);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(OK, bundle_summary_decode(frame, len, &request, &bits, &bits_len));
+    TEST_ASSERT_EQUAL_INT(0, bits_len);
+    TEST_ASSERT(!bundle_storage_summary_check(bits, bits_len, &processed));
+}
+
+static void test_gnrc_bp_summary_check_other_size(void)
+{
+    struct bundle_id processed;
+    uint8_t bits[PROCESSED_BUNDLES_BLOOM_BYTES + 1];
+
+    _id(&processed, 14, 1);
+    add_bundle_id_to_processed_bundle_list(&processed);
+    TEST_ASSERT_EQUAL_INT(PROCESSED_BUNDLES_BLOOM_BYTES, bundle_storage_summary(bits, sizeof(bits)));
+    TEST_ASSERT(bundle_storage_summary_check(bits, PROCESSED_BUNDLES_BLOOM_BYTES, &processed));
+    /* a filter configured otherwise counts as empty */
+    memset(bits, 0xff, sizeof(bits));
+    TEST_ASSERT(!bundle_storage_summary_check(bits, sizeof(bits), &processed));
+    TEST_ASSERT_EQUAL_INT(ERROR, bundle_storage_summary(bits, PROCESSED_BUNDLES_BLOOM_BYTES - 1));
+}
+
+static void test_gnrc_bp_summary_malformed(void)
+{
+    /* an ack frame, and a summary frame cut off in its bits */
+    static const uint8_t ack[] = { 0x82, 0x00, 0x82, 0x01, 0x02 };
+    static const uint8_t cut[] = { 0x83, 0x01, 0xf4, 0x44, 0x00, 0x00 };
+    const uint8_t *bits;
+    size_t bits_len;
+    bool request;
+
+    TEST_ASSERT(!bundle_summary_is_frame(ack, sizeof(ack)));
+    TEST_ASSERT_EQUAL_INT(ERROR, bundle_summary_decode(ack, sizeof(ack), &request, &bits, &bits_len));
+    TEST_ASSERT(bundle_summary_is_frame(cut, sizeof(cut)));
+    TEST_ASSERT_EQUAL_INT(ERROR, bundle_summary_decode(cut, sizeof(cut), &request, &bits, &bits_len));
+}
+
+Test *tests_gnrc_bp_summary_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gnrc_bp_summary_encode_decode),
+        new_TestFixture(test_gnrc_bp_summary_no_request),
+        new_TestFixture(test_gnrc_bp_summary_no_room),
+        new_TestFixture(test_gnrc_bp_summary_check_other_size),
+        new_TestFixture(test_gnrc_bp_summary_malformed),
+    };
+
+    EMB_UNIT_TESTCALLER(gnrc_bp_summary_tests, NULL, NULL, fixtures);
+
+    return (Test *)&gnrc_bp_summary_tests;
+}
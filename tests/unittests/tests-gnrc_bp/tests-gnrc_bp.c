@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include "net/gnrc/bundle_protocol/bundle_storage.h"
+
+#include "tests-gnrc_bp.h"
+
+void tests_gnrc_bp(void)
+{
+    /* the store is allocated once for all parts */
+    bundle_storage_init();
+    TESTS_RUN(tests_gnrc_bp_block_pool_tests());
+    TESTS_RUN(tests_gnrc_bp_ack_tests());
+    TESTS_RUN(tests_gnrc_bp_cgr_tests());
+    TESTS_RUN(tests_gnrc_bp_summary_tests());
+    TESTS_RUN(tests_gnrc_bp_fragment_tests());
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2020 Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @addtogroup  unittests
+ * @{
+ *
+ * @file
+ * @brief       Unittests for the ``gnrc_bp`` module
+ *
+ * @author      Nishchay Agrawal <agrawal.nishchay5@gmail.com>
+ */
+#ifndef TESTS_GNRC_BP_H
+#define TESTS_GNRC_BP_H
+
+#include "embUnit.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   The entry point of this test suite.
+ */
+void tests_gnrc_bp(void);
+
+/**
+ * @brief   Generates tests for net/gnrc/bundle_protocol/bundle_block_pool.h
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gnrc_bp_block_pool_tests(void);
+
+/**
+ * @brief   Generates tests for net/gnrc/bundle_protocol/bundle_ack.h
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gnrc_bp_ack_tests(void);
+
+/**
+ * @brief   Generates tests for net/gnrc/bundle_protocol/routing_cgr.h
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gnrc_bp_cgr_tests(void);
+
+/**
+ * @brief   Generates tests for net/gnrc/bundle_protocol/bundle_summary.h
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gnrc_bp_summary_tests(void);
+
+/**
+ * @brief   Generates tests for net/gnrc/bundle_protocol/bundle_fragment.h
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gnrc_bp_fragment_tests(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_GNRC_BP_H */
+/** @} */